@@ -0,0 +1,359 @@
+// Banc de mesure minimal, sur le modèle de Google Benchmark, sans dépendance
+// externe : chaque fonction enregistrée reçoit un bench::State dont la boucle
+// tourne un nombre croissant d’itérations jusqu’à couvrir la durée minimale.
+//
+//     static void bm_lookup(bench::State &state) {
+//         table t = make_table(state.range(0));
+//         for (auto _ : state) {
+//             bench::do_not_optimize(t.find(42));
+//         }
+//         state.set_items_processed(state.iterations());
+//     }
+//     BENCHMARK(bm_lookup)->arg(1000)->arg(100000);
+//
+// Le programme accepte --filter=<regex>, --min-time=<secondes>,
+// --format=console|csv, --out=<fichier> et --list (voir bench_main.cpp).
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+// Empêche le compilateur d’éliminer le calcul de value.
+template <typename T>
+inline void do_not_optimize(T const &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static const volatile void *sink;
+    sink = static_cast<const volatile void *>(&value);
+#endif
+}
+
+// Force les écritures en mémoire en attente à être considérées comme lues.
+inline void clobber_memory() {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+class State {
+public:
+    using clock = std::chrono::steady_clock;
+
+    State(std::vector<std::int64_t> args, std::uint64_t max_iterations)
+        : _args(std::move(args)), _max_iterations(max_iterations) {}
+
+    // Itérateur de la boucle mesurée : démarre le chronomètre au premier
+    // tour et l’arrête après le dernier.
+    class iterator {
+    public:
+        // Destructeur non trivial : « for (auto _ : state) » ne déclenche
+        // pas d’avertissement de variable inutilisée
+        struct value {
+            ~value() {}
+        };
+
+        explicit iterator(State *state) : _state(state) {}
+
+        value operator*() const noexcept { return {}; }
+        iterator &operator++() noexcept {
+            ++_state->_iterations;
+            return *this;
+        }
+        bool operator!=(const iterator &) const {
+            if (_state->_iterations < _state->_max_iterations) {
+                return true;
+            }
+            _state->stop();
+            return false;
+        }
+
+    private:
+        State *_state;
+    };
+
+    iterator begin() {
+        start();
+        return iterator(this);
+    }
+    iterator end() { return iterator(this); }
+
+    // Argument n de la variante mesurée (arg() / args()).
+    std::int64_t range(std::size_t n = 0) const { return n < _args.size() ? _args[n] : 0; }
+
+    std::uint64_t iterations() const noexcept { return _iterations; }
+
+    // Exclut de la mesure ce qui s’exécute entre les deux appels (préparation
+    // à l’intérieur de la boucle).
+    void pause_timing() {
+        if (_running) {
+            _elapsed += clock::now() - _started;
+            _running = false;
+        }
+    }
+    void resume_timing() {
+        if (!_running) {
+            _started = clock::now();
+            _running = true;
+        }
+    }
+
+    // Éléments ou octets traités pendant toute la mesure ; le débit par
+    // seconde est rapporté.
+    void set_items_processed(std::uint64_t items) { _items = items; }
+    void set_bytes_processed(std::uint64_t bytes) { _bytes = bytes; }
+
+    // Valeurs libres rapportées telles quelles (dernier passage).
+    std::map<std::string, double> counters;
+
+    void set_label(std::string label) { _label = std::move(label); }
+
+    // Marque la variante comme échouée ; la boucle suivante ne fait aucun
+    // tour et le message est rapporté à la place des mesures.
+    void skip_with_error(std::string message) {
+        _error = std::move(message);
+        _max_iterations = 0;
+    }
+
+    double elapsed_seconds() const { return std::chrono::duration<double>(_elapsed).count(); }
+    std::uint64_t items_processed() const noexcept { return _items; }
+    std::uint64_t bytes_processed() const noexcept { return _bytes; }
+    const std::string &label() const noexcept { return _label; }
+    const std::string &error() const noexcept { return _error; }
+
+private:
+    void start() {
+        _iterations = 0;
+        _elapsed = clock::duration::zero();
+        resume_timing();
+    }
+    void stop() { pause_timing(); }
+
+    std::vector<std::int64_t> _args;
+    std::uint64_t             _max_iterations;
+    std::uint64_t             _iterations{0};
+    clock::time_point         _started{};
+    clock::duration           _elapsed{clock::duration::zero()};
+    bool                      _running{false};
+    std::uint64_t             _items{0};
+    std::uint64_t             _bytes{0};
+    std::string               _label;
+    std::string               _error;
+};
+
+// Fonction mesurée et ses variantes d’arguments.
+class benchmark {
+public:
+    using function = void (*)(State &);
+
+    benchmark(std::string name, function fn) : _name(std::move(name)), _fn(fn) {}
+
+    benchmark *arg(std::int64_t value) {
+        _arg_sets.push_back({value});
+        return this;
+    }
+    benchmark *args(std::initializer_list<std::int64_t> values) {
+        _arg_sets.emplace_back(values);
+        return this;
+    }
+    // Noms des arguments dans le nom rapporté (fn/entities:1000).
+    benchmark *arg_names(std::initializer_list<const char *> names) {
+        _arg_names.assign(names.begin(), names.end());
+        return this;
+    }
+    // Durée minimale propre à cette fonction (sinon celle du programme).
+    benchmark *min_time(double seconds) {
+        _min_time = seconds;
+        return this;
+    }
+    // Nombre fixe d’itérations, pour les mesures à préparation coûteuse.
+    benchmark *iterations(std::uint64_t count) {
+        _fixed_iterations = count;
+        return this;
+    }
+
+    const std::string &name() const noexcept { return _name; }
+    function fn() const noexcept { return _fn; }
+    double min_time() const noexcept { return _min_time; }
+    std::uint64_t fixed_iterations() const noexcept { return _fixed_iterations; }
+
+    // Variantes à mesurer ; une seule sans argument si aucune n’est déclarée.
+    std::vector<std::vector<std::int64_t>> arg_sets() const {
+        if (_arg_sets.empty()) {
+            return {{}};
+        }
+        return _arg_sets;
+    }
+
+    std::string variant_name(const std::vector<std::int64_t> &args) const {
+        std::string out = _name;
+        for (std::size_t i = 0; i < args.size(); ++i) {
+            out += '/';
+            if (i < _arg_names.size()) {
+                out += _arg_names[i];
+                out += ':';
+            }
+            out += std::to_string(args[i]);
+        }
+        return out;
+    }
+
+private:
+    std::string                            _name;
+    function                               _fn;
+    std::vector<std::vector<std::int64_t>> _arg_sets;
+    std::vector<std::string>               _arg_names;
+    double                                 _min_time{0.0};
+    std::uint64_t                          _fixed_iterations{0};
+};
+
+inline std::vector<std::unique_ptr<benchmark>> &registered() {
+    static std::vector<std::unique_ptr<benchmark>> all;
+    return all;
+}
+
+inline benchmark *register_benchmark(const char *name, benchmark::function fn) {
+    registered().push_back(std::make_unique<benchmark>(name, fn));
+    return registered().back().get();
+}
+
+// Résultat d’une variante.
+struct result {
+    std::string                   name;
+    std::uint64_t                 iterations{0};
+    double                        ns_per_iteration{0.0};
+    double                        items_per_second{0.0};
+    double                        bytes_per_second{0.0};
+    std::map<std::string, double> counters;
+    std::string                   label;
+    std::string                   error;
+};
+
+// Mesure une variante : double le nombre d’itérations (au plus ×10 d’après
+// la durée observée) jusqu’à atteindre min_time secondes.
+inline result run(const benchmark &b, const std::vector<std::int64_t> &args, double min_time) {
+    if (b.min_time() > 0.0) {
+        min_time = b.min_time();
+    }
+    std::uint64_t n = b.fixed_iterations() != 0 ? b.fixed_iterations() : 1;
+    result r;
+    r.name = b.variant_name(args);
+    for (;;) {
+        State state(args, n);
+        b.fn()(state);
+        const double seconds = state.elapsed_seconds();
+        const bool done = !state.error().empty() || b.fixed_iterations() != 0 || seconds >= min_time ||
+                          n >= (std::uint64_t{1} << 40);
+        if (done) {
+            r.iterations = state.iterations();
+            r.error = state.error();
+            r.label = state.label();
+            r.counters = state.counters;
+            if (r.iterations != 0 && seconds > 0.0) {
+                r.ns_per_iteration = seconds * 1e9 / static_cast<double>(r.iterations);
+                r.items_per_second = static_cast<double>(state.items_processed()) / seconds;
+                r.bytes_per_second = static_cast<double>(state.bytes_processed()) / seconds;
+            }
+            return r;
+        }
+        const double per_iteration = seconds / static_cast<double>(n);
+        double next = per_iteration > 0.0 ? min_time * 1.4 / per_iteration : static_cast<double>(n) * 10.0;
+        next = std::clamp(next, static_cast<double>(n) * 2.0, static_cast<double>(n) * 10.0);
+        n = static_cast<std::uint64_t>(next);
+    }
+}
+
+inline std::string format_time(double ns) {
+    char buf[32];
+    if (ns >= 1e9) {
+        std::snprintf(buf, sizeof(buf), "%.3f s", ns / 1e9);
+    } else if (ns >= 1e6) {
+        std::snprintf(buf, sizeof(buf), "%.3f ms", ns / 1e6);
+    } else if (ns >= 1e3) {
+        std::snprintf(buf, sizeof(buf), "%.3f us", ns / 1e3);
+    } else {
+        std::snprintf(buf, sizeof(buf), "%.2f ns", ns);
+    }
+    return buf;
+}
+
+inline std::string format_rate(double value, const char *unit) {
+    char buf[32];
+    if (value >= 1e9) {
+        std::snprintf(buf, sizeof(buf), "%.2f G%s/s", value / 1e9, unit);
+    } else if (value >= 1e6) {
+        std::snprintf(buf, sizeof(buf), "%.2f M%s/s", value / 1e6, unit);
+    } else if (value >= 1e3) {
+        std::snprintf(buf, sizeof(buf), "%.2f k%s/s", value / 1e3, unit);
+    } else {
+        std::snprintf(buf, sizeof(buf), "%.2f %s/s", value, unit);
+    }
+    return buf;
+}
+
+inline void print_console(std::ostream &out, const result &r) {
+    char head[160];
+    std::snprintf(head, sizeof(head), "%-56s %14s %12llu", r.name.c_str(), format_time(r.ns_per_iteration).c_str(),
+                  static_cast<unsigned long long>(r.iterations));
+    out << head;
+    if (!r.error.empty()) {
+        out << "  ERROR: " << r.error << '\n';
+        return;
+    }
+    if (r.items_per_second > 0.0) {
+        out << "  " << format_rate(r.items_per_second, "items");
+    }
+    if (r.bytes_per_second > 0.0) {
+        out << "  " << format_rate(r.bytes_per_second, "B");
+    }
+    for (const auto &[key, value] : r.counters) {
+        out << "  " << key << '=' << value;
+    }
+    if (!r.label.empty()) {
+        out << "  " << r.label;
+    }
+    out << '\n';
+}
+
+// Une ligne par variante ; les compteurs sont regroupés dans la dernière
+// colonne (clé=valeur séparés par des points-virgules).
+inline void print_csv_header(std::ostream &out) {
+    out << "name,iterations,ns_per_iteration,items_per_second,bytes_per_second,counters,error\n";
+}
+
+inline void print_csv(std::ostream &out, const result &r) {
+    out << '"' << r.name << "\"," << r.iterations << ',' << r.ns_per_iteration << ',' << r.items_per_second << ','
+        << r.bytes_per_second << ",\"";
+    bool first = true;
+    for (const auto &[key, value] : r.counters) {
+        out << (first ? "" : ";") << key << '=' << value;
+        first = false;
+    }
+    out << "\",\"" << r.error << "\"\n";
+}
+
+} // namespace bench
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+
+// Enregistre fn au démarrage ; les appels chaînés déclarent ses variantes.
+#define BENCHMARK(fn) \
+    [[maybe_unused]] static ::bench::benchmark *BENCH_CONCAT(bench_registered_, __LINE__) = \
+        ::bench::register_benchmark(#fn, fn)
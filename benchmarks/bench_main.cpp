@@ -0,0 +1,103 @@
+// Point d’entrée des benchmarks : exécute les fonctions enregistrées par
+// BENCHMARK() dans les autres fichiers du dossier.
+//
+//     common_libs_benchmarks [--filter=<regex>] [--min-time=<secondes>]
+//                            [--format=console|csv] [--out=<fichier>] [--list]
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <string_view>
+
+#include "bench.hpp"
+
+namespace {
+
+bool read_option(std::string_view arg, std::string_view name, std::string &value) {
+    if (arg.size() <= name.size() + 1 || arg.substr(0, name.size()) != name || arg[name.size()] != '=') {
+        return false;
+    }
+    value = std::string(arg.substr(name.size() + 1));
+    return true;
+}
+
+int usage(const char *program) {
+    std::cerr << "usage: " << program
+              << " [--filter=<regex>] [--min-time=<seconds>] [--format=console|csv] [--out=<file>] [--list]\n";
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string filter = ".*";
+    std::string format = "console";
+    std::string out_path;
+    double min_time = 0.5;
+    bool list = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        std::string value;
+        if (read_option(arg, "--filter", value)) {
+            filter = value;
+        } else if (read_option(arg, "--min-time", value)) {
+            min_time = std::atof(value.c_str());
+        } else if (read_option(arg, "--format", value) && (value == "console" || value == "csv")) {
+            format = value;
+        } else if (read_option(arg, "--out", value)) {
+            out_path = value;
+        } else if (arg == "--list") {
+            list = true;
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    std::regex pattern;
+    try {
+        pattern = std::regex(filter);
+    } catch (const std::regex_error &e) {
+        std::cerr << "invalid --filter: " << e.what() << '\n';
+        return 2;
+    }
+
+    std::ofstream file;
+    if (!out_path.empty()) {
+        file.open(out_path);
+        if (!file) {
+            std::cerr << "cannot open " << out_path << '\n';
+            return 1;
+        }
+    }
+    std::ostream &out = out_path.empty() ? std::cout : file;
+
+    if (format == "csv" && !list) {
+        bench::print_csv_header(out);
+    }
+    int failures = 0;
+    for (const auto &b : bench::registered()) {
+        for (const auto &args : b->arg_sets()) {
+            const std::string name = b->variant_name(args);
+            if (!std::regex_search(name, pattern)) {
+                continue;
+            }
+            if (list) {
+                out << name << '\n';
+                continue;
+            }
+            const bench::result r = bench::run(*b, args, min_time);
+            if (!r.error.empty()) {
+                ++failures;
+            }
+            if (format == "csv") {
+                bench::print_csv(out, r);
+            } else {
+                bench::print_console(out, r);
+            }
+            out.flush();
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,284 @@
+// Microbenchmarks de l’ECS : accès aux tableaux de composants, parcours par
+// zip à différentes densités, création/destruction d’entités et recherche
+// des tableaux dans le registre.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "ecs/ecs.hpp"
+#include "ecs/zipper.hpp"
+
+#include "bench.hpp"
+
+namespace {
+
+struct Pos {
+    float x = 0.f;
+    float y = 0.f;
+};
+
+struct Vel {
+    float x = 0.f;
+    float y = 0.f;
+};
+
+// Composant rare, stocké dans un packed_array
+struct Tag {
+    std::uint32_t value = 0;
+};
+
+// Types distincts pour remplir la table des tableaux du registre
+template <std::size_t N>
+struct Slot {
+    std::uint32_t value = 0;
+};
+
+} // namespace
+
+template <>
+struct ecs::component_storage<Tag> {
+    using type = ecs::packed_array<Tag>;
+};
+
+namespace {
+
+// Indices 0..count-1 dans un ordre pseudo-aléatoire fixe.
+std::vector<std::size_t> shuffled_indices(std::size_t count, std::uint32_t seed = 42) {
+    std::vector<std::size_t> ids(count);
+    std::iota(ids.begin(), ids.end(), std::size_t{0});
+    std::shuffle(ids.begin(), ids.end(), std::mt19937(seed));
+    return ids;
+}
+
+// Vrai pour environ percent % des indices, répartis uniformément.
+bool present(std::size_t i, std::int64_t percent) {
+    return static_cast<std::int64_t>((i * 2654435761u) % 100) < percent;
+}
+
+// -----------------------------------------------------------------------------
+// Accès indexé
+
+void bm_sparse_array_sequential(bench::State &state) {
+    const auto count = static_cast<std::size_t>(state.range(0));
+    ecs::sparse_array<Pos> positions;
+    for (std::size_t i = 0; i < count; ++i) {
+        positions.emplace_at(ecs::entity_t{i}, float(i), 1.f);
+    }
+    for (auto _ : state) {
+        float sum = 0.f;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (const auto &p = positions[ecs::entity_t{i}]) {
+                sum += p->x;
+            }
+        }
+        bench::do_not_optimize(sum);
+    }
+    state.set_items_processed(state.iterations() * count);
+}
+BENCHMARK(bm_sparse_array_sequential)->arg(1000)->arg(100000)->arg(1000000);
+
+void bm_sparse_array_random(bench::State &state) {
+    const auto count = static_cast<std::size_t>(state.range(0));
+    ecs::sparse_array<Pos> positions;
+    for (std::size_t i = 0; i < count; ++i) {
+        positions.emplace_at(ecs::entity_t{i}, float(i), 1.f);
+    }
+    const std::vector<std::size_t> order = shuffled_indices(count);
+    for (auto _ : state) {
+        float sum = 0.f;
+        for (std::size_t i : order) {
+            if (const auto &p = positions[ecs::entity_t{i}]) {
+                sum += p->x;
+            }
+        }
+        bench::do_not_optimize(sum);
+    }
+    state.set_items_processed(state.iterations() * count);
+}
+BENCHMARK(bm_sparse_array_random)->arg(1000)->arg(100000)->arg(1000000);
+
+// Lecture et écriture d’un packed_array où 10 % des indices sont présents.
+void bm_packed_array_random(bench::State &state) {
+    const auto count = static_cast<std::size_t>(state.range(0));
+    ecs::packed_array<Tag> tags;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (present(i, 10)) {
+            tags.emplace_at(ecs::entity_t{i}, static_cast<std::uint32_t>(i));
+        }
+    }
+    const std::vector<std::size_t> order = shuffled_indices(count);
+    for (auto _ : state) {
+        std::uint32_t sum = 0;
+        for (std::size_t i : order) {
+            if (auto t = tags[ecs::entity_t{i}]) {
+                sum += t->value++;
+            }
+        }
+        bench::do_not_optimize(sum);
+    }
+    state.set_items_processed(state.iterations() * count);
+}
+BENCHMARK(bm_packed_array_random)->arg(1000)->arg(100000)->arg(1000000);
+
+// -----------------------------------------------------------------------------
+// Parcours par zip : Pos présent partout, Vel sur percent % des indices
+
+struct zip_fixture {
+    ecs::sparse_array<Pos> positions;
+    ecs::sparse_array<Vel> velocities;
+    ecs::packed_array<Tag> tags;
+    std::size_t            matched = 0;
+
+    zip_fixture(std::size_t count, std::int64_t percent) {
+        for (std::size_t i = 0; i < count; ++i) {
+            positions.emplace_at(ecs::entity_t{i}, float(i), 0.f);
+            if (present(i, percent)) {
+                velocities.emplace_at(ecs::entity_t{i}, 1.f, 2.f);
+                tags.emplace_at(ecs::entity_t{i}, 1u);
+                ++matched;
+            }
+        }
+    }
+};
+
+constexpr std::size_t kZipEntities = 100000;
+
+void bm_zip(bench::State &state) {
+    zip_fixture f(kZipEntities, state.range(0));
+    for (auto _ : state) {
+        for (auto [p, v] : ecs::zip(f.positions, f.velocities)) {
+            p.x += v.x;
+            p.y += v.y;
+        }
+        bench::clobber_memory();
+    }
+    state.set_items_processed(state.iterations() * f.matched);
+}
+BENCHMARK(bm_zip)->arg_names({"density"})->arg(100)->arg(50)->arg(10)->arg(1);
+
+void bm_indexed_zip(bench::State &state) {
+    zip_fixture f(kZipEntities, state.range(0));
+    for (auto _ : state) {
+        std::size_t sum = 0;
+        for (auto [idx, p, v] : ecs::indexed_zip(f.positions, f.velocities)) {
+            p.x += v.x;
+            sum += idx;
+        }
+        bench::do_not_optimize(sum);
+    }
+    state.set_items_processed(state.iterations() * f.matched);
+}
+BENCHMARK(bm_indexed_zip)->arg_names({"density"})->arg(100)->arg(50)->arg(10)->arg(1);
+
+// Vue pilotée par le packed_array : ne visite que les entités présentes.
+void bm_views_zip_packed(bench::State &state) {
+    zip_fixture f(kZipEntities, state.range(0));
+    for (auto _ : state) {
+        for (auto [t, p] : ecs::views::zip(f.tags, f.positions)) {
+            p.x += static_cast<float>(t.value);
+        }
+        bench::clobber_memory();
+    }
+    state.set_items_processed(state.iterations() * f.matched);
+}
+BENCHMARK(bm_views_zip_packed)->arg_names({"density"})->arg(100)->arg(50)->arg(10)->arg(1);
+
+// -----------------------------------------------------------------------------
+// Registre
+
+// Population stable de range(0) entités : chaque itération détruit une
+// entité au hasard et en crée une autre avec deux composants.
+void bm_spawn_kill_churn(bench::State &state) {
+    const auto count = static_cast<std::size_t>(state.range(0));
+    ecs::registry reg;
+    reg.register_component<Pos>();
+    reg.register_component<Vel>();
+    std::vector<ecs::entity_t> alive;
+    alive.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const ecs::entity_t e = reg.spawn_entity();
+        reg.emplace_component<Pos>(e, 0.f, 0.f);
+        reg.emplace_component<Vel>(e, 1.f, 1.f);
+        alive.push_back(e);
+    }
+    std::mt19937 rng(7);
+    for (auto _ : state) {
+        const std::size_t slot = rng() % count;
+        reg.kill_entity(alive[slot]);
+        const ecs::entity_t e = reg.spawn_entity();
+        reg.emplace_component<Pos>(e, 0.f, 0.f);
+        reg.emplace_component<Vel>(e, 1.f, 1.f);
+        alive[slot] = e;
+    }
+    state.set_items_processed(state.iterations());
+    state.counters["alive"] = static_cast<double>(reg.alive_count());
+}
+BENCHMARK(bm_spawn_kill_churn)->arg(1000)->arg(100000);
+
+// Création puis destruction de range(0) entités par itération.
+void bm_spawn_kill_burst(bench::State &state) {
+    const auto count = static_cast<std::size_t>(state.range(0));
+    ecs::registry reg;
+    reg.register_component<Pos>();
+    reg.register_component<Vel>();
+    std::vector<ecs::entity_t> ents(count);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < count; ++i) {
+            ents[i] = reg.spawn_entity();
+            reg.emplace_component<Pos>(ents[i], 0.f, 0.f);
+            reg.emplace_component<Vel>(ents[i], 1.f, 1.f);
+        }
+        for (const ecs::entity_t e : ents) {
+            reg.kill_entity(e);
+        }
+    }
+    state.set_items_processed(state.iterations() * count);
+}
+BENCHMARK(bm_spawn_kill_burst)->arg(1000)->arg(100000);
+
+template <std::size_t... I>
+void register_slots(ecs::registry &reg, std::index_sequence<I...>) {
+    (reg.register_component<Slot<I>>(), ...);
+}
+
+template <std::size_t... I>
+std::size_t lookup_slots(ecs::registry &reg, std::index_sequence<I...>) {
+    return (reg.get_components<Slot<I>>().size() + ...);
+}
+
+template <std::size_t... I>
+std::size_t lookup_slots(const ecs::registry &reg, std::index_sequence<I...>) {
+    return (reg.get_components<Slot<I>>().size() + ...);
+}
+
+constexpr std::size_t kLookupTypes = 32;
+
+// 32 recherches par itération dans un registre de 32 types ; la variante
+// non const marque aussi chaque tableau comme modifié.
+void bm_get_components(bench::State &state) {
+    ecs::registry reg;
+    register_slots(reg, std::make_index_sequence<kLookupTypes>{});
+    for (auto _ : state) {
+        bench::do_not_optimize(lookup_slots(reg, std::make_index_sequence<kLookupTypes>{}));
+    }
+    state.set_items_processed(state.iterations() * kLookupTypes);
+}
+BENCHMARK(bm_get_components);
+
+void bm_get_components_const(bench::State &state) {
+    ecs::registry reg;
+    register_slots(reg, std::make_index_sequence<kLookupTypes>{});
+    const ecs::registry &view = reg;
+    for (auto _ : state) {
+        bench::do_not_optimize(lookup_slots(view, std::make_index_sequence<kLookupTypes>{}));
+    }
+    state.set_items_processed(state.iterations() * kLookupTypes);
+}
+BENCHMARK(bm_get_components_const);
+
+} // namespace
@@ -0,0 +1,270 @@
+// Macro-benchmarks du moteur : Engine::update() sur des configurations Lua
+// générées (foule de drones de 1k à 50k entités, tempête de projectiles),
+// et chargement de configuration avec ou sans cache binaire.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "engine/config_cache.hpp"
+#include "engine/engine.hpp"
+#include "engine/resources.hpp"
+
+#include "bench.hpp"
+
+namespace {
+
+constexpr float kFrame = 1.f / 60.f;
+
+// Fichier temporaire supprimé à la destruction.
+class temp_file {
+public:
+    explicit temp_file(const std::string &suffix) {
+        // Préfixe tiré une fois par processus : deux exécutions simultanées
+        // n’écrivent pas dans les mêmes fichiers
+        static const unsigned process_tag = std::random_device{}();
+        static std::atomic<unsigned> counter{0};
+        const std::string id = std::to_string(process_tag) + "_" + std::to_string(counter++);
+        _path = std::filesystem::temp_directory_path() / ("common_libs_bench_" + id + suffix);
+    }
+    ~temp_file() {
+        std::error_code ec;
+        std::filesystem::remove(_path, ec);
+    }
+    temp_file(const temp_file &) = delete;
+    temp_file &operator=(const temp_file &) = delete;
+
+    std::string path() const { return _path.string(); }
+
+    void write(const std::string &content) const {
+        std::ofstream out(_path, std::ios::binary | std::ios::trunc);
+        out << content;
+        if (!out) {
+            throw std::runtime_error("cannot write " + path());
+        }
+    }
+
+private:
+    std::filesystem::path _path;
+};
+
+// Paramètres d’une configuration synthétique.  Les tailles varient avec le
+// nombre d’entités pour garder une densité constante.
+struct scenario {
+    float half_extent = 500.f; // demi-côté de la zone peuplée
+    float turret_range = 0.f;
+    float shot_lifetime = 2.f;
+    int   extra_archetypes = 0; // archétypes supplémentaires (coût du chargement)
+};
+
+// Script Lua au format de loadGameConfig() :
+//   - player : cible immobile, pratiquement immortelle ;
+//   - drone  : se déplace selon un motif carré et cherche un joueur proche ;
+//   - turret : tire sur le joueur le plus proche ;
+//   - wall   : obstacle solide statique.
+std::string make_lua(const scenario &s) {
+    std::ostringstream lua;
+    const float world = s.half_extent + 200.f;
+    lua << "-- Configuration générée par engine_bench.cpp\n"
+        << "return {\n"
+        << "  header = {\n"
+        << "    worldBounds = { minX = " << -world << ", minY = " << -world << ", maxX = " << world
+        << ", maxY = " << world << " },\n"
+        << "    playableBounds = { minX = " << -world << ", minY = " << -world << ", maxX = " << world
+        << ", maxY = " << world << " },\n"
+        << "  },\n"
+        << "  projectiles = {\n"
+        << "    bolt = { Collision = true, Damage = true, Size = { width = 4, height = 4 } },\n"
+        << "  },\n"
+        << "  weapons = {\n"
+        << "    cannon = { rate = 2, speed = 400, lifetime = " << s.shot_lifetime
+        << ", damage = 1, projectile = \"bolt\" },\n"
+        << "  },\n"
+        << "  archetypes = {\n"
+        << "    player = {\n"
+        << "      Health = 1000000000, Collision = true, hitbox = { width = 24, height = 24 },\n"
+        << "      speed = 0, faction = 0, colliderLayer = 1, colliderMask = 8,\n"
+        << "      colliderSolid = false, colliderTrigger = true,\n"
+        << "    },\n"
+        << "    drone = {\n"
+        << "      Health = 10, Collision = true, hitbox = { width = 12, height = 12 },\n"
+        << "      speed = 30, range = 48, faction = 1, colliderLayer = 2, colliderMask = 17,\n"
+        << "      colliderSolid = false, colliderTrigger = true,\n"
+        << "      target = { order = { \"player\" }, mode = { player = \"closest\" } },\n"
+        << "      pattern = { { 20, 0 }, { 0, 20 }, { -20, 0 }, { 0, -20 } },\n"
+        << "    },\n"
+        << "    turret = {\n"
+        << "      Health = 10, Weapon = \"cannon\", range = " << s.turret_range << ", faction = 1,\n"
+        << "      colliderLayer = 2, colliderMask = 4,\n"
+        << "      target = { order = { \"player\" }, mode = { player = \"closest\" } },\n"
+        << "    },\n"
+        << "    wall = {\n"
+        << "      Health = 1000, Collision = true, hitbox = { width = 40, height = 40 },\n"
+        << "      faction = 3, colliderLayer = 16, colliderMask = 2,\n"
+        << "      colliderSolid = true, colliderTrigger = false, colliderStatic = true,\n"
+        << "    },\n";
+    for (int i = 0; i < s.extra_archetypes; ++i) {
+        lua << "    variant_" << i << " = {\n"
+            << "      Health = " << 5 + i % 7 << ", Collision = true, hitbox = { width = " << 8 + i % 5
+            << ", height = 8, offsetX = 0, offsetY = 0 },\n"
+            << "      speed = " << 10 + i % 13 << ", range = 100, Weapon = \"cannon\", faction = 1,\n"
+            << "      colliderLayer = 2, colliderMask = 5, lookDirection = { x = -1, y = 0 },\n"
+            << "      target = { order = { \"player\" }, mode = { player = \"closest\" } },\n"
+            << "      pattern = { { -10, 5 }, { -10, -5 } },\n"
+            << "    },\n";
+    }
+    lua << "  },\n"
+        << "}\n";
+    return lua.str();
+}
+
+engine::GameConfig load_scenario(const scenario &s) {
+    temp_file script(".lua");
+    script.write(make_lua(s));
+    return engine::loadGameConfig(script.path());
+}
+
+// count positions sur une grille centrée, pas spacing, en laissant libre le
+// carré central de demi-côté hole.
+std::vector<engine::Vec2> grid(std::size_t count, float spacing, float hole = 0.f) {
+    std::vector<engine::Vec2> out;
+    out.reserve(count);
+    const double hole_cells = std::pow(2.0 * hole / spacing + 1.0, 2.0);
+    const auto side = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(count) + hole_cells))) + 2;
+    const float origin = -0.5f * spacing * static_cast<float>(side - 1);
+    for (std::size_t row = 0; row < side && out.size() < count; ++row) {
+        for (std::size_t col = 0; col < side && out.size() < count; ++col) {
+            const float x = origin + spacing * static_cast<float>(col);
+            const float y = origin + spacing * static_cast<float>(row);
+            if (std::fabs(x) < hole && std::fabs(y) < hole) {
+                continue;
+            }
+            out.push_back(engine::Vec2{x, y});
+        }
+    }
+    return out;
+}
+
+// Boucle mesurée commune : warmup pas hors mesure, puis un update() de
+// 1/60 s par itération.  Rapporte les entités vivantes (fin et maximum) et
+// le nombre moyen de projectiles en vol, seuls porteurs d’un Lifetime.
+void run_updates(bench::State &state, engine::Engine &eng, std::size_t warmup) {
+    for (std::size_t i = 0; i < warmup; ++i) {
+        eng.update(kFrame);
+    }
+    const ecs::registry &reg = eng.getRegistry();
+    std::size_t peak = 0;
+    std::uint64_t entity_frames = 0;
+    std::uint64_t projectile_frames = 0;
+    for (auto _ : state) {
+        eng.update(kFrame);
+        peak = (std::max)(peak, reg.alive_count());
+        entity_frames += reg.alive_count();
+        projectile_frames += reg.get_components<engine::Lifetime>().dense_size();
+    }
+    const double frames = static_cast<double>((std::max)(state.iterations(), std::uint64_t{1}));
+    state.counters["entities"] = static_cast<double>(reg.alive_count());
+    state.counters["peak_entities"] = static_cast<double>(peak);
+    state.counters["projectiles"] = static_cast<double>(projectile_frames) / frames;
+    state.set_items_processed(entity_frames);
+}
+
+// -----------------------------------------------------------------------------
+// Foule : range(0) drones en mouvement (un mur pour 100 drones, 4 joueurs au
+// centre) ; range(1) threads.
+void bm_engine_update_crowd(bench::State &state) {
+    const auto drones = static_cast<std::size_t>(state.range(0));
+    scenario s;
+    s.half_extent = 0.5f * 24.f * std::sqrt(static_cast<float>(drones));
+    const engine::GameConfig cfg = load_scenario(s);
+
+    engine::Engine eng(cfg);
+    eng.setThreadCount(static_cast<std::size_t>(state.range(1)));
+    const std::vector<engine::Vec2> players{{-30.f, -30.f}, {30.f, -30.f}, {-30.f, 30.f}, {30.f, 30.f}};
+    eng.spawnBatch("player", players);
+    eng.spawnBatch("drone", grid(drones, 24.f, 60.f));
+    std::vector<engine::Vec2> walls = grid(drones / 100, 24.f * 10.f, 60.f);
+    for (auto &w : walls) {
+        w.x += 12.f;
+        w.y += 12.f;
+    }
+    eng.spawnBatch("wall", walls);
+    run_updates(state, eng, 10);
+}
+BENCHMARK(bm_engine_update_crowd)
+    ->arg_names({"entities", "threads"})
+    ->args({1000, 1})
+    ->args({10000, 1})
+    ->args({50000, 1})
+    ->args({10000, 4})
+    ->args({50000, 4});
+
+// Tempête : range(0) tourelles autour de 9 joueurs, deux tirs par seconde
+// chacune, en salves simultanées toutes les 30 frames.  Mesurée après deux
+// secondes, une fois le nombre de projectiles en vol stabilisé, sur
+// exactement deux cycles de salves : la frame de salve (recherche de cible
+// de toutes les tourelles) compte pour la même part dans chaque mesure.
+void bm_engine_update_projectile_storm(bench::State &state) {
+    const auto turrets = static_cast<std::size_t>(state.range(0));
+    scenario s;
+    s.half_extent = 0.5f * 16.f * std::sqrt(static_cast<float>(turrets)) + 60.f;
+    s.turret_range = 3.f * s.half_extent;
+    s.shot_lifetime = 1.5f * s.half_extent / 400.f + 0.5f;
+    const engine::GameConfig cfg = load_scenario(s);
+
+    engine::Engine eng(cfg);
+    eng.setThreadCount(static_cast<std::size_t>(state.range(1)));
+    eng.spawnBatch("player", grid(9, 30.f));
+    eng.spawnBatch("turret", grid(turrets, 16.f, 60.f));
+    run_updates(state, eng, 120);
+}
+BENCHMARK(bm_engine_update_projectile_storm)
+    ->arg_names({"turrets", "threads"})
+    ->args({100, 1})
+    ->args({1000, 1})
+    ->args({1000, 4})
+    ->args({5000, 1})
+    ->iterations(60);
+
+// -----------------------------------------------------------------------------
+// Chargement d’une configuration de range(0) archétypes : Lua à chaque fois,
+// puis depuis le cache binaire à jour.
+void bm_load_game_config(bench::State &state) {
+    scenario s;
+    s.turret_range = 300.f;
+    s.extra_archetypes = static_cast<int>(state.range(0));
+    temp_file script(".lua");
+    script.write(make_lua(s));
+    for (auto _ : state) {
+        bench::do_not_optimize(engine::loadGameConfig(script.path()));
+    }
+    state.set_items_processed(state.iterations() * static_cast<std::uint64_t>(s.extra_archetypes + 4));
+}
+BENCHMARK(bm_load_game_config)->arg_names({"archetypes"})->arg(16)->arg(256);
+
+void bm_load_game_config_cached(bench::State &state) {
+    scenario s;
+    s.turret_range = 300.f;
+    s.extra_archetypes = static_cast<int>(state.range(0));
+    temp_file script(".lua");
+    temp_file cache(".cfgbin");
+    script.write(make_lua(s));
+    engine::loadGameConfigCached(script.path(), cache.path());
+    for (auto _ : state) {
+        bench::do_not_optimize(engine::loadGameConfigCached(script.path(), cache.path()));
+    }
+    state.set_items_processed(state.iterations() * static_cast<std::uint64_t>(s.extra_archetypes + 4));
+}
+BENCHMARK(bm_load_game_config_cached)->arg_names({"archetypes"})->arg(16)->arg(256);
+
+} // namespace
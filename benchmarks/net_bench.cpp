@@ -0,0 +1,174 @@
+// Débit réseau en boucle locale : un Server et des Client du même processus
+// échangent snapshots et lots d’entrées sur 127.0.0.1.  Chaque itération
+// compte un aller-retour complet (envoi, réception, décodage, acquittement).
+//
+// Les octets ne sont comptés qu’avec COMMON_LIBS_PROFILING (net::NetStats) ;
+// sans lui, seul le nombre de snapshots ou d’entrées par seconde est rapporté.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "net/net.hpp"
+
+#include "bench.hpp"
+
+namespace {
+
+constexpr std::uint16_t kSnapshotPort = 47310;
+constexpr std::uint16_t kInputPort = 47311;
+
+// Délai après lequel un datagramme attendu est compté comme perdu.
+constexpr auto kReceiveTimeout = std::chrono::milliseconds(100);
+
+// Appelle poll() jusqu’à ce qu’il renvoie vrai ou que le délai expire.
+template <typename Poll>
+bool wait_for(Poll &&poll) {
+    const auto deadline = std::chrono::steady_clock::now() + kReceiveTimeout;
+    while (!poll()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+// Snapshot de range(0) entités à un client, dont range(1) % bougent à chaque
+// frame ; range(2) active les threads d’E/S des deux côtés.
+void bm_net_snapshot_loopback(bench::State &state) {
+    const auto count = static_cast<std::size_t>(state.range(0));
+    const auto moving = static_cast<std::size_t>(state.range(1));
+    const bool threaded = state.range(2) != 0;
+    std::unique_ptr<net::Server> server;
+    std::unique_ptr<net::Client> client;
+    try {
+        server = std::make_unique<net::Server>(kSnapshotPort, 1);
+        client = std::make_unique<net::Client>("127.0.0.1", kSnapshotPort);
+    } catch (const std::exception &e) {
+        state.skip_with_error(e.what());
+        return;
+    }
+    if (threaded) {
+        server->startIoThread();
+        client->startIoThread();
+    }
+
+    // Le client s’annonce : le serveur lui attribue le slot 0
+    net::InputPacket input{};
+    input.inputSequence = 1;
+    client->sendInput(input);
+    if (!wait_for([&] {
+            server->pollInputs();
+            return server->activeClientCount() == 1;
+        })) {
+        state.skip_with_error("client not registered");
+    }
+
+    std::vector<net::SnapshotEntity> ents(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        ents[i].id = static_cast<std::uint32_t>(i + 1);
+        ents[i].hasPosition = 1;
+        ents[i].hasVelocity = 1;
+        ents[i].x = static_cast<float>(i % 32) * 20.f;
+        ents[i].y = static_cast<float>(i / 32) * 20.f;
+        ents[i].vx = 1.f;
+    }
+    const std::vector<std::uint32_t> controlled{1};
+    net::SnapshotPacket received;
+    std::uint32_t frame = 0;
+    std::uint64_t lost = 0;
+    server->resetStats();
+    client->resetStats();
+    for (auto _ : state) {
+        ++frame;
+        for (std::size_t i = 0; i < count; ++i) {
+            if ((i * 100) / count < moving) {
+                ents[i].x += 0.5f;
+            }
+        }
+        server->broadcastSnapshot(frame, ents, controlled);
+        if (!wait_for([&] { return client->pollSnapshot(received); })) {
+            ++lost;
+        }
+        // Acquittement : le snapshot décodé devient la référence du suivant
+        input.inputSequence++;
+        client->sendInput(input);
+        server->pollInputs();
+    }
+    state.set_items_processed(state.iterations());
+    state.set_bytes_processed(client->stats().bytesIn);
+    state.counters["lost"] = static_cast<double>(lost);
+    state.counters["dropped"] = static_cast<double>(server->droppedDatagrams() + client->droppedDatagrams());
+    if (state.iterations() != 0 && client->stats().packetsIn != 0) {
+        state.counters["bytes_per_snapshot"] =
+            static_cast<double>(client->stats().bytesIn) / static_cast<double>(state.iterations());
+    }
+}
+BENCHMARK(bm_net_snapshot_loopback)
+    ->arg_names({"entities", "moving", "io_thread"})
+    ->args({64, 100, 0})
+    ->args({512, 100, 0})
+    ->args({512, 10, 0})
+    ->args({512, 0, 0})
+    ->args({512, 100, 1});
+
+// range(0) clients envoient chacun un lot d’entrées par itération ; le
+// serveur les reçoit tous avant l’itération suivante.
+void bm_net_input_loopback(bench::State &state) {
+    const auto clients = static_cast<std::size_t>(state.range(0));
+    std::unique_ptr<net::Server> server;
+    std::vector<std::unique_ptr<net::Client>> peers;
+    try {
+        server = std::make_unique<net::Server>(kInputPort, clients);
+        for (std::size_t i = 0; i < clients; ++i) {
+            peers.push_back(std::make_unique<net::Client>("127.0.0.1", kInputPort));
+        }
+    } catch (const std::exception &e) {
+        state.skip_with_error(e.what());
+        return;
+    }
+    std::uint64_t received = 0;
+    server->setCallbacks([](std::size_t, const sockaddr_in &) {},
+                         [&](std::size_t, const net::InputPacket &) { ++received; });
+
+    net::InputPacket input{};
+    std::uint32_t sequence = 1;
+    input.inputSequence = sequence;
+    for (auto &peer : peers) {
+        peer->sendInput(input);
+    }
+    if (!wait_for([&] {
+            server->pollInputs();
+            return server->activeClientCount() == clients;
+        })) {
+        state.skip_with_error("clients not registered");
+    }
+
+    std::uint64_t lost = 0;
+    for (auto _ : state) {
+        input.inputSequence = ++sequence;
+        const std::uint64_t expected = received + clients;
+        for (auto &peer : peers) {
+            peer->sendInput(input);
+        }
+        if (!wait_for([&] {
+                server->pollInputs();
+                return received >= expected;
+            })) {
+            lost += expected - received;
+            received = expected;
+        }
+    }
+    state.set_items_processed(state.iterations() * clients);
+    state.set_bytes_processed(server->stats().bytesIn);
+    state.counters["lost"] = static_cast<double>(lost);
+}
+BENCHMARK(bm_net_input_loopback)->arg_names({"clients"})->arg(1)->arg(8)->arg(32);
+
+} // namespace
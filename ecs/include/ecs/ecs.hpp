@@ -5,48 +5,70 @@
 
 #pragma once
 
-#include <any>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <new>
 #include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <tuple>
-#include <typeindex>
-#include <typeinfo>
-#include <unordered_map>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
-// Déclarations anticipées des utilitaires de zip
+#include "profiler.hpp"
+#include "thread_pool.hpp"
+
+// Déclarations anticipées des utilitaires de zip et des groupes
 namespace ecs {
 template <typename... Arrays>
 class zipper;
 template <typename... Arrays>
 class indexed_zipper;
+template <typename... Components>
+class owning_group;
 } // namespace ecs
 
 namespace ecs {
 
-// Représente une entité par un indice numérique.  Une entité vide est
-// invalide et les indices libérés sont réutilisés par le registre.
+// Représente une entité par un indice numérique et une génération.  Une entité
+// vide est invalide et les indices libérés sont réutilisés par le registre ;
+// la génération, incrémentée à chaque destruction, distingue les occupants
+// successifs d’un même indice.  Les tableaux de composants n’utilisent que
+// l’indice ; registry::is_alive() vérifie aussi la génération.
 class entity_t {
 public:
-    using value_type = std::size_t;
+    using value_type      = std::size_t;
+    using generation_type = std::uint32_t;
 
     // Constructeur par défaut : entité invalide.
-    entity_t() noexcept : _value{npos} {}
+    entity_t() noexcept : _value{npos}, _generation{0} {}
+
+    // Constructeur explicite à partir d’un indice (génération 0).
+    explicit entity_t(value_type idx) noexcept : _value{idx}, _generation{0} {}
 
-    // Constructeur explicite à partir d’un indice.
-    explicit entity_t(value_type idx) noexcept : _value{idx} {}
+    // Constructeur à partir d’un indice et d’une génération.
+    entity_t(value_type idx, generation_type gen) noexcept : _value{idx}, _generation{gen} {}
 
     // Renvoie l’indice sous‑jacent.
     value_type value() const noexcept { return _value; }
 
+    // Renvoie la génération du handle.
+    generation_type generation() const noexcept { return _generation; }
+
     // Conversion booléenne : vrai si l’entité est valide.
     explicit operator bool() const noexcept { return _value != npos; }
 
-    // Comparaison d’égalité et d’inégalité.
+    // Comparaison d’égalité et d’inégalité (indice et génération).
     friend bool operator==(entity_t const &a, entity_t const &b) noexcept {
-        return a._value == b._value;
+        return a._value == b._value && a._generation == b._generation;
     }
     friend bool operator!=(entity_t const &a, entity_t const &b) noexcept {
         return !(a == b);
@@ -54,7 +76,8 @@ public:
 
 private:
     static constexpr value_type npos = static_cast<value_type>(-1);
-    value_type _value;
+    value_type      _value;
+    generation_type _generation;
 };
 
 // Conteneur clairsemé de composants optionnels indexés par entité.
@@ -114,6 +137,15 @@ public:
         }
     }
 
+    // Réserve la place pour les indices d’entités inférieurs à n.
+    void reserve(size_type n) { _data.reserve(n); }
+
+    // Indique si l’entité possède un composant dans ce tableau.
+    bool contains(entity_t e) const noexcept {
+        size_type idx = e.value();
+        return idx < _data.size() && _data[idx].has_value();
+    }
+
     // Accès au stockage interne.
     container_type &data() noexcept { return _data; }
     const container_type &data() const noexcept { return _data; }
@@ -128,6 +160,647 @@ private:
     container_type _data;
 };
 
+namespace detail {
+    // Interface notifiée par un packed_array lorsqu’une entité gagne ou perd
+    // un composant ; implémentée par owning_group (group.hpp).
+    class group_handler {
+    public:
+        virtual ~group_handler() = default;
+        virtual void on_insert(entity_t::value_type id) = 0;
+        virtual void on_erase(entity_t::value_type id) = 0;
+        virtual void on_clear() = 0;
+        // Les tableaux ont été remplacés en bloc (registry::restore_state()).
+        virtual void on_restore() = 0;
+    };
+
+    // Lien vers le groupe propriétaire ; une copie de tableau n’est rattachée à aucun groupe.
+    struct group_link {
+        group_handler *ptr = nullptr;
+        group_link() = default;
+        group_link(group_link const &) noexcept {}
+        group_link &operator=(group_link const &) noexcept { return *this; }
+    };
+} // namespace detail
+
+// Conteneur compact (« sparse set ») : un index clairsemé associe chaque entité
+// à une case d’un tableau dense qui ne contient que des composants présents,
+// accompagnés de l’indice de leur entité propriétaire.  L’itération ne parcourt
+// que les composants vivants ; l’accès par entité coûte une indirection.
+// L’interface reprend celle de sparse_array : operator[] renvoie une option,
+// vide si l’entité ne possède pas le composant.  La suppression déplace le
+// dernier élément dense dans la case libérée, l’ordre dense n’est donc pas
+// l’ordre des indices.
+template <typename Component>
+class packed_array {
+public:
+    using value_type           = std::optional<Component>;
+    using reference_type       = value_type &;
+    using const_reference_type = value_type const &;
+    using container_type       = std::vector<value_type>;
+    using size_type            = typename container_type::size_type;
+    using index_type           = entity_t::value_type;
+
+    // Case renvoyée par l’accès en écriture.  Elle se lit comme l’option d’un
+    // sparse_array ; affecter un composant à une case vide l’ajoute au tableau
+    // (insert_at), affecter une option vide le retire (erase).  Comme une
+    // référence, elle n’est plus valide après une insertion ou une suppression
+    // faite par un autre chemin.
+    class slot_ref {
+    public:
+        slot_ref(packed_array &array, entity_t e) noexcept
+            : _array(&array), _entity(e), _slot(array.find(e)) {}
+
+        bool has_value() const noexcept { return _slot != nullptr; }
+        explicit operator bool() const noexcept { return has_value(); }
+
+        Component &operator*() const noexcept { return **_slot; }
+        Component *operator->() const noexcept { return &**_slot; }
+        Component &value() const {
+            if (!_slot) {
+                throw std::bad_optional_access();
+            }
+            return **_slot;
+        }
+
+        // Lecture sous forme d’option, pour les fonctions qui en attendent une.
+        operator const value_type &() const noexcept { return _slot ? *_slot : empty(); }
+
+        slot_ref &operator=(const Component &c) {
+            _slot = &_array->insert_at(_entity, c);
+            return *this;
+        }
+        slot_ref &operator=(Component &&c) {
+            _slot = &_array->insert_at(_entity, std::move(c));
+            return *this;
+        }
+        slot_ref &operator=(const value_type &opt) {
+            if (opt) {
+                return *this = *opt;
+            }
+            reset();
+            return *this;
+        }
+        slot_ref &operator=(std::nullopt_t) {
+            reset();
+            return *this;
+        }
+
+        template <typename... Args>
+        Component &emplace(Args &&...args) {
+            _slot = &_array->emplace_at(_entity, std::forward<Args>(args)...);
+            return **_slot;
+        }
+
+        void reset() {
+            _array->erase(_entity);
+            _slot = nullptr;
+        }
+
+    private:
+        packed_array *_array;
+        entity_t      _entity;
+        value_type   *_slot;
+    };
+
+    packed_array() = default;
+
+    // Renvoie le nombre de cases de l’index (indice maximal + 1), comme sparse_array.
+    size_type size() const noexcept { return _sparse.size(); }
+
+    // Renvoie le nombre de composants présents (taille du tableau dense).
+    size_type dense_size() const noexcept { return _dense.size(); }
+
+    // Indique si l’entité possède un composant dans ce tableau.
+    bool contains(entity_t e) const noexcept {
+        size_type idx = e.value();
+        return idx < _sparse.size() && _sparse[idx] != npos;
+    }
+
+    // Accès en lecture ; retourne vide si l’entité n’a pas de composant.
+    const_reference_type operator[](entity_t e) const {
+        const value_type *slot = find(e);
+        return slot ? *slot : empty();
+    }
+
+    // Accès en écriture : la case renvoyée ajoute le composant quand on lui
+    // en affecte un (voir slot_ref).
+    slot_ref operator[](entity_t e) noexcept { return slot_ref(*this, e); }
+
+    // Insère ou remplace un composant à l’indice donné.
+    value_type &insert_at(entity_t e, const Component &c) {
+        bool added = !contains(e);
+        auto &slot = acquire(e);
+        slot = c;
+        return notify_insert(e, added);
+    }
+
+    value_type &insert_at(entity_t e, Component &&c) {
+        bool added = !contains(e);
+        auto &slot = acquire(e);
+        slot = std::move(c);
+        return notify_insert(e, added);
+    }
+
+    // Construit un composant en place à l’indice donné.
+    template <typename... Args>
+    value_type &emplace_at(entity_t e, Args &&...args) {
+        bool added = !contains(e);
+        auto &slot = acquire(e);
+        slot.emplace(std::forward<Args>(args)...);
+        return notify_insert(e, added);
+    }
+
+    // Supprime le composant si présent ; le dernier élément dense prend sa place.
+    void erase(entity_t e) {
+        size_type idx = e.value();
+        if (idx >= _sparse.size() || _sparse[idx] == npos) {
+            return;
+        }
+        if (_owner.ptr) {
+            _owner.ptr->on_erase(idx);
+        }
+        size_type pos  = _sparse[idx];
+        size_type last = _dense.size() - 1;
+        if (pos != last) {
+            _dense[pos]    = std::move(_dense[last]);
+            _entities[pos] = _entities[last];
+            _sparse[_entities[pos]] = pos;
+        }
+        _dense.pop_back();
+        _entities.pop_back();
+        _sparse[idx] = npos;
+    }
+
+    // Supprime tous les composants ; la capacité est conservée.
+    void clear() noexcept {
+        if (_owner.ptr) {
+            _owner.ptr->on_clear();
+        }
+        for (index_type id : _entities) {
+            _sparse[id] = npos;
+        }
+        _dense.clear();
+        _entities.clear();
+    }
+
+    // Réserve l’index pour les indices d’entités inférieurs à n.  Le tableau
+    // dense n’est pas réservé : registry::reserve() passe le nombre total
+    // d’entités, que les composants rares n’atteignent pas (voir reserve_dense).
+    void reserve(size_type n) { _sparse.reserve(n); }
+
+    // Réserve la place pour n composants présents.
+    void reserve_dense(size_type n) {
+        _dense.reserve(n);
+        _entities.reserve(n);
+    }
+
+    // Nombre de composants présents que le tableau dense peut contenir sans réallocation.
+    size_type dense_capacity() const noexcept { return _dense.capacity(); }
+
+    // Indices des entités propriétaires, dans l’ordre du tableau dense.
+    const std::vector<index_type> &entities() const noexcept { return _entities; }
+
+    // Renvoie la case dense de l’entité ; l’entité doit posséder le composant.
+    size_type index_of(entity_t e) const noexcept { return _sparse[e.value()]; }
+
+    // Échange deux cases denses (utilisé par les groupes pour aligner les tableaux).
+    void swap_dense(size_type a, size_type b) {
+        if (a == b) {
+            return;
+        }
+        std::swap(_dense[a], _dense[b]);
+        std::swap(_entities[a], _entities[b]);
+        _sparse[_entities[a]] = a;
+        _sparse[_entities[b]] = b;
+    }
+
+    // Groupe propriétaire du tableau (nullptr si aucun).
+    detail::group_handler *owner() const noexcept { return _owner.ptr; }
+    void set_owner(detail::group_handler *g) noexcept { _owner.ptr = g; }
+
+    // Accès au stockage dense.
+    container_type &data() noexcept { return _dense; }
+    const container_type &data() const noexcept { return _dense; }
+
+    // Itérateurs sur le stockage dense (toutes les options sont renseignées).
+    auto begin() noexcept { return _dense.begin(); }
+    auto end() noexcept { return _dense.end(); }
+    auto begin() const noexcept { return _dense.begin(); }
+    auto end() const noexcept { return _dense.end(); }
+
+private:
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+    static const value_type &empty() noexcept {
+        static const value_type none{};
+        return none;
+    }
+
+    // Case dense de l’entité, nullptr si elle n’a pas le composant.
+    value_type *find(entity_t e) noexcept {
+        size_type idx = e.value();
+        return idx < _sparse.size() && _sparse[idx] != npos ? &_dense[_sparse[idx]] : nullptr;
+    }
+    const value_type *find(entity_t e) const noexcept {
+        size_type idx = e.value();
+        return idx < _sparse.size() && _sparse[idx] != npos ? &_dense[_sparse[idx]] : nullptr;
+    }
+
+    // Renvoie la case dense de l’entité, en la créant (vide) si nécessaire.
+    value_type &acquire(entity_t e) {
+        size_type idx = e.value();
+        if (idx >= _sparse.size()) {
+            _sparse.resize(idx + 1, npos);
+        }
+        if (_sparse[idx] == npos) {
+            _sparse[idx] = _dense.size();
+            _dense.emplace_back();
+            _entities.push_back(idx);
+        }
+        return _dense[_sparse[idx]];
+    }
+
+    // Prévient le groupe propriétaire d’un ajout ; celui‑ci peut déplacer la
+    // case, qui est donc relue après la notification.
+    value_type &notify_insert(entity_t e, bool added) {
+        if (added && _owner.ptr) {
+            _owner.ptr->on_insert(e.value());
+        }
+        return _dense[_sparse[e.value()]];
+    }
+
+    // Indice dense par entité (npos si absent).
+    std::vector<size_type>  _sparse;
+    // Composants présents, contigus.
+    container_type          _dense;
+    // Entité propriétaire de chaque case dense.
+    std::vector<index_type> _entities;
+    // Groupe propriétaire éventuel.
+    detail::group_link      _owner;
+};
+
+// Choix du stockage par type de composant.  Par défaut un sparse_array ;
+// spécialiser ce modèle pour sélectionner packed_array sur les composants
+// portés par peu d’entités :
+//
+//     template <> struct ecs::component_storage<Projectile> {
+//         using type = ecs::packed_array<Projectile>;
+//     };
+//
+// La spécialisation doit être visible avant toute utilisation du type dans le registre.
+template <typename Component>
+struct component_storage {
+    using type = sparse_array<Component>;
+};
+
+template <typename Component>
+using storage_t = typename component_storage<Component>::type;
+
+namespace detail {
+    // Familles d’identifiants de types : composants et groupes.
+    struct component_family {};
+    struct group_family {};
+
+    // Identifiants denses attribués par famille, au premier usage de chaque
+    // type (0, 1, 2…) ; ils indexent directement les tables du registre.
+    template <typename Family>
+    std::size_t next_type_id() noexcept {
+        static std::atomic<std::size_t> next{0};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    template <typename Family, typename T>
+    std::size_t type_id() noexcept {
+        static const std::size_t id = next_type_id<Family>();
+        return id;
+    }
+} // namespace detail
+
+// Identifiant dense d’un type de composant, commun à tous les registres.
+template <typename Component>
+std::size_t component_id() noexcept {
+    return detail::type_id<detail::component_family, std::remove_cv_t<Component>>();
+}
+
+class registry;
+
+// Tampon de commandes structurelles différées.  Un système enregistre pendant
+// son exécution les créations, destructions, ajouts et retraits de composants ;
+// ils sont appliqués au registre par flush(), à un point de synchronisation
+// (après chaque système dans run_systems(), ou explicitement).  Les tableaux
+// parcourus ne sont donc ni réalloués ni réordonnés pendant l’itération.
+//
+// spawn() renvoie un handle provisoire, utilisable uniquement dans les
+// commandes du même tampon ; il est remplacé par l’entité réelle au flush.
+// Les commandes visant un handle périmé sont ignorées.  Les commandes sont
+// stockées dans des blocs réutilisés : après quelques frames, enregistrer et
+// appliquer ne provoque plus d’allocation.  Un tampon n’est pas partagé entre
+// threads ; le registre en fournit un par emplacement (voir registry::commands).
+class command_buffer {
+public:
+    // Génération réservée aux handles provisoires ; jamais attribuée par le registre.
+    static constexpr entity_t::generation_type pending_generation =
+        std::numeric_limits<entity_t::generation_type>::max();
+
+    command_buffer() = default;
+    command_buffer(command_buffer &&) noexcept = default;
+    command_buffer &operator=(command_buffer &&) noexcept = default;
+    command_buffer(command_buffer const &) = delete;
+    command_buffer &operator=(command_buffer const &) = delete;
+    ~command_buffer() { clear(); }
+
+    // Enregistre la création d’une entité et renvoie son handle provisoire.
+    entity_t spawn() {
+        push<spawn_cmd>(&apply_spawn);
+        ++_structural;
+        return entity_t{_pending++, pending_generation};
+    }
+
+    // Enregistre la création d’une entité portant les composants donnés, en une
+    // seule commande (copie d’un gabarit par exemple) ; renvoie le handle provisoire.
+    template <typename... Components>
+    entity_t spawn_with(Components &&...components) {
+        using payload = spawn_with_cmd<std::remove_cv_t<std::remove_reference_t<Components>>...>;
+        push<payload>(&apply_spawn_with<std::remove_cv_t<std::remove_reference_t<Components>>...>,
+                      std::forward<Components>(components)...);
+        ++_structural;
+        return entity_t{_pending++, pending_generation};
+    }
+
+    // Enregistre la destruction d’une entité.
+    void kill(entity_t e) {
+        push<entity_cmd>(&apply_kill, e);
+        ++_structural;
+    }
+
+    // Enregistre la construction d’un composant pour une entité.
+    template <typename Component, typename... Args>
+    void emplace_component(entity_t e, Args &&...args) {
+        push<component_cmd<Component>>(&apply_emplace<Component>, e, std::forward<Args>(args)...);
+    }
+
+    // Enregistre l’ajout d’un composant à une entité.
+    template <typename Component>
+    void add_component(entity_t e, Component &&c) {
+        using C = std::remove_cv_t<std::remove_reference_t<Component>>;
+        push<component_cmd<C>>(&apply_emplace<C>, e, std::forward<Component>(c));
+    }
+
+    // Enregistre le retrait d’un composant.
+    template <typename Component>
+    void remove_component(entity_t e) {
+        push<entity_cmd>(&apply_remove<Component>, e);
+    }
+
+    // Nombre de commandes en attente.
+    std::size_t size() const noexcept { return _count; }
+    bool empty() const noexcept { return _count == 0; }
+
+    // Vrai si le tampon contient des créations ou destructions d’entités.
+    bool has_structural() const noexcept { return _structural != 0; }
+
+    // Applique les commandes dans l’ordre d’enregistrement puis vide le tampon.
+    inline void flush(registry &r);
+
+    // Déplace les commandes de other à la suite de celles-ci et vide other.
+    // Les handles provisoires de other sont renumérotés pour ce tampon.
+    void append(command_buffer &other) {
+        const entity_t::value_type offset = _pending;
+        other.for_each_record([&](header &h) {
+            header *dst = ::new (allocate(h.size)) header{h.apply, h.destroy, h.relocate, h.size};
+            h.relocate(payload_of(*dst), payload_of(h), offset);
+        });
+        _pending += other._pending;
+        _structural += other._structural;
+        other.reset();
+    }
+
+    // Abandonne les commandes en attente ; les blocs sont conservés.
+    void clear() noexcept {
+        for_each_record([](header &h) {
+            if (h.destroy) {
+                h.destroy(payload_of(h));
+            }
+        });
+        reset();
+    }
+
+private:
+    static constexpr std::size_t block_size = 16 * 1024;
+    static constexpr std::size_t align = alignof(std::max_align_t);
+
+    struct header {
+        void (*apply)(command_buffer &, registry &, void *);
+        void (*destroy)(void *);
+        // Déplace la charge vers dst (détruit la source) en décalant ses handles provisoires.
+        void (*relocate)(void *dst, void *src, entity_t::value_type offset);
+        std::size_t size;
+    };
+
+    // Vide les blocs sans détruire les charges (déjà détruites ou déplacées).
+    void reset() noexcept {
+        for (auto &b : _blocks) {
+            b.used = 0;
+        }
+        _current = 0;
+        _count = 0;
+        _structural = 0;
+        _pending = 0;
+        _spawned.clear();
+    }
+
+    struct block {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t capacity = 0;
+        std::size_t used = 0;
+    };
+
+    struct spawn_cmd {};
+    template <typename... Components>
+    struct spawn_with_cmd {
+        std::tuple<Components...> values;
+        template <typename... Args>
+        explicit spawn_with_cmd(Args &&...args) : values(std::forward<Args>(args)...) {}
+    };
+    struct entity_cmd {
+        entity_t ent;
+    };
+    template <typename Component>
+    struct component_cmd {
+        entity_t  ent;
+        Component value;
+        template <typename... Args>
+        explicit component_cmd(entity_t e, Args &&...args)
+            : ent(e), value(std::forward<Args>(args)...) {}
+    };
+
+    static constexpr std::size_t aligned(std::size_t n) { return (n + align - 1) / align * align; }
+
+    static void *payload_of(header &h) {
+        return reinterpret_cast<std::byte *>(&h) + aligned(sizeof(header));
+    }
+
+    // Réserve un enregistrement de need octets dans le bloc courant (ou le suivant).
+    void *allocate(std::size_t need) {
+        while (_current < _blocks.size() &&
+               _blocks[_current].capacity - _blocks[_current].used < need) {
+            ++_current;
+        }
+        if (_current == _blocks.size()) {
+            block b;
+            b.capacity = (std::max)(block_size, need);
+            b.data.reset(new std::byte[b.capacity]);
+            _blocks.push_back(std::move(b));
+        }
+        block &b = _blocks[_current];
+        void *at = b.data.get() + b.used;
+        b.used += need;
+        ++_count;
+        return at;
+    }
+
+    // Construit un enregistrement.
+    template <typename Payload, typename... Args>
+    void push(void (*apply)(command_buffer &, registry &, void *), Args &&...args) {
+        static_assert(alignof(Payload) <= align, "command payload over-aligned");
+        std::size_t need = aligned(sizeof(header)) + aligned(sizeof(Payload));
+        auto *h = ::new (allocate(need)) header{apply, nullptr, &relocate_payload<Payload>, need};
+        ::new (payload_of(*h)) Payload{std::forward<Args>(args)...};
+        if constexpr (!std::is_trivially_destructible_v<Payload>) {
+            h->destroy = [](void *p) { static_cast<Payload *>(p)->~Payload(); };
+        }
+    }
+
+    template <typename Payload>
+    static void relocate_payload(void *dst, void *src, entity_t::value_type offset) {
+        auto *from = static_cast<Payload *>(src);
+        auto *to = ::new (dst) Payload(std::move(*from));
+        from->~Payload();
+        if constexpr (requires { to->ent; }) {
+            if (to->ent.generation() == pending_generation) {
+                to->ent = entity_t{to->ent.value() + offset, pending_generation};
+            }
+        }
+    }
+
+    template <typename Function>
+    void for_each_record(Function &&fn) {
+        for (auto &b : _blocks) {
+            std::size_t off = 0;
+            while (off < b.used) {
+                auto *h = std::launder(reinterpret_cast<header *>(b.data.get() + off));
+                off += h->size;
+                fn(*h);
+            }
+        }
+    }
+
+    // Remplace un handle provisoire par l’entité créée au flush.
+    entity_t resolve(entity_t e) const {
+        if (e.generation() == pending_generation) {
+            return e.value() < _spawned.size() ? _spawned[e.value()] : entity_t{};
+        }
+        return e;
+    }
+
+    inline static void apply_spawn(command_buffer &self, registry &r, void *);
+    template <typename... Components>
+    static void apply_spawn_with(command_buffer &self, registry &r, void *p);
+    inline static void apply_kill(command_buffer &self, registry &r, void *p);
+    template <typename Component>
+    static void apply_emplace(command_buffer &self, registry &r, void *p);
+    template <typename Component>
+    static void apply_remove(command_buffer &self, registry &r, void *p);
+
+    std::vector<block>    _blocks;
+    std::size_t           _current{0};
+    std::size_t           _count{0};
+    std::size_t           _structural{0};
+    entity_t::value_type  _pending{0};
+    // Entités réelles des handles provisoires, remplies pendant le flush.
+    std::vector<entity_t> _spawned;
+};
+
+// Marqueur des systèmes structurels, passé en premier argument à add_system :
+// ces systèmes créent ou détruisent des entités et servent de barrière pour
+// l’ordonnanceur parallèle.
+struct structural_t {
+    explicit structural_t() = default;
+};
+inline constexpr structural_t structural{};
+
+namespace detail {
+    // Déclaration d’accès d’un système : `const T&` en lecture, `T&` (ou `T`)
+    // en écriture.
+    template <typename Access>
+    using component_of_t = std::remove_cv_t<std::remove_reference_t<Access>>;
+
+    template <typename Access>
+    inline constexpr bool is_read_access_v = std::is_const_v<std::remove_reference_t<Access>>;
+
+    // Tableau transmis au système : const pour un accès en lecture.
+    template <typename Access>
+    using access_storage_t = std::conditional_t<is_read_access_v<Access>,
+                                                const storage_t<component_of_t<Access>>,
+                                                storage_t<component_of_t<Access>>>;
+
+    // Tampon de commandes lié au thread courant pendant l’exécution d’un système.
+    struct command_binding {
+        const registry *owner = nullptr;
+        command_buffer *buffer = nullptr;
+        // Tableaux marqués par la tâche, appliqués par le thread pilote
+        std::vector<std::size_t> *marks = nullptr;
+        // Écritures déclarées du système en cours (nul hors système)
+        const std::vector<std::size_t> *writes = nullptr;
+    };
+} // namespace detail
+
+// État complet d’un registre (entités et tableaux de composants), capturé par
+// registry::save_state() et rétabli par registry::restore_state().  Les copies
+// sont partagées : un tableau inchangé depuis la capture précédente n’est pas
+// recopié, la capture le partage avec elle.  Un état se copie donc à faible
+// coût et reste valide tant que son registre existe.
+class registry_state {
+public:
+    bool empty() const noexcept { return _owner == nullptr; }
+
+    // Nombre de tableaux copiés par la capture ; les autres sont partagés.
+    std::size_t copied_arrays() const noexcept { return _copied; }
+
+    // Nombre de tableaux de composants capturés.
+    std::size_t array_count() const noexcept { return _arrays.size(); }
+
+    // Oublie la capture et libère les copies qui ne sont plus partagées.
+    void clear() noexcept {
+        _owner = nullptr;
+        _entities.reset();
+        _arrays.clear();
+        _copied = 0;
+    }
+
+private:
+    friend class registry;
+
+    struct entity_tables {
+        std::vector<bool>                         alive;
+        std::vector<entity_t::generation_type>    generations;
+        std::vector<entity_t::value_type>         free_ids;
+    };
+    // Copie d’un tableau et version du tableau au moment de la capture.
+    struct array_copy {
+        std::size_t           id = 0;
+        std::uint64_t         version = 0;
+        std::shared_ptr<void> data;
+    };
+
+    const registry               *_owner = nullptr;
+    std::shared_ptr<entity_tables> _entities;
+    std::uint64_t                 _entities_version = 0;
+    // Dans l’ordre d’enregistrement des types
+    std::vector<array_copy>       _arrays;
+    std::size_t                   _copied = 0;
+};
+
 // Registre central : gère les entités, les composants et les systèmes.
 class registry {
 public:
@@ -136,87 +809,168 @@ public:
     registry() = default;
 
     // Crée une nouvelle entité ; réutilise un indice libre si possible.
+    // Le handle renvoyé porte la génération courante de l’indice.
     entity_type spawn_entity() {
         if (!_free_ids.empty()) {
             auto id = _free_ids.back();
             _free_ids.pop_back();
             if (id >= _alive.size()) {
                 _alive.resize(id + 1, true);
+                _generations.resize(id + 1, 0);
             } else {
                 _alive[id] = true;
             }
-            return entity_type{id};
+            _entities_version = ++_version_clock;
+            return entity_type{id, _generations[id]};
         }
         auto id = static_cast<entity_type::value_type>(_alive.size());
         _alive.push_back(true);
-        return entity_type{id};
+        _generations.push_back(0);
+        _entities_version = ++_version_clock;
+        return entity_type{id, 0};
     }
 
-    // Supprime une entité et recycle son indice ; efface ses composants.
+    // Nombre d’indices d’entités attribués, vivants ou libres (indice maximal + 1).
+    std::size_t index_count() const noexcept { return _alive.size(); }
+
+    // Nombre d’entités vivantes.
+    std::size_t alive_count() const noexcept { return _alive.size() - _free_ids.size(); }
+
+    // Nombre d’indices de la dernière réservation (voir reserve).
+    std::size_t capacity() const noexcept { return _reserved; }
+
+    // Réserve en une fois la place pour count indices d’entités dans le
+    // registre et dans chaque tableau de composants enregistré, avant une
+    // création en masse par exemple.  Pour un packed_array seul l’index est
+    // réservé ; la partie dense se réserve par type (reserve_dense).  Sans
+    // effet si count ne dépasse pas capacity().
+    void reserve(std::size_t count) {
+        if (count <= _reserved) {
+            return;
+        }
+        _reserved = count;
+        _alive.reserve(count);
+        _generations.reserve(count);
+        for (std::size_t id : _registered) {
+            storage_slot &slot = _storages[id];
+            slot.reserve(slot.data.get(), count);
+        }
+    }
+
+    // Supprime une entité et recycle son indice ; efface ses composants.  Sans
+    // effet si le handle est périmé (génération différente) ou déjà détruit.
+    // La génération de l’indice est incrémentée, invalidant les handles existants.
     void kill_entity(entity_type e) {
-        auto id = e.value();
-        if (id >= _alive.size() || !_alive[id]) {
+        if (!is_alive(e)) {
             return;
         }
+        auto id = e.value();
         _alive[id] = false;
-        for (auto &erase_fn : _erasers) {
-            erase_fn(*this, e);
+        // La génération réservée aux handles provisoires est sautée
+        if (++_generations[id] == command_buffer::pending_generation) {
+            _generations[id] = 0;
+        }
+        for (std::size_t cid : _registered) {
+            storage_slot &slot = _storages[cid];
+            if (slot.erase(slot.data.get(), e)) {
+                mark_modified(cid);
+            }
         }
         _free_ids.push_back(id);
+        _entities_version = ++_version_clock;
+    }
+
+    // Vrai si le handle désigne une entité vivante de la même génération.
+    bool is_alive(entity_type e) const noexcept {
+        auto id = e.value();
+        return id < _alive.size() && _alive[id] && _generations[id] == e.generation();
+    }
+
+    // Renvoie le handle courant (avec sa génération) de l’entité d’indice donné,
+    // par exemple lors d’un parcours de tableau ; l’indice doit être vivant pour
+    // que le handle le soit.
+    entity_type entity_from_index(entity_type::value_type id) const noexcept {
+        return entity_type{id, id < _generations.size() ? _generations[id] : 0};
     }
 
     // Enregistre un type de composant et renvoie son tableau ; le crée si nécessaire.
+    // Le type de tableau est choisi par component_storage<Component>.
     template <typename Component>
-    sparse_array<Component> &register_component() {
-        std::type_index ti{typeid(Component)};
-        auto it = _components.find(ti);
-        if (it == _components.end()) {
-            auto [iter, _] =
-                _components.emplace(ti, std::any(sparse_array<Component>{}));
-            // crée une fonction d’effacement capturant l’identifiant du type
-            _erasers.emplace_back([](registry &r, entity_type ent) {
-                r.template get_components<Component>().erase(ent);
-            });
-            return std::any_cast<sparse_array<Component> &>(iter->second);
+    storage_t<Component> &register_component() {
+        using array_type = storage_t<Component>;
+        const std::size_t id = component_id<Component>();
+        if (id >= _storages.size()) {
+            _storages.resize(id + 1);
         }
-        return std::any_cast<sparse_array<Component> &>(it->second);
+        storage_slot &slot = _storages[id];
+        if (!slot.data) {
+            slot.data = storage_ptr(new array_type{}, [](void *p) { delete static_cast<array_type *>(p); });
+            slot.erase = [](void *p, entity_type ent) {
+                auto *arr = static_cast<array_type *>(p);
+                if (!arr->contains(ent)) {
+                    return false;
+                }
+                arr->erase(ent);
+                return true;
+            };
+            slot.reserve = [](void *p, std::size_t n) { static_cast<array_type *>(p)->reserve(n); };
+            slot.clone = [](const void *p) -> std::shared_ptr<void> {
+                return std::make_shared<array_type>(*static_cast<const array_type *>(p));
+            };
+            slot.assign = [](void *dst, const void *src) {
+                *static_cast<array_type *>(dst) = *static_cast<const array_type *>(src);
+            };
+            slot.version = ++_version_clock;
+            slot.handed_out = HANDED_OUT_SAVES;
+            _registered.push_back(id);
+        }
+        return *static_cast<array_type *>(slot.data.get());
     }
 
-    // Renvoie le tableau du composant ; l’enregistre au besoin.
+    // Renvoie le tableau du composant ; l’enregistre au besoin.  Une fois le
+    // type enregistré, l’accès est une lecture indexée par component_id().
+    // L’accès non const marque le tableau comme modifié pour save_state() :
+    // après une capture, reprendre le tableau avant d’y écrire de nouveau.
+    // Ce marquage (touch() : version du tableau et de son groupe, ou file de
+    // la tâche sur le pool) fait de l’accès plus qu’une lecture indexée :
+    // obtenir le tableau une fois, hors des boucles.  Pour une simple
+    // lecture, préférer la version const.  Dans un système
+    // exécuté sur le pool, utiliser les tableaux reçus en paramètres : un
+    // tableau non déclaré en écriture est signalé par assert (builds de
+    // debug).
     template <typename Component>
-    sparse_array<Component> &get_components() {
-        std::type_index ti{typeid(Component)};
-        auto it = _components.find(ti);
-        if (it == _components.end()) {
-            return register_component<Component>();
+    storage_t<Component> &get_components() {
+        const std::size_t id = component_id<Component>();
+        if (id < _storages.size() && _storages[id].data) {
+            touch(id);
+            return *static_cast<storage_t<Component> *>(_storages[id].data.get());
         }
-        return std::any_cast<sparse_array<Component> &>(it->second);
+        return register_component<Component>();
     }
 
     // Version const de get_components().
     template <typename Component>
-    const sparse_array<Component> &get_components() const {
-        std::type_index ti{typeid(Component)};
-        auto it = _components.find(ti);
-        if (it == _components.end()) {
-            static const sparse_array<Component> empty{};
-            return empty;
+    const storage_t<Component> &get_components() const {
+        const std::size_t id = component_id<Component>();
+        if (id < _storages.size() && _storages[id].data) {
+            return *static_cast<const storage_t<Component> *>(_storages[id].data.get());
         }
-        return std::any_cast<const sparse_array<Component> &>(it->second);
+        static const storage_t<Component> empty{};
+        return empty;
     }
 
     // Ajoute un composant à une entité.
     template <typename Component>
-    typename sparse_array<Component>::reference_type add_component(entity_type e,
-                                                                   Component &&c) {
+    typename storage_t<Component>::reference_type add_component(entity_type e,
+                                                                Component &&c) {
         auto &arr = get_components<Component>();
         return arr.insert_at(e, std::forward<Component>(c));
     }
 
     // Construit un composant en place pour une entité.
     template <typename Component, typename... Args>
-    typename sparse_array<Component>::reference_type emplace_component(entity_type e,
-                                                                      Args &&...args) {
+    typename storage_t<Component>::reference_type emplace_component(entity_type e,
+                                                                   Args &&...args) {
         auto &arr = get_components<Component>();
         return arr.emplace_at(e, std::forward<Args>(args)...);
     }
@@ -228,35 +982,635 @@ public:
         arr.erase(e);
     }
 
+    // Renvoie le groupe qui possède les tableaux des composants donnés ; il est
+    // créé au premier appel (définition dans group.hpp).  Tous les composants
+    // doivent utiliser packed_array.  Lève std::logic_error si l’un des tableaux
+    // appartient déjà à un autre groupe.  Comme get_components(), chaque appel
+    // marque les tableaux du groupe comme modifiés.
+    template <typename... Components>
+    owning_group<Components...> &group() {
+        const std::size_t id = detail::type_id<detail::group_family, owning_group<Components...>>();
+        if (id < _group_index.size() && _group_index[id]) {
+            // Obtenir le groupe depuis un système est permis : pas de contrôle
+            (touch(component_id<Components>(), false), ...);
+            return static_cast<owning_group<Components...> &>(*_group_index[id]);
+        }
+        auto g = std::make_unique<owning_group<Components...>>(*this, get_components<Components>()...);
+        // Un ajout ou une suppression sur l’un des tableaux déplace des cases
+        // des autres : ils sont marqués ensemble
+        const std::size_t ids[] = {component_id<Components>()...};
+        for (std::size_t a : ids) {
+            for (std::size_t b : ids) {
+                if (a != b) {
+                    _storages[a].linked.push_back(b);
+                }
+            }
+        }
+        auto &ref = *g;
+        if (id >= _group_index.size()) {
+            _group_index.resize(id + 1, nullptr);
+        }
+        _group_index[id] = g.get();
+        _groups.push_back(std::move(g));
+        return ref;
+    }
+
     // Enregistre un système ; l’ordre d’enregistrement définit l’ordre d’exécution.
+    // Chaque paramètre déclare un accès : `const T&` en lecture (le système
+    // reçoit un tableau const), `T&` ou `T` en écriture.  Les tableaux sont
+    // enregistrés dès maintenant.  L’ordonnanceur parallèle s’appuie sur ces
+    // déclarations : un système ne doit accéder à aucun autre tableau.
     template <typename... Components, typename Function>
     void add_system(Function &&f) {
-        auto wrapper = [fn = std::forward<Function>(f)](registry &r) {
-            fn(r, r.template get_components<Components>()...);
-        };
-        _systems.emplace_back(std::move(wrapper));
+        add_system_entry<Components...>(false, {}, std::forward<Function>(f));
+    }
+
+    // Variante nommée : le nom identifie la zone du système dans profiler()
+    // (« system N » par défaut, N étant le rang d’enregistrement).
+    template <typename... Components, typename Function>
+    void add_system(std::string_view name, Function &&f) {
+        add_system_entry<Components...>(false, name, std::forward<Function>(f));
+    }
+
+    // Enregistre un système structurel (créations ou destructions d’entités,
+    // même via le tampon de commandes) ; il s’exécute seul, après tous les
+    // systèmes enregistrés avant lui et avant tous ceux enregistrés après lui.
+    template <typename... Components, typename Function>
+    void add_system(structural_t, Function &&f) {
+        add_system_entry<Components...>(true, {}, std::forward<Function>(f));
+    }
+
+    template <typename... Components, typename Function>
+    void add_system(structural_t, std::string_view name, Function &&f) {
+        add_system_entry<Components...>(true, name, std::forward<Function>(f));
     }
 
-    // Exécute tous les systèmes enregistrés.
+    std::size_t system_count() const noexcept { return _systems.size(); }
+
+    // Nom du système de rang index (ordre d’enregistrement).
+    const std::string &system_name(std::size_t index) const { return _systems[index].name; }
+
+    // Exécute tous les systèmes enregistrés.  Sur un seul thread, les commandes
+    // différées sont appliquées après chaque système (point de synchronisation).
+    //
+    // Avec plusieurs threads (set_thread_count), les systèmes sont répartis en
+    // étapes : un système dépend de chaque système antérieur qui écrit un
+    // tableau qu’il lit ou écrit, ou qui lit un tableau qu’il écrit ; les
+    // systèmes structurels dépendent de tous les précédents.  Les systèmes
+    // d’une même étape s’exécutent en parallèle, chacun avec son propre tampon
+    // de commandes ; à la fin de l’étape, les tampons sont appliqués dans
+    // l’ordre d’enregistrement.  Le résultat est celui de l’exécution
+    // séquentielle, quel que soit le nombre de threads, à condition qu’un
+    // système non structurel ne modifie par commandes que les tableaux qu’il
+    // écrit.  Lève std::logic_error, quel que soit le nombre de threads, si
+    // un système non structurel a enregistré une création ou une destruction
+    // d’entité ; les commandes en attente de l’étape sont alors abandonnées
+    // et ses marquages appliqués, ce qui laisse le registre capturable.
+    //
+    // Avec COMMON_LIBS_PROFILING, chaque exécution de système est mesurée
+    // dans sa zone de profiler() (application des commandes exclue).
     void run_systems() {
-        for (auto &sys : _systems) {
-            sys(*this);
+        if (!_pool) {
+            for (auto &sys : _systems) {
+                mark_writes(sys);
+                // Des commandes enregistrées avant run_systems() ne sont pas
+                // imputées au système
+                const bool checked = !sys.structural && !has_structural_commands();
+                {
+                    ECS_PROFILE_SCOPE(_profiler, sys.zone);
+                    sys.run(*this);
+                }
+                if (checked && has_structural_commands()) {
+                    discard_commands();
+                    throw std::logic_error("ecs: non-structural system spawned or killed entities");
+                }
+                flush_commands();
+            }
+            return;
+        }
+        if (_schedule_dirty) {
+            build_schedule();
+        }
+        for (const auto &stage : _stages) {
+            // Marquage sur le thread appelant, avant la répartition
+            for (std::size_t id : stage) {
+                mark_writes(_systems[id]);
+            }
+            _pool->parallel_for(stage.size(), [&](std::size_t k) {
+                auto &sys = _systems[stage[k]];
+                binding_scope scope(*this, sys.commands, sys.marks, &sys.writes);
+#if defined(COMMON_LIBS_PROFILING)
+                // Le profileur n’est utilisé que depuis ce thread : les mesures
+                // du pool sont rapportées après l’étape
+                ECS_PROFILE_TRACY_ZONE(sys.name.c_str());
+                sys.started = ecs::profiler::clock::now();
+                sys.run(*this);
+                sys.finished = ecs::profiler::clock::now();
+                sys.thread = std::this_thread::get_id();
+#else
+                sys.run(*this);
+#endif
+            });
+            for (std::size_t id : stage) {
+#if defined(COMMON_LIBS_PROFILING)
+                _profiler.record(_systems[id].zone, _systems[id].started, _systems[id].finished, _systems[id].thread);
+#endif
+                merge_marks(_systems[id].marks);
+            }
+            // Contrôle avant toute application : une erreur n’applique rien
+            // de l’étape et ne laisse aucun tampon plein
+            for (std::size_t id : stage) {
+                if (!_systems[id].structural && _systems[id].commands.has_structural()) {
+                    for (std::size_t other : stage) {
+                        _systems[other].commands.clear();
+                    }
+                    discard_commands();
+                    throw std::logic_error("ecs: non-structural system spawned or killed entities");
+                }
+            }
+            for (std::size_t id : stage) {
+                auto &buf = _systems[id].commands;
+                if (!buf.empty()) {
+                    buf.flush(*this);
+                }
+            }
+            flush_commands();
+        }
+    }
+
+    // Fixe le nombre de threads de run_systems() (thread appelant compris) ;
+    // 0 ou 1 rétablit l’exécution séquentielle.  Ne pas appeler pendant
+    // run_systems().
+    void set_thread_count(std::size_t count) {
+        if (count > 1) {
+            _pool = std::make_unique<thread_pool>(count);
+        } else {
+            _pool.reset();
+        }
+    }
+
+    std::size_t thread_count() const noexcept { return _pool ? _pool->concurrency() : 1; }
+
+    // Pool de threads du registre ; nul en exécution séquentielle.
+    thread_pool *pool() noexcept { return _pool.get(); }
+
+    // Statistiques des systèmes (zones nommées comme eux) ; les utilisateurs
+    // du registre peuvent y ajouter leurs propres zones et compteurs.
+    ecs::profiler &profiler() noexcept { return _profiler; }
+    const ecs::profiler &profiler() const noexcept { return _profiler; }
+
+    // Exécute fn(i) pour i dans [0, count) sur le pool (ou séquentiellement
+    // sans pool) et attend la fin.  Chaque tâche enregistre ses commandes dans
+    // un tampon propre via commands() ; ces tampons sont ensuite ajoutés, dans
+    // l’ordre des indices, au tampon courant de l’appelant.  Les commandes
+    // sont donc dans le même ordre qu’en exécution séquentielle.
+    template <typename Function>
+    void parallel_for(std::size_t count, Function &&fn) {
+        if (!_pool || count <= 1) {
+            for (std::size_t i = 0; i < count; ++i) {
+                fn(i);
+            }
+            return;
+        }
+        command_buffer &target = commands();
+        // Les tâches héritent des écritures déclarées du système appelant
+        const std::vector<std::size_t> *writes = t_binding.owner == this ? t_binding.writes : nullptr;
+        std::vector<command_buffer> buffers(count);
+        std::vector<std::vector<std::size_t>> marks(count);
+        _pool->parallel_for(count, [&](std::size_t i) {
+            binding_scope scope(*this, buffers[i], marks[i], writes);
+            fn(i);
+        });
+        for (std::size_t i = 0; i < count; ++i) {
+            merge_marks(marks[i]);
+            if (!buffers[i].empty()) {
+                target.append(buffers[i]);
+            }
+        }
+    }
+
+    // Renvoie le tampon de commandes du système en cours sur ce thread lors
+    // d’une exécution parallèle, sinon celui de l’emplacement 0.
+    command_buffer &commands() {
+        if (t_binding.owner == this) {
+            return *t_binding.buffer;
+        }
+        return _command_buffers[0];
+    }
+
+    // Renvoie le tampon de commandes d’un emplacement (un par thread) ; par
+    // défaut un seul emplacement existe.
+    command_buffer &commands(std::size_t slot) { return _command_buffers[slot]; }
+
+    // Fixe le nombre d’emplacements de tampons (au moins un).  Les commandes en
+    // attente des emplacements supprimés sont abandonnées.
+    void resize_command_buffers(std::size_t count) {
+        _command_buffers.resize(count > 0 ? count : 1);
+    }
+
+    std::size_t command_buffer_count() const noexcept { return _command_buffers.size(); }
+
+    // -----------------------------------------------------------------
+    // Capture et restauration de l’état
+    //
+    // Chaque tableau de composants porte une version, renouvelée à chaque
+    // accès non const (get_components(), group(), ajout ou suppression de
+    // composant, destruction d’une entité qui en possède un, exécution d’un
+    // système qui le déclare en écriture).  save_state() ne copie que les
+    // tableaux dont la version a changé depuis la dernière capture ou
+    // restauration ; restore_state() ne recopie que ceux qui diffèrent de
+    // l’état rétabli.  Le coût suit donc le nombre de tableaux modifiés, et
+    // non le nombre de types enregistrés.  Un tableau remis par un accès non
+    // const peut encore être écrit par la référence obtenue : les deux
+    // captures suivantes le copient même si sa version n’a pas changé, et
+    // restore_state() le recopie jusque-là.  Une référence gardée au-delà
+    // n’est plus suivie : reprendre les tableaux après chaque capture.  Les
+    // tampons de commandes doivent être vides (std::logic_error sinon).
+    // -----------------------------------------------------------------
+
+    // Capture l’état courant dans out.  Les copies de out que plus aucun
+    // autre état ne partage sont réutilisées sans allocation : réécrire les
+    // états d’un tampon circulaire ne coûte que les copies elles-mêmes.
+    void save_state(registry_state &out) {
+        require_no_pending_commands();
+        if (out._owner != this) {
+            out.clear();
+            out._owner = this;
+        }
+        out._copied = 0;
+        if (!_saved_entities || _saved_entities_version != _entities_version) {
+            std::shared_ptr<registry_state::entity_tables> tables = std::move(out._entities);
+            if (!tables || tables.use_count() != (tables == _saved_entities ? 2 : 1)) {
+                tables = std::make_shared<registry_state::entity_tables>();
+            }
+            tables->alive = _alive;
+            tables->generations = _generations;
+            tables->free_ids = _free_ids;
+            _saved_entities = std::move(tables);
+            _saved_entities_version = _entities_version;
+        }
+        out._entities = _saved_entities;
+        out._entities_version = _entities_version;
+        out._arrays.resize(_registered.size());
+        for (std::size_t k = 0; k < _registered.size(); ++k) {
+            const std::size_t id = _registered[k];
+            storage_slot &slot = _storages[id];
+            registry_state::array_copy &copy = out._arrays[k];
+            if (slot.handed_out > 0) {
+                // Écrit peut-être depuis la remise : nouvelle version, pour
+                // que les restaurations d’états antérieurs le recopient
+                --slot.handed_out;
+                slot.version = ++_version_clock;
+            }
+            if (!slot.saved || slot.saved_version != slot.version) {
+                if (copy.id == id && copy.data && copy.data.use_count() == (copy.data == slot.saved ? 2 : 1)) {
+                    slot.assign(copy.data.get(), slot.data.get());
+                    slot.saved = copy.data;
+                } else {
+                    slot.saved = slot.clone(slot.data.get());
+                }
+                slot.saved_version = slot.version;
+                ++out._copied;
+            }
+            copy.id = id;
+            copy.version = slot.version;
+            copy.data = slot.saved;
+        }
+    }
+
+    // Rétablit un état capturé par save_state() sur ce registre.  Lève
+    // std::invalid_argument si l’état est vide ou vient d’un autre registre,
+    // std::logic_error si des types ont été enregistrés depuis la capture.
+    // Les groupes recalculent leur section ; les handles capturés redeviennent
+    // valides avec les générations de l’époque.
+    void restore_state(const registry_state &state) {
+        if (state._owner != this) {
+            throw std::invalid_argument("ecs: world state was not saved from this registry");
+        }
+        require_no_pending_commands();
+        bool same_types = state._arrays.size() == _registered.size();
+        for (std::size_t k = 0; same_types && k < _registered.size(); ++k) {
+            same_types = state._arrays[k].id == _registered[k];
+        }
+        if (!same_types) {
+            throw std::logic_error("ecs: component types were registered after the world state was saved");
+        }
+        if (_entities_version != state._entities_version) {
+            _alive = state._entities->alive;
+            _generations = state._entities->generations;
+            _free_ids = state._entities->free_ids;
+            _entities_version = state._entities_version;
+        }
+        _saved_entities = state._entities;
+        _saved_entities_version = state._entities_version;
+        bool restored = false;
+        for (std::size_t k = 0; k < _registered.size(); ++k) {
+            const registry_state::array_copy &copy = state._arrays[k];
+            storage_slot &slot = _storages[copy.id];
+            if (slot.version != copy.version || slot.handed_out > 0) {
+                slot.assign(slot.data.get(), copy.data.get());
+                // Contenu identique à celui de la capture : même version
+                slot.version = copy.version;
+                restored = true;
+            }
+            slot.saved = copy.data;
+            slot.saved_version = copy.version;
+        }
+        if (restored) {
+            for (auto &g : _groups) {
+                g->on_restore();
+            }
+        }
+    }
+
+    // Applique les tampons de commandes dans l’ordre des emplacements, ce qui
+    // rend le résultat indépendant de l’ordonnancement des threads.
+    void flush_commands() {
+        for (auto &buf : _command_buffers) {
+            if (!buf.empty()) {
+                buf.flush(*this);
+            }
         }
     }
 
 private:
+    // Système enregistré avec ses accès déclarés et son tampon de commandes
+    // pour l’exécution parallèle.
+    struct system_entry {
+        std::function<void(registry &)> run;
+        // Identifiants (component_id) des composants lus et écrits
+        std::vector<std::size_t>        reads;
+        std::vector<std::size_t>        writes;
+        bool                            structural = false;
+        command_buffer                  commands;
+        // Tableaux marqués pendant la dernière exécution sur le pool
+        std::vector<std::size_t>        marks;
+        std::string                     name;
+        ecs::profiler::zone_id          zone = 0;
+#if defined(COMMON_LIBS_PROFILING)
+        // Dernière exécution sur le pool
+        ecs::profiler::clock::time_point started{};
+        ecs::profiler::clock::time_point finished{};
+        std::thread::id                  thread{};
+#endif
+    };
+
+    // Lie un tampon de commandes au thread courant pour la durée d’un système.
+    class binding_scope {
+    public:
+        binding_scope(const registry &r, command_buffer &buf, std::vector<std::size_t> &marks,
+                      const std::vector<std::size_t> *writes)
+            : _saved(t_binding) {
+            t_binding = detail::command_binding{&r, &buf, &marks, writes};
+        }
+        ~binding_scope() { t_binding = _saved; }
+        binding_scope(const binding_scope &) = delete;
+        binding_scope &operator=(const binding_scope &) = delete;
+
+    private:
+        detail::command_binding _saved;
+    };
+
+    // Tableau d’un type déjà enregistré, sans marquage : les écritures des
+    // systèmes sont marquées par mark_writes() d’après leurs déclarations.
+    template <typename Component>
+    storage_t<Component> &registered_storage() noexcept {
+        return *static_cast<storage_t<Component> *>(_storages[component_id<Component>()].data.get());
+    }
+
+    // Renouvelle la version d’un tableau et des tableaux de son groupe.  Appelé
+    // seulement depuis le thread qui pilote le registre.
+    void mark_modified(std::size_t id) noexcept {
+        storage_slot &slot = _storages[id];
+        slot.version = ++_version_clock;
+        for (std::size_t other : slot.linked) {
+            _storages[other].version = _version_clock;
+        }
+    }
+
+    // Marquage demandé par get_components() ou group().  Dans une tâche du
+    // pool, il est différé : l’identifiant rejoint la liste de la tâche, que
+    // le thread pilote applique après l’étape ou après parallel_for().  Les
+    // écritures déclarées du système en cours sont déjà marquées ; checked
+    // signale par assert un tableau que le système ne déclare pas écrire.
+    void touch(std::size_t id, bool checked = true) {
+        if (t_binding.owner != this) {
+            mark_modified(id);
+            _storages[id].handed_out = HANDED_OUT_SAVES;
+            return;
+        }
+        const auto *writes = t_binding.writes;
+        const bool declared = writes && std::find(writes->begin(), writes->end(), id) != writes->end();
+        assert((!checked || !writes || declared) &&
+               "ecs: a system on the pool called non-const get_components() on an array it does not write; "
+               "use its parameters or the const overload");
+        (void)checked;
+        if (!declared) {
+            t_binding.marks->push_back(id);
+        }
+    }
+
+    void merge_marks(std::vector<std::size_t> &marks) {
+        for (std::size_t id : marks) {
+            touch(id, false);
+        }
+        marks.clear();
+    }
+
+    void mark_writes(const system_entry &sys) noexcept {
+        for (std::size_t id : sys.writes) {
+            mark_modified(id);
+        }
+    }
+
+    bool has_structural_commands() const noexcept {
+        for (const auto &buf : _command_buffers) {
+            if (buf.has_structural()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void discard_commands() noexcept {
+        for (auto &buf : _command_buffers) {
+            buf.clear();
+        }
+    }
+
+    void require_no_pending_commands() const {
+        for (const auto &buf : _command_buffers) {
+            if (!buf.empty()) {
+                throw std::logic_error("ecs: pending commands must be flushed before saving or restoring the world state");
+            }
+        }
+    }
+
+    template <typename... Components, typename Function>
+    void add_system_entry(bool is_structural, std::string_view name, Function &&f) {
+        (register_component<detail::component_of_t<Components>>(), ...);
+        system_entry entry;
+        entry.name = name.empty() ? "system " + std::to_string(_systems.size()) : std::string(name);
+        entry.zone = _profiler.zone(entry.name);
+        entry.run = [fn = std::forward<Function>(f)](registry &r) {
+            fn(r, static_cast<detail::access_storage_t<Components> &>(
+                      r.template registered_storage<detail::component_of_t<Components>>())...);
+        };
+        (declare_access<Components>(entry), ...);
+        entry.structural = is_structural;
+        _systems.push_back(std::move(entry));
+        _schedule_dirty = true;
+    }
+
+    template <typename Access>
+    static void declare_access(system_entry &entry) {
+        const std::size_t id = component_id<detail::component_of_t<Access>>();
+        if constexpr (detail::is_read_access_v<Access>) {
+            entry.reads.push_back(id);
+        } else {
+            entry.writes.push_back(id);
+        }
+    }
+
+    static bool overlaps(const std::vector<std::size_t> &a,
+                         const std::vector<std::size_t> &b) {
+        for (const auto &x : a) {
+            if (std::find(b.begin(), b.end(), x) != b.end()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool conflicts(const system_entry &a, const system_entry &b) {
+        return a.structural || b.structural || overlaps(a.writes, b.writes) ||
+               overlaps(a.writes, b.reads) || overlaps(a.reads, b.writes);
+    }
+
+    // Calcule les étapes : l’étape d’un système suit celle de tous les
+    // systèmes antérieurs avec lesquels il est en conflit (graphe de
+    // dépendances parcouru dans l’ordre d’enregistrement).
+    void build_schedule() {
+        std::vector<std::size_t> level(_systems.size(), 0);
+        std::size_t              depth = 0;
+        for (std::size_t i = 0; i < _systems.size(); ++i) {
+            for (std::size_t j = 0; j < i; ++j) {
+                if (level[j] + 1 > level[i] && conflicts(_systems[j], _systems[i])) {
+                    level[i] = level[j] + 1;
+                }
+            }
+            depth = (std::max)(depth, level[i] + 1);
+        }
+        _stages.assign(depth, {});
+        for (std::size_t i = 0; i < _systems.size(); ++i) {
+            _stages[level[i]].push_back(i);
+        }
+        _schedule_dirty = false;
+    }
+
     // Indique si un indice d’entité est vivant.  Au‑delà de la taille, les entités sont considérées mortes.
     std::vector<bool> _alive;
+    // Génération courante de chaque indice ; incrémentée à la destruction.
+    std::vector<entity_type::generation_type> _generations;
     // Liste des indices d’entités libres à réutiliser.
     std::vector<entity_type::value_type> _free_ids;
-    // Tableaux clairsemés indexés par type ; std::any permet l’effacement de type tout en conservant le conteneur.
-    std::unordered_map<std::type_index, std::any> _components;
-    // Fonctions pour effacer un composant d’une entité ; une par type de composant enregistré.
-    std::vector<std::function<void(registry &, entity_type)>> _erasers;
-    // Enveloppes de systèmes enregistrés ; elles capturent l’appelable utilisateur et extraient les composants requis à l’appel.
-    std::vector<std::function<void(registry &)>> _systems;
+    // Tableau d’un type de composant, à type effacé, avec ses opérations.
+    using storage_ptr = std::unique_ptr<void, void (*)(void *)>;
+    struct storage_slot {
+        storage_ptr data{nullptr, [](void *) {}};
+        // Vrai si l’entité possédait le composant
+        bool (*erase)(void *, entity_type) = nullptr;
+        void (*reserve)(void *, std::size_t) = nullptr;
+        std::shared_ptr<void> (*clone)(const void *) = nullptr;
+        void (*assign)(void *, const void *) = nullptr;
+        // Version courante ; dernière copie capturée (ou rétablie) et sa version
+        std::uint64_t         version = 0;
+        std::shared_ptr<void> saved;
+        std::uint64_t         saved_version = 0;
+        // Captures qui doivent encore copier le tableau quelle que soit sa
+        // version, parce qu’un accès non const l’a remis
+        std::uint8_t          handed_out = 0;
+        // Autres tableaux du même groupe
+        std::vector<std::size_t> linked;
+    };
+    // Tableaux indexés par component_id() ; vides pour les types non enregistrés.
+    std::vector<storage_slot> _storages;
+    // Identifiants des types enregistrés, dans l’ordre d’enregistrement.
+    std::vector<std::size_t> _registered;
+    std::size_t _reserved{0};
+    // Une référence obtenue juste avant une capture sert souvent encore
+    // pendant l’image suivante : elle est suivie sur deux captures.
+    static constexpr std::uint8_t HANDED_OUT_SAVES = 2;
+    // Horloge des versions (tableaux et tables d’entités) ; ne décroît jamais.
+    std::uint64_t _version_clock{0};
+    std::uint64_t _entities_version{0};
+    std::shared_ptr<registry_state::entity_tables> _saved_entities;
+    std::uint64_t _saved_entities_version{0};
+    // Groupes possédant des tableaux compacts ; alloués individuellement car les tableaux pointent vers eux.
+    std::vector<std::unique_ptr<detail::group_handler>> _groups;
+    // Groupes indexés par identifiant de groupe (nul si absent).
+    std::vector<detail::group_handler *> _group_index;
+    // Systèmes enregistrés ; leurs enveloppes capturent l’appelable utilisateur et extraient les composants requis à l’appel.
+    std::vector<system_entry> _systems;
+    // Étapes de l’exécution parallèle (indices de systèmes dans l’ordre d’enregistrement).
+    std::vector<std::vector<std::size_t>> _stages;
+    bool _schedule_dirty{true};
+    // Pool de threads de l’exécution parallèle ; nul en séquentiel.
+    std::unique_ptr<thread_pool> _pool;
+    // Tampons de commandes différées, un par emplacement.
+    std::vector<command_buffer> _command_buffers = std::vector<command_buffer>(1);
+    ecs::profiler _profiler;
+
+    inline static thread_local detail::command_binding t_binding{};
 };
 
+// -----------------------------------------------------------------------------
+// Application des commandes différées (nécessite la définition du registre).
+// -----------------------------------------------------------------------------
+
+inline void command_buffer::flush(registry &r) {
+    for_each_record([&](header &h) {
+        h.apply(*this, r, payload_of(h));
+    });
+    clear();
+}
+
+inline void command_buffer::apply_spawn(command_buffer &self, registry &r, void *) {
+    self._spawned.push_back(r.spawn_entity());
+}
+
+template <typename... Components>
+void command_buffer::apply_spawn_with(command_buffer &self, registry &r, void *p) {
+    auto *cmd = static_cast<spawn_with_cmd<Components...> *>(p);
+    entity_t ent = r.spawn_entity();
+    self._spawned.push_back(ent);
+    // Composants ajoutés dans l’ordre de la liste
+    std::apply([&](Components &...values) {
+        (r.template add_component<Components>(ent, std::move(values)), ...);
+    }, cmd->values);
+}
+
+inline void command_buffer::apply_kill(command_buffer &self, registry &r, void *p) {
+    r.kill_entity(self.resolve(static_cast<entity_cmd *>(p)->ent));
+}
+
+template <typename Component>
+void command_buffer::apply_emplace(command_buffer &self, registry &r, void *p) {
+    auto *cmd = static_cast<component_cmd<Component> *>(p);
+    entity_t ent = self.resolve(cmd->ent);
+    if (r.is_alive(ent)) {
+        r.template emplace_component<Component>(ent, std::move(cmd->value));
+    }
+}
+
+template <typename Component>
+void command_buffer::apply_remove(command_buffer &self, registry &r, void *p) {
+    entity_t ent = self.resolve(static_cast<entity_cmd *>(p)->ent);
+    if (r.is_alive(ent)) {
+        r.template remove_component<Component>(ent);
+    }
+}
+
 // Déclarations des utilitaires de zip ; les implémentations sont dans zipper.hpp.
 template <typename... Arrays>
 class zipper;
@@ -0,0 +1,173 @@
+// Groupes possédants : maintiennent alignés, en tête de plusieurs packed_array,
+// les composants des entités qui les possèdent tous.  Pour i < size(), la case
+// dense i de chaque tableau appartient à la même entité ; un système qui lit
+// ces composants parcourt donc des tableaux contigus en parallèle (SoA), sans
+// indirection ni test de présence.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "ecs/ecs.hpp" // pour packed_array et registry
+
+namespace ecs {
+
+// Groupe possédant les tableaux de Components.  Créé via registry::group<...>() ;
+// chaque packed_array ne peut appartenir qu’à un seul groupe.  Les ajouts et
+// suppressions de composants (par le registre ou directement sur les tableaux)
+// déplacent l’entité dans ou hors de la section groupée par échange de cases.
+// Ajouter ou retirer un composant groupé pendant le parcours du groupe invalide
+// l’itération.
+template <typename... Components>
+class owning_group final : public detail::group_handler {
+    static_assert(sizeof...(Components) >= 2, "owning_group requires at least two components");
+    static_assert((std::is_same_v<storage_t<Components>, packed_array<Components>> && ...),
+                  "owning_group requires packed_array storage for every component");
+
+public:
+    using index_type = entity_t::value_type;
+    using reference  = std::tuple<Components &...>;
+
+    // reg fournit les générations des handles passés à each().
+    explicit owning_group(const registry &reg, packed_array<Components> &...arrays)
+        : _registry(std::addressof(reg)), _arrays(std::addressof(arrays)...) {
+        bool owned = ((arrays.owner() != nullptr) || ...);
+        if (owned) {
+            throw std::logic_error("Component array already owned by another group");
+        }
+        (arrays.set_owner(this), ...);
+        // Regroupe les entités existantes
+        auto &lead = *std::get<0>(_arrays);
+        for (std::size_t k = 0; k < lead.dense_size(); ++k) {
+            on_insert(lead.entities()[k]);
+        }
+    }
+
+    ~owning_group() override {
+        std::apply([](auto *...arrs) { (arrs->set_owner(nullptr), ...); }, _arrays);
+    }
+
+    owning_group(owning_group const &) = delete;
+    owning_group &operator=(owning_group const &) = delete;
+
+    // Nombre d’entités possédant tous les composants.
+    std::size_t size() const noexcept { return _size; }
+
+    // Indice de l’entité en position i de la section groupée.
+    index_type entity_at(std::size_t i) const noexcept { return std::get<0>(_arrays)->entities()[i]; }
+
+    // Composant C de l’entité en position i.
+    template <typename C>
+    C &get(std::size_t i) const {
+        return *std::get<packed_array<C> *>(_arrays)->data()[i];
+    }
+
+    // Appelle fn(entity_t, Components&...) pour chaque entité du groupe, dans
+    // l’ordre des cases denses.  Le handle porte la génération courante de
+    // l’entité (registry::entity_from_index()).
+    template <typename Function>
+    void each(Function &&fn) const {
+        each(0, _size, fn);
+    }
+
+    // Variante limitée aux positions [first, last) de la section groupée.
+    template <typename Function>
+    void each(std::size_t first, std::size_t last, Function &&fn) const {
+        last = (std::min)(last, _size);
+        for (std::size_t i = first; i < last; ++i) {
+            fn(_registry->entity_from_index(entity_at(i)),
+               *std::get<packed_array<Components> *>(_arrays)->data()[i]...);
+        }
+    }
+
+    // Itérateur renvoyant un tuple de références, comme zip.
+    class iterator {
+    public:
+        using value_type        = reference;
+        using difference_type   = std::ptrdiff_t;
+        using iterator_category = std::input_iterator_tag;
+
+        iterator(owning_group const *g, std::size_t i) : _group(g), _index(i) {}
+
+        iterator &operator++() {
+            ++_index;
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+        friend bool operator==(iterator const &a, iterator const &b) { return a._index == b._index; }
+        friend bool operator!=(iterator const &a, iterator const &b) { return !(a == b); }
+        reference operator*() const { return reference{_group->template get<Components>(_index)...}; }
+
+    private:
+        owning_group const *_group;
+        std::size_t         _index;
+    };
+
+    iterator begin() const { return iterator{this, 0}; }
+    iterator end() const { return iterator{this, _size}; }
+
+    // Notifications des tableaux possédés.
+    void on_insert(index_type id) override {
+        entity_t e{id};
+        bool all = std::apply([&](auto *...arrs) { return (arrs->contains(e) && ...); }, _arrays);
+        if (!all || std::get<0>(_arrays)->index_of(e) < _size) {
+            return;
+        }
+        std::apply([&](auto *...arrs) { (arrs->swap_dense(arrs->index_of(e), _size), ...); }, _arrays);
+        ++_size;
+    }
+
+    void on_erase(index_type id) override {
+        entity_t e{id};
+        bool all = std::apply([&](auto *...arrs) { return (arrs->contains(e) && ...); }, _arrays);
+        if (!all || std::get<0>(_arrays)->index_of(e) >= _size) {
+            return;
+        }
+        --_size;
+        std::apply([&](auto *...arrs) { (arrs->swap_dense(arrs->index_of(e), _size), ...); }, _arrays);
+    }
+
+    void on_clear() override { _size = 0; }
+
+    // Les cases groupées sont toujours en tête : recompte la section.
+    void on_restore() override {
+        const auto &lead = *std::get<0>(_arrays);
+        _size = 0;
+        while (_size < lead.dense_size()) {
+            entity_t e{lead.entities()[_size]};
+            if (!std::apply([&](auto *...arrs) { return (arrs->contains(e) && ...); }, _arrays)) {
+                break;
+            }
+            ++_size;
+        }
+    }
+
+private:
+    const registry                           *_registry;
+    std::tuple<packed_array<Components> *...> _arrays;
+    std::size_t                               _size{0};
+};
+
+// Parcours parallèle d’un groupe par tranches de `grain` positions ; fn reçoit
+// (entity_t, Components&...) comme each().  Mêmes règles que le
+// parallel_for_each des vues (zipper.hpp).
+template <typename... Components, typename Function>
+void parallel_for_each(registry &r, owning_group<Components...> &g, Function &&fn, std::size_t grain = 256) {
+    grain = (std::max)(grain, std::size_t{1});
+    const std::size_t total = g.size();
+    r.parallel_for((total + grain - 1) / grain, [&](std::size_t chunk) {
+        g.each(chunk * grain, (std::min)(total, (chunk + 1) * grain), fn);
+    });
+}
+
+} // namespace ecs
@@ -0,0 +1,339 @@
+// Instrumentation : durées par zone nommée (systèmes du registre, phases du
+// moteur) et compteurs, agrégés par frame et interrogeables, avec capture
+// optionnelle au format Chrome trace (chrome://tracing, Perfetto).
+//
+// Les mesures ne sont compilées qu’avec COMMON_LIBS_PROFILING (option CMake
+// du même nom) : sans elle, les macros ECS_PROFILE_* ne produisent aucun
+// code et les statistiques restent nulles.  Avec TRACY_ENABLE en plus, les
+// zones et les frames sont aussi transmises à Tracy.
+//
+//     ecs::profiler &prof = reg.profiler();
+//     const auto zone = prof.zone("physics");
+//     ECS_PROFILE_BEGIN_FRAME(prof);
+//     {
+//         ECS_PROFILE_SCOPE(prof, zone);
+//         step_physics();
+//     }
+//     ECS_PROFILE_END_FRAME(prof);
+//     std::printf("%llu ns\n", (unsigned long long)prof.zones()[zone].last_ns);
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(COMMON_LIBS_PROFILING) && defined(TRACY_ENABLE)
+#include <tracy/Tracy.hpp>
+#endif
+
+namespace ecs {
+
+#if defined(COMMON_LIBS_PROFILING)
+inline constexpr bool profiling_enabled = true;
+#else
+inline constexpr bool profiling_enabled = false;
+#endif
+
+// Statistiques des zones et compteurs.  Les enregistrements se font depuis
+// un seul thread (celui qui pilote le registre) ; le registre rapporte
+// lui-même les durées des systèmes exécutés sur le pool.
+class profiler {
+public:
+    using clock      = std::chrono::steady_clock;
+    using zone_id    = std::size_t;
+    using counter_id = std::size_t;
+
+    struct zone_stats {
+        std::string   name;
+        // Durée cumulée sur la dernière frame terminée, et maximum par frame
+        std::uint64_t last_ns = 0;
+        std::uint64_t max_ns = 0;
+        std::uint64_t total_ns = 0;
+        std::uint64_t calls = 0;
+        // Frame en cours
+        std::uint64_t frame_ns = 0;
+    };
+
+    struct counter_stats {
+        std::string  name;
+        // Dernière valeur fixée et maximum observé
+        std::int64_t value = 0;
+        std::int64_t max = 0;
+    };
+
+    // Identifiant de la zone de ce nom, créée au premier appel.
+    zone_id zone(std::string_view name) {
+        for (std::size_t i = 0; i < _zones.size(); ++i) {
+            if (_zones[i].name == name) {
+                return i;
+            }
+        }
+        _zones.push_back(zone_stats{std::string(name)});
+        return _zones.size() - 1;
+    }
+
+    // Identifiant du compteur de ce nom, créé au premier appel.
+    counter_id counter(std::string_view name) {
+        for (std::size_t i = 0; i < _counters.size(); ++i) {
+            if (_counters[i].name == name) {
+                return i;
+            }
+        }
+        _counters.push_back(counter_stats{std::string(name)});
+        return _counters.size() - 1;
+    }
+
+    const std::string &zone_name(zone_id id) const { return _zones[id].name; }
+
+    // Début et fin d’une frame : à la fin, la durée cumulée de chaque zone
+    // sur la frame devient last_ns.
+    void begin_frame() { _frame_start = clock::now(); }
+
+    void end_frame() {
+        const auto end = clock::now();
+        _last_frame_ns = nanoseconds(_frame_start, end);
+        _max_frame_ns = (std::max)(_max_frame_ns, _last_frame_ns);
+        ++_frame_count;
+        for (auto &z : _zones) {
+            z.last_ns = z.frame_ns;
+            z.max_ns = (std::max)(z.max_ns, z.frame_ns);
+            z.frame_ns = 0;
+        }
+        if (_capturing) {
+            push_event(trace_event{trace_event::frame, 0, thread_index(std::this_thread::get_id()),
+                                   _frame_start, end, 0});
+        }
+    }
+
+    // Durée d’une exécution de la zone ; thread est celui qui l’a exécutée
+    // (pour la trace).
+    void record(zone_id id, clock::time_point start, clock::time_point end,
+                std::thread::id thread = std::this_thread::get_id()) {
+        const std::uint64_t ns = nanoseconds(start, end);
+        zone_stats &z = _zones[id];
+        z.frame_ns += ns;
+        z.total_ns += ns;
+        ++z.calls;
+        if (_capturing) {
+            push_event(trace_event{trace_event::zone, id, thread_index(thread), start, end, 0});
+        }
+    }
+
+    void set_counter(counter_id id, std::int64_t value) {
+        counter_stats &c = _counters[id];
+        c.value = value;
+        c.max = (std::max)(c.max, value);
+        if (_capturing) {
+            const auto now = clock::now();
+            push_event(trace_event{trace_event::counter, id, 0, now, now, value});
+        }
+    }
+
+    const std::vector<zone_stats> &zones() const noexcept { return _zones; }
+    const std::vector<counter_stats> &counters() const noexcept { return _counters; }
+
+    // Zone ou compteur de ce nom, nul s’il n’existe pas.
+    const zone_stats *find_zone(std::string_view name) const {
+        for (const auto &z : _zones) {
+            if (z.name == name) {
+                return &z;
+            }
+        }
+        return nullptr;
+    }
+
+    const counter_stats *find_counter(std::string_view name) const {
+        for (const auto &c : _counters) {
+            if (c.name == name) {
+                return &c;
+            }
+        }
+        return nullptr;
+    }
+
+    std::uint64_t frame_count() const noexcept { return _frame_count; }
+    std::uint64_t last_frame_ns() const noexcept { return _last_frame_ns; }
+    std::uint64_t max_frame_ns() const noexcept { return _max_frame_ns; }
+
+    // Remet les statistiques à zéro ; les noms et identifiants sont conservés.
+    void reset() {
+        for (auto &z : _zones) {
+            z = zone_stats{std::move(z.name)};
+        }
+        for (auto &c : _counters) {
+            c = counter_stats{std::move(c.name)};
+        }
+        _frame_count = 0;
+        _last_frame_ns = 0;
+        _max_frame_ns = 0;
+    }
+
+    // -----------------------------------------------------------------
+    // Capture de trace
+    //
+    // Pendant une capture, chaque exécution de zone, chaque frame et chaque
+    // valeur de compteur est conservée, dans la limite de max_events ; les
+    // suivants sont comptés dans dropped_events().
+    // -----------------------------------------------------------------
+
+    void start_capture(std::size_t max_events = 1u << 16) {
+        _events.clear();
+        _events.reserve(max_events);
+        _max_events = max_events;
+        _dropped_events = 0;
+        _capture_start = clock::now();
+        _capturing = true;
+    }
+
+    void stop_capture() noexcept { _capturing = false; }
+
+    bool capturing() const noexcept { return _capturing; }
+    std::size_t captured_events() const noexcept { return _events.size(); }
+    std::size_t dropped_events() const noexcept { return _dropped_events; }
+
+    // Écrit la dernière capture au format JSON « Trace Event » : zones et
+    // frames en événements complets (ph « X »), compteurs en ph « C ».
+    void write_chrome_trace(std::ostream &out) const {
+        out << "{\"traceEvents\":[";
+        bool first = true;
+        for (const trace_event &e : _events) {
+            out << (first ? "\n" : ",\n");
+            first = false;
+            out << "{\"name\":";
+            if (e.kind == trace_event::counter) {
+                write_string(out, _counters[e.id].name);
+                out << ",\"ph\":\"C\",\"ts\":";
+                write_us(out, e.start);
+                out << ",\"pid\":1,\"args\":{\"value\":" << e.value << "}}";
+                continue;
+            }
+            write_string(out, e.kind == trace_event::frame ? std::string_view("frame") : _zones[e.id].name);
+            out << ",\"cat\":\"" << (e.kind == trace_event::frame ? "frame" : "zone") << "\",\"ph\":\"X\",\"ts\":";
+            write_us(out, e.start);
+            out << ",\"dur\":" << static_cast<double>(nanoseconds(e.start, e.end)) / 1000.0;
+            out << ",\"pid\":1,\"tid\":" << e.thread << '}';
+        }
+        out << "\n]}\n";
+    }
+
+private:
+    struct trace_event {
+        enum kind_type : std::uint8_t { zone, frame, counter };
+        kind_type         kind;
+        std::size_t       id;
+        std::uint32_t     thread;
+        clock::time_point start;
+        clock::time_point end;
+        std::int64_t      value;
+    };
+
+    static std::uint64_t nanoseconds(clock::time_point start, clock::time_point end) {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        return ns > 0 ? static_cast<std::uint64_t>(ns) : 0;
+    }
+
+    void push_event(const trace_event &e) {
+        if (_events.size() < _max_events) {
+            _events.push_back(e);
+        } else {
+            ++_dropped_events;
+        }
+    }
+
+    // Petit numéro stable par thread, pour le champ tid de la trace.
+    std::uint32_t thread_index(std::thread::id id) {
+        auto it = std::find(_threads.begin(), _threads.end(), id);
+        if (it == _threads.end()) {
+            _threads.push_back(id);
+            return static_cast<std::uint32_t>(_threads.size() - 1);
+        }
+        return static_cast<std::uint32_t>(it - _threads.begin());
+    }
+
+    void write_us(std::ostream &out, clock::time_point t) const {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t - _capture_start).count();
+        out << static_cast<double>(ns) / 1000.0;
+    }
+
+    static void write_string(std::ostream &out, std::string_view s) {
+        out << '"';
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                out << '\\' << c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                out << ' ';
+            } else {
+                out << c;
+            }
+        }
+        out << '"';
+    }
+
+    std::vector<zone_stats>    _zones;
+    std::vector<counter_stats> _counters;
+    clock::time_point          _frame_start{};
+    std::uint64_t              _frame_count = 0;
+    std::uint64_t              _last_frame_ns = 0;
+    std::uint64_t              _max_frame_ns = 0;
+    // Capture en cours ou terminée
+    bool                         _capturing = false;
+    clock::time_point            _capture_start{};
+    std::vector<trace_event>     _events;
+    std::size_t                  _max_events = 0;
+    std::size_t                  _dropped_events = 0;
+    std::vector<std::thread::id> _threads;
+};
+
+// Mesure la durée de vie de l’objet dans la zone donnée.
+class profile_scope {
+public:
+    profile_scope(profiler &p, profiler::zone_id id) noexcept : _profiler(p), _id(id), _start(profiler::clock::now()) {}
+    ~profile_scope() { _profiler.record(_id, _start, profiler::clock::now()); }
+    profile_scope(const profile_scope &) = delete;
+    profile_scope &operator=(const profile_scope &) = delete;
+
+private:
+    profiler                   &_profiler;
+    profiler::zone_id           _id;
+    profiler::clock::time_point _start;
+};
+
+} // namespace ecs
+
+#define ECS_PROFILE_CONCAT_(a, b) a##b
+#define ECS_PROFILE_CONCAT(a, b) ECS_PROFILE_CONCAT_(a, b)
+
+#if defined(COMMON_LIBS_PROFILING) && defined(TRACY_ENABLE)
+// Zone Tracy au nom connu à l’exécution (noms de systèmes)
+#define ECS_PROFILE_TRACY_ZONE(name) ZoneTransientN(ECS_PROFILE_CONCAT(ecs_tracy_zone_, __LINE__), (name), true)
+#define ECS_PROFILE_TRACY_FRAME() FrameMark
+#else
+#define ECS_PROFILE_TRACY_ZONE(name) ((void)0)
+#define ECS_PROFILE_TRACY_FRAME() ((void)0)
+#endif
+
+#if defined(COMMON_LIBS_PROFILING)
+// Mesure le reste du bloc courant dans la zone id de prof.
+#define ECS_PROFILE_SCOPE(prof, id)                                                              \
+    ::ecs::profile_scope ECS_PROFILE_CONCAT(ecs_profile_scope_, __LINE__)((prof), (id));        \
+    ECS_PROFILE_TRACY_ZONE((prof).zone_name(id).c_str())
+#define ECS_PROFILE_COUNTER(prof, id, value) (prof).set_counter((id), static_cast<std::int64_t>(value))
+#define ECS_PROFILE_BEGIN_FRAME(prof) (prof).begin_frame()
+#define ECS_PROFILE_END_FRAME(prof) \
+    do {                               \
+        (prof).end_frame();            \
+        ECS_PROFILE_TRACY_FRAME();     \
+    } while (0)
+#else
+#define ECS_PROFILE_SCOPE(prof, id) ((void)0)
+#define ECS_PROFILE_COUNTER(prof, id, value) ((void)0)
+#define ECS_PROFILE_BEGIN_FRAME(prof) ((void)0)
+#define ECS_PROFILE_END_FRAME(prof) ((void)0)
+#endif
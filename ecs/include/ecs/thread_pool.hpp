@@ -0,0 +1,189 @@
+// Pool de threads à vol de tâches utilisé par l’ordonnanceur du registre.
+// Chaque participant possède sa file ; un thread inoccupé prend d’abord dans
+// la sienne (par la fin) puis vole dans celles des autres (par le début).
+// Le thread appelant participe à l’exécution, ce qui permet aussi les appels
+// imbriqués depuis une tâche.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ecs {
+
+class thread_pool {
+public:
+    // Crée un pool de `threads` participants : le thread appelant plus
+    // `threads - 1` threads de travail.  Zéro équivaut à un.
+    explicit thread_pool(std::size_t threads)
+        : _queues(threads > 0 ? threads : 1) {
+        for (std::size_t i = 1; i < _queues.size(); ++i) {
+            _workers.emplace_back([this, i] { worker_loop(i); });
+        }
+    }
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(_sleep_mutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (auto &t : _workers) {
+            t.join();
+        }
+    }
+
+    // Nombre de participants, thread appelant compris.
+    std::size_t concurrency() const noexcept { return _queues.size(); }
+
+    // Exécute fn(i) pour i dans [0, count) et attend la fin de toutes les
+    // tâches.  L’ordre d’exécution n’est pas défini ; la première exception
+    // levée par une tâche est relancée ici une fois les autres terminées.
+    template <typename Function>
+    void parallel_for(std::size_t count, Function &&fn) {
+        if (count == 0) {
+            return;
+        }
+        using fn_type = std::remove_reference_t<Function>;
+        if (count == 1 || _queues.size() == 1) {
+            for (std::size_t i = 0; i < count; ++i) {
+                fn(i);
+            }
+            return;
+        }
+        job j;
+        j.invoke = [](void *ctx, std::size_t i) { (*static_cast<fn_type *>(ctx))(i); };
+        j.ctx = const_cast<void *>(static_cast<const void *>(std::addressof(fn)));
+        j.remaining.store(count, std::memory_order_relaxed);
+        std::size_t self = participant_index();
+        _queued.fetch_add(count, std::memory_order_release);
+        // Répartit les indices entre les files, en commençant par la sienne
+        for (std::size_t i = 0; i < count; ++i) {
+            auto &q = _queues[(self + i) % _queues.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.tasks.push_back(task{&j, i});
+        }
+        {
+            std::lock_guard<std::mutex> lock(_sleep_mutex);
+        }
+        _wake.notify_all();
+        // Participe jusqu’à la fin du travail, y compris aux tâches d’autres
+        // appels qui se trouveraient dans les files
+        while (j.remaining.load(std::memory_order_acquire) != 0) {
+            if (!run_one(self)) {
+                std::this_thread::yield();
+            }
+        }
+        if (j.error) {
+            std::rethrow_exception(j.error);
+        }
+    }
+
+private:
+    struct job {
+        void (*invoke)(void *, std::size_t) = nullptr;
+        void *ctx = nullptr;
+        std::atomic<std::size_t> remaining{0};
+        std::mutex error_mutex;
+        std::exception_ptr error;
+    };
+
+    struct task {
+        job *owner;
+        std::size_t index;
+    };
+
+    struct queue {
+        std::mutex mutex;
+        std::deque<task> tasks;
+    };
+
+    // Indice du participant courant : celui du thread de travail, ou 0 pour
+    // un thread extérieur au pool.
+    std::size_t participant_index() const noexcept {
+        return t_owner == this ? t_index : 0;
+    }
+
+    bool pop_local(std::size_t self, task &out) {
+        auto &q = _queues[self];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) {
+            return false;
+        }
+        out = q.tasks.back();
+        q.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(std::size_t self, task &out) {
+        for (std::size_t k = 1; k < _queues.size(); ++k) {
+            auto &q = _queues[(self + k) % _queues.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.tasks.empty()) {
+                out = q.tasks.front();
+                q.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Exécute une tâche disponible ; renvoie faux si toutes les files sont vides.
+    bool run_one(std::size_t self) {
+        task t;
+        if (!pop_local(self, t) && !steal(self, t)) {
+            return false;
+        }
+        _queued.fetch_sub(1, std::memory_order_relaxed);
+        try {
+            t.owner->invoke(t.owner->ctx, t.index);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(t.owner->error_mutex);
+            if (!t.owner->error) {
+                t.owner->error = std::current_exception();
+            }
+        }
+        t.owner->remaining.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    void worker_loop(std::size_t self) {
+        t_owner = this;
+        t_index = self;
+        for (;;) {
+            if (run_one(self)) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(_sleep_mutex);
+            _wake.wait(lock, [this] {
+                return _stop || _queued.load(std::memory_order_acquire) != 0;
+            });
+            if (_stop) {
+                return;
+            }
+        }
+    }
+
+    std::vector<queue>       _queues;
+    std::vector<std::thread> _workers;
+    std::atomic<std::size_t> _queued{0};
+    std::mutex               _sleep_mutex;
+    std::condition_variable  _wake;
+    bool                     _stop{false};
+
+    inline static thread_local const thread_pool *t_owner = nullptr;
+    inline static thread_local std::size_t        t_index = 0;
+};
+
+} // namespace ecs
@@ -4,7 +4,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <concepts>
 #include <cstddef>
+#include <iterator>
 #include <tuple>
 #include <utility>
 #include <type_traits>
@@ -135,6 +138,10 @@ public:
     }
 
 private:
+    // indexed_zipper reprend le calcul de la borne.
+    template <typename... Others>
+    friend class indexed_zipper;
+
     // Calcule la taille maximale parmi tous les tableaux (pli en temps de compilation).
     static std::size_t max_size(Arrays const &...arrs) {
         std::size_t max{0};
@@ -242,6 +249,272 @@ private:
     std::size_t            _max_size;
 };
 
+// -----------------------------------------------------------------------------
+// Vues pilotées par le plus petit ensemble
+//
+// zipper parcourt toute la plage d’indices.  Les vues choisissent à la
+// construction le tableau le plus petit (nombre de composants présents pour
+// un packed_array, plage d’indices pour un sparse_array) et n’itèrent que sur
+// ses entités ; les autres tableaux sont sondés par indice.  Avec un
+// packed_array pilote, le coût est donc proportionnel à l’ensemble apparié.
+// L’ordre suit le tableau dense du pilote, ou les indices croissants si le
+// pilote est un sparse_array.  Le tableau pilote ne doit pas recevoir ni
+// perdre de composants pendant l’itération.
+// -----------------------------------------------------------------------------
+
+namespace detail {
+    // Vrai pour les tableaux compacts exposant leurs entités denses (packed_array).
+    template <typename Array>
+    concept dense_storage = requires(Array const &a) {
+        { a.dense_size() } -> std::convertible_to<std::size_t>;
+        { a.entities().data() };
+    };
+
+    // Borne du nombre d’entités à visiter si ce tableau pilote l’itération.
+    template <typename Array>
+    std::size_t drive_cost(Array const &arr) {
+        if constexpr (dense_storage<Array>) {
+            return arr.dense_size();
+        } else {
+            return arr.size();
+        }
+    }
+
+    // Curseur commun aux vues : parcourt soit la liste d’entités du pilote,
+    // soit une plage d’indices [0, end), et s’arrête sur les indices présents
+    // dans tous les tableaux.
+    template <typename... Arrays>
+    class view_cursor {
+    public:
+        using index_type = entity_t::value_type;
+
+        view_cursor(const index_type *ids, std::size_t pos, std::size_t end,
+                    std::tuple<Arrays*...> const &arrays)
+            : _ids(ids), _pos(pos), _end(end), _arrays(arrays) {
+            skip_invalid();
+        }
+
+        void advance() {
+            ++_pos;
+            skip_invalid();
+        }
+
+        std::size_t position() const noexcept { return _pos; }
+
+        index_type current() const noexcept { return _ids ? _ids[_pos] : _pos; }
+
+        template <std::size_t I>
+        decltype(auto) get() const {
+            return (*std::get<I>(_arrays))[entity_t{current()}].value();
+        }
+
+    private:
+        template <std::size_t... Is>
+        bool all_present(index_type id, std::index_sequence<Is...>) const {
+            return (std::get<Is>(_arrays)->contains(entity_t{id}) && ...);
+        }
+
+        void skip_invalid() {
+            while (_pos < _end) {
+                if (all_present(current(), std::index_sequence_for<Arrays...>{})) {
+                    return;
+                }
+                ++_pos;
+            }
+        }
+
+        const index_type      *_ids;
+        std::size_t            _pos;
+        std::size_t            _end;
+        std::tuple<Arrays*...> _arrays;
+    };
+
+    // Sélectionne le pilote : renvoie la liste d’entités et sa taille si un
+    // packed_array est le plus petit, sinon (nullptr, borne d’indices).
+    template <typename... Arrays>
+    std::pair<const entity_t::value_type *, std::size_t>
+    select_driver(std::tuple<Arrays*...> const &arrays) {
+        const entity_t::value_type *ids = nullptr;
+        std::size_t best = static_cast<std::size_t>(-1);
+        std::size_t range = static_cast<std::size_t>(-1);
+        std::apply([&](auto *...arrs) {
+            ([&](auto *arr) {
+                using array_type = std::remove_cv_t<std::remove_pointer_t<decltype(arr)>>;
+                range = (std::min)(range, arr->size());
+                std::size_t cost = drive_cost(*arr);
+                if (cost < best) {
+                    best = cost;
+                    if constexpr (dense_storage<array_type>) {
+                        ids = arr->entities().data();
+                    } else {
+                        ids = nullptr;
+                    }
+                }
+            }(arrs), ...);
+        }, arrays);
+        if (ids) {
+            return {ids, best};
+        }
+        return {nullptr, sizeof...(Arrays) == 0 ? 0 : range};
+    }
+} // namespace detail
+
+// Vue itérable renvoyant un tuple de références aux composants.
+template <typename... Arrays>
+class view {
+public:
+    using reference = std::tuple<detail::component_ref_t<Arrays>&...>;
+    using value_type = reference;
+
+    explicit view(Arrays&... arrays)
+        : _arrays(std::addressof(arrays)...) {
+        auto [ids, count] = detail::select_driver(_arrays);
+        _ids = ids;
+        _count = count;
+    }
+
+    class iterator {
+    public:
+        using value_type = view::value_type;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::input_iterator_tag;
+
+        explicit iterator(detail::view_cursor<Arrays...> cursor) : _cursor(cursor) {}
+
+        iterator& operator++() {
+            _cursor.advance();
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+        friend bool operator==(iterator const &a, iterator const &b) {
+            return a._cursor.position() == b._cursor.position();
+        }
+        friend bool operator!=(iterator const &a, iterator const &b) {
+            return !(a == b);
+        }
+        reference operator*() const {
+            return deref(std::index_sequence_for<Arrays...>{});
+        }
+
+    private:
+        template <std::size_t... Is>
+        reference deref(std::index_sequence<Is...>) const {
+            return reference{_cursor.template get<Is>()...};
+        }
+
+        detail::view_cursor<Arrays...> _cursor;
+    };
+
+    iterator begin() const {
+        return iterator{detail::view_cursor<Arrays...>{_ids, _first, _count, _arrays}};
+    }
+    iterator end() const {
+        return iterator{detail::view_cursor<Arrays...>{_ids, _count, _count, _arrays}};
+    }
+
+    // Nombre de positions du pilote parcourues (entités candidates, avant le
+    // filtrage sur les autres tableaux).
+    std::size_t extent() const noexcept { return _count - _first; }
+
+    // Sous-vue limitée aux positions [first, last) du parcours ; sert à
+    // découper une vue en tranches indépendantes (voir parallel_for_each).
+    view slice(std::size_t first, std::size_t last) const {
+        view part = *this;
+        part._first = (std::min)(_first + first, _count);
+        part._count = (std::min)(_first + last, _count);
+        part._first = (std::min)(part._first, part._count);
+        return part;
+    }
+
+private:
+    std::tuple<Arrays*...>        _arrays;
+    const entity_t::value_type   *_ids{nullptr};
+    std::size_t                   _first{0};
+    std::size_t                   _count{0};
+};
+
+// Variante indexée : renvoie en plus l’indice de l’entité.
+template <typename... Arrays>
+class indexed_view {
+public:
+    using reference = std::tuple<std::size_t, detail::component_ref_t<Arrays>&...>;
+    using value_type = reference;
+
+    explicit indexed_view(Arrays&... arrays)
+        : _arrays(std::addressof(arrays)...) {
+        auto [ids, count] = detail::select_driver(_arrays);
+        _ids = ids;
+        _count = count;
+    }
+
+    class iterator {
+    public:
+        using value_type = indexed_view::value_type;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::input_iterator_tag;
+
+        explicit iterator(detail::view_cursor<Arrays...> cursor) : _cursor(cursor) {}
+
+        iterator& operator++() {
+            _cursor.advance();
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+        friend bool operator==(iterator const &a, iterator const &b) {
+            return a._cursor.position() == b._cursor.position();
+        }
+        friend bool operator!=(iterator const &a, iterator const &b) {
+            return !(a == b);
+        }
+        reference operator*() const {
+            return deref(std::index_sequence_for<Arrays...>{});
+        }
+
+    private:
+        template <std::size_t... Is>
+        reference deref(std::index_sequence<Is...>) const {
+            return reference{_cursor.current(), _cursor.template get<Is>()...};
+        }
+
+        detail::view_cursor<Arrays...> _cursor;
+    };
+
+    iterator begin() const {
+        return iterator{detail::view_cursor<Arrays...>{_ids, _first, _count, _arrays}};
+    }
+    iterator end() const {
+        return iterator{detail::view_cursor<Arrays...>{_ids, _count, _count, _arrays}};
+    }
+
+    // Nombre de positions du pilote parcourues (entités candidates, avant le
+    // filtrage sur les autres tableaux).
+    std::size_t extent() const noexcept { return _count - _first; }
+
+    // Sous-vue limitée aux positions [first, last) du parcours ; sert à
+    // découper une vue en tranches indépendantes (voir parallel_for_each).
+    indexed_view slice(std::size_t first, std::size_t last) const {
+        indexed_view part = *this;
+        part._first = (std::min)(_first + first, _count);
+        part._count = (std::min)(_first + last, _count);
+        part._first = (std::min)(part._first, part._count);
+        return part;
+    }
+
+private:
+    std::tuple<Arrays*...>        _arrays;
+    const entity_t::value_type   *_ids{nullptr};
+    std::size_t                   _first{0};
+    std::size_t                   _count{0};
+};
+
 // Fonctions utilitaires pour construire un zip ou un zip indexé à partir de
 // plusieurs tableaux ; les paramètres sont déduits automatiquement et un
 // conteneur adapté est retourné.
@@ -256,4 +529,64 @@ auto indexed_zip(Arrays&... arrays) {
     return indexed_zipper<Arrays...>(arrays...);
 }
 
+// Vues pilotées par le plus petit ensemble ; même syntaxe que zip :
+//     for (auto [w, in] : ecs::views::zip(weapons, inputs)) { ... }
+namespace views {
+
+template <typename... Arrays>
+auto zip(Arrays&... arrays) {
+    return view<Arrays...>(arrays...);
+}
+
+template <typename... Arrays>
+auto indexed_zip(Arrays&... arrays) {
+    return indexed_view<Arrays...>(arrays...);
+}
+
+} // namespace views
+
+// -----------------------------------------------------------------------------
+// Parcours parallèle d’une vue : les positions du pilote sont découpées en
+// tranches de `grain` exécutées sur le pool du registre (registry::parallel_for).
+// fn reçoit les composants de chaque entité, précédés de l’indice pour une vue
+// indexée :
+//
+//     ecs::parallel_for_each(r, ecs::views::zip(lifetimes),
+//                            [dt](Lifetime &l) { l.remaining -= dt; });
+//
+// Les tranches sont disjointes : fn peut modifier les composants reçus mais
+// aucune autre donnée partagée.  Les changements structurels passent par
+// r.commands() et sont appliqués dans l’ordre d’un parcours séquentiel ; le
+// résultat ne dépend donc ni du grain ni du nombre de threads.
+// -----------------------------------------------------------------------------
+
+namespace detail {
+    template <typename Range, typename Body>
+    void parallel_slices(registry &r, Range const &range, std::size_t grain, Body &&body) {
+        grain = (std::max)(grain, std::size_t{1});
+        const std::size_t total = range.extent();
+        r.parallel_for((total + grain - 1) / grain, [&](std::size_t chunk) {
+            body(range.slice(chunk * grain, (std::min)(total, (chunk + 1) * grain)));
+        });
+    }
+} // namespace detail
+
+template <typename... Arrays, typename Function>
+void parallel_for_each(registry &r, view<Arrays...> const &v, Function &&fn, std::size_t grain = 256) {
+    detail::parallel_slices(r, v, grain, [&](auto const &part) {
+        for (auto &&item : part) {
+            std::apply(fn, item);
+        }
+    });
+}
+
+template <typename... Arrays, typename Function>
+void parallel_for_each(registry &r, indexed_view<Arrays...> const &v, Function &&fn, std::size_t grain = 256) {
+    detail::parallel_slices(r, v, grain, [&](auto const &part) {
+        for (auto &&item : part) {
+            std::apply(fn, item);
+        }
+    });
+}
+
 } // namespace ecs
\ No newline at end of file
@@ -0,0 +1,349 @@
+// Cache binaire précompilé de GameConfig.  Une configuration chargée depuis
+// Lua est sérialisée dans un fichier plat et versionné, accompagné d’une
+// empreinte du script source ; un serveur le relit sans démarrer d’état Lua et
+// revient au script dès que l’empreinte ne correspond plus.  Le fichier ne
+// contient aucun pointeur : il peut être partagé (voire projeté en mémoire)
+// par plusieurs processus de match.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "engine/resources.hpp"
+
+namespace engine {
+
+// Version du format ; à incrémenter à chaque modification des structures de
+// configuration ou de leur ordre de sérialisation.
+inline constexpr std::uint32_t kGameConfigCacheVersion = 1;
+
+namespace detail {
+
+inline constexpr char          kCacheMagic[4] = {'R', 'T', 'C', 'F'};
+// Relu tel quel : une valeur différente signale un fichier d’une autre boutienne.
+inline constexpr std::uint32_t kCacheByteOrder = 0x01020304u;
+
+// Empreinte FNV‑1a 64 bits.
+inline std::uint64_t fnv1a64(const void* data, std::size_t size,
+                             std::uint64_t hash = 14695981039346656037ull) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Lit tout le fichier ouvert in dans out : taille par seekg/tellg puis un
+// seul read() dans un tampon dimensionné d’avance.  Renvoie faux en cas
+// d’échec de lecture.
+inline bool readWholeFile(std::ifstream& in, std::vector<char>& out) {
+    in.seekg(0, std::ios::end);
+    const std::streamoff size = in.tellg();
+    if (size < 0) {
+        return false;
+    }
+    in.seekg(0, std::ios::beg);
+    out.resize(static_cast<std::size_t>(size));
+    return static_cast<bool>(in.read(out.data(), static_cast<std::streamsize>(size)));
+}
+
+// Liste des champs sérialisés de chaque structure, commune à l’écriture et à
+// la lecture (Def peut être const).  Les champs dérivés (Archetype::id,
+// targetPlan, archetypeNames) sont recalculés par compileGameConfig().
+template <typename Ar, typename Def>
+void cacheFields(Ar& ar, Def& d) requires std::is_same_v<std::remove_const_t<Def>, ProjectileDef> {
+    ar(d.collision, d.damage, d.width, d.height);
+}
+template <typename Ar, typename Def>
+void cacheFields(Ar& ar, Def& d) requires std::is_same_v<std::remove_const_t<Def>, WeaponDef::ChargeLevel> {
+    ar(d.damageMul, d.speedMul, d.sizeMul, d.piercingHits);
+}
+template <typename Ar, typename Def>
+void cacheFields(Ar& ar, Def& d) requires std::is_same_v<std::remove_const_t<Def>, WeaponDef> {
+    ar(d.name, d.rate, d.speed, d.lifetime, d.damage, d.projectileName, d.pattern.offsets, d.piercingHits,
+       d.charge.maxTime, d.charge.thresholds, d.charge.levels);
+}
+template <typename Ar, typename Def>
+void cacheFields(Ar& ar, Def& d) requires std::is_same_v<std::remove_const_t<Def>, Archetype> {
+    ar(d.name, d.respawnable, d.health, d.collision,
+       d.hitbox.width, d.hitbox.height, d.hitbox.offsetX, d.hitbox.offsetY,
+       d.speed, d.lookDirection.x, d.lookDirection.y, d.target, d.range, d.weaponName, d.pattern.offsets,
+       d.faction, d.colliderLayer, d.colliderMask, d.colliderSolid, d.colliderTrigger, d.colliderStatic,
+       d.targetOrder, d.targetMode, d.thornsEnabled, d.thornsDamage);
+}
+template <typename Ar, typename Def>
+void cacheFields(Ar& ar, Def& d) requires std::is_same_v<std::remove_const_t<Def>, GameConfig::Bounds> {
+    ar(d.minX, d.minY, d.maxX, d.maxY, d.enabled);
+}
+template <typename Ar, typename Def>
+void cacheFields(Ar& ar, Def& d) requires std::is_same_v<std::remove_const_t<Def>, GameConfig> {
+    ar(d.projectiles, d.weapons, d.archetypes, d.worldBounds, d.playableBounds);
+}
+
+template <typename T>
+inline constexpr bool kCacheScalar = std::is_arithmetic_v<T>;
+
+// Écriture : scalaires dans l’ordre natif, chaînes et tableaux préfixés par
+// leur longueur, tables triées par clé pour un fichier reproductible.
+class CacheWriter {
+public:
+    template <typename... Ts>
+    void operator()(const Ts&... values) { (put(values), ...); }
+
+    std::vector<char>& bytes() { return m_bytes; }
+
+private:
+    template <typename T>
+    void put(const T& v) {
+        if constexpr (kCacheScalar<T>) {
+            const char* p = reinterpret_cast<const char*>(&v);
+            m_bytes.insert(m_bytes.end(), p, p + sizeof(T));
+        } else {
+            cacheFields(*this, v);
+        }
+    }
+    void put(const std::string& s) {
+        put(static_cast<std::uint32_t>(s.size()));
+        m_bytes.insert(m_bytes.end(), s.begin(), s.end());
+    }
+    template <typename A, typename B>
+    void put(const std::pair<A, B>& p) {
+        put(p.first);
+        put(p.second);
+    }
+    template <typename T>
+    void put(const std::vector<T>& v) {
+        put(static_cast<std::uint32_t>(v.size()));
+        for (const T& e : v) {
+            put(e);
+        }
+    }
+    template <typename T>
+    void put(const std::unordered_map<std::string, T>& m) {
+        std::vector<const std::pair<const std::string, T>*> sorted;
+        sorted.reserve(m.size());
+        for (const auto& kv : m) {
+            sorted.push_back(&kv);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](auto* a, auto* b) { return a->first < b->first; });
+        put(static_cast<std::uint32_t>(sorted.size()));
+        for (const auto* kv : sorted) {
+            put(kv->first);
+            put(kv->second);
+        }
+    }
+
+    std::vector<char> m_bytes;
+};
+
+// Lecture bornée ; lève std::runtime_error sur un contenu tronqué.
+class CacheReader {
+public:
+    CacheReader(const char* data, std::size_t size) : m_data(data), m_size(size) {}
+
+    template <typename... Ts>
+    void operator()(Ts&... values) { (get(values), ...); }
+
+    std::size_t position() const { return m_pos; }
+    bool atEnd() const { return m_pos == m_size; }
+
+private:
+    const char* take(std::size_t n) {
+        if (n > m_size - m_pos) {
+            throw std::runtime_error("Truncated GameConfig cache");
+        }
+        const char* p = m_data + m_pos;
+        m_pos += n;
+        return p;
+    }
+    template <typename T>
+    void get(T& v) {
+        if constexpr (kCacheScalar<T>) {
+            std::memcpy(&v, take(sizeof(T)), sizeof(T));
+        } else {
+            cacheFields(*this, v);
+        }
+    }
+    std::uint32_t count() {
+        std::uint32_t n = 0;
+        get(n);
+        return n;
+    }
+    void get(std::string& s) {
+        const std::uint32_t n = count();
+        const char* p = take(n);
+        s.assign(p, n);
+    }
+    template <typename A, typename B>
+    void get(std::pair<A, B>& p) {
+        get(p.first);
+        get(p.second);
+    }
+    template <typename T>
+    void get(std::vector<T>& v) {
+        const std::uint32_t n = count();
+        // Chaque élément occupe au moins un octet : borne la réservation
+        v.clear();
+        v.reserve((std::min)(static_cast<std::size_t>(n), m_size - m_pos));
+        for (std::uint32_t i = 0; i < n; ++i) {
+            get(v.emplace_back());
+        }
+    }
+    template <typename T>
+    void get(std::unordered_map<std::string, T>& m) {
+        const std::uint32_t n = count();
+        m.clear();
+        for (std::uint32_t i = 0; i < n; ++i) {
+            std::string key;
+            get(key);
+            get(m[key]);
+        }
+    }
+
+    const char* m_data;
+    std::size_t m_size;
+    std::size_t m_pos = 0;
+};
+
+} // namespace detail
+
+// -----------------------------------------------------------------------------
+// hashGameConfigSource
+//
+// Empreinte FNV‑1a 64 bits du contenu du script Lua.  Seul ce fichier est pris
+// en compte : les scripts qu’il charge lui‑même (dofile, require) ne le sont
+// pas, et les modifier n’invalide pas le cache.  Une configuration répartie
+// sur plusieurs fichiers doit supprimer ou régénérer son cache quand ils
+// changent.  Lève std::runtime_error si le fichier est illisible.
+// -----------------------------------------------------------------------------
+inline std::uint64_t hashGameConfigSource(const std::string& luaPath) {
+    std::ifstream in(luaPath, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Failed to open Lua file: " + luaPath);
+    }
+    std::vector<char> text;
+    if (!detail::readWholeFile(in, text)) {
+        throw std::runtime_error("Failed to read Lua file: " + luaPath);
+    }
+    return detail::fnv1a64(text.data(), text.size());
+}
+
+// -----------------------------------------------------------------------------
+// saveGameConfigCache
+//
+// Écrit cfg dans path avec l’empreinte sourceHash.  Le fichier est écrit à
+// côté puis renommé : un autre processus ne lit jamais un cache partiel.
+// Lève std::runtime_error en cas d’échec d’écriture.
+//
+// Format : en‑tête (magique « RTCF », version, marqueur de boutienne, réservé,
+// empreinte source, taille et empreinte de la charge utile) puis la charge
+// utile sérialisée par detail::CacheWriter.
+// -----------------------------------------------------------------------------
+inline void saveGameConfigCache(const GameConfig& cfg, std::uint64_t sourceHash, const std::string& path) {
+    detail::CacheWriter payload;
+    payload(cfg);
+    const std::vector<char>& body = payload.bytes();
+    detail::CacheWriter header;
+    header(detail::kCacheMagic[0], detail::kCacheMagic[1], detail::kCacheMagic[2], detail::kCacheMagic[3],
+           kGameConfigCacheVersion, detail::kCacheByteOrder, std::uint32_t{0}, sourceHash,
+           static_cast<std::uint64_t>(body.size()), detail::fnv1a64(body.data(), body.size()));
+
+    const std::string tmp = path + ".tmp" + std::to_string(std::random_device{}());
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(header.bytes().data(), static_cast<std::streamsize>(header.bytes().size()));
+        out.write(body.data(), static_cast<std::streamsize>(body.size()));
+        if (!out) {
+            throw std::runtime_error("Failed to write GameConfig cache: " + tmp);
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        throw std::runtime_error("Failed to write GameConfig cache: " + path);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// loadGameConfigCache
+//
+// Relit un cache écrit par saveGameConfigCache().  Renvoie std::nullopt si le
+// fichier est absent, d’une autre version ou boutienne, produit depuis une
+// autre source (sourceHash différent) ou corrompu.  La configuration renvoyée
+// est compilée (compileGameConfig).
+// -----------------------------------------------------------------------------
+inline std::optional<GameConfig> loadGameConfigCache(const std::string& path, std::uint64_t sourceHash) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return std::nullopt;
+    }
+    std::vector<char> file;
+    if (!detail::readWholeFile(in, file)) {
+        return std::nullopt;
+    }
+    try {
+        detail::CacheReader header(file.data(), file.size());
+        char magic[4] = {};
+        std::uint32_t version = 0, byteOrder = 0, reserved = 0;
+        std::uint64_t hash = 0, size = 0, payloadHash = 0;
+        header(magic[0], magic[1], magic[2], magic[3], version, byteOrder, reserved, hash, size, payloadHash);
+        if (std::memcmp(magic, detail::kCacheMagic, sizeof(magic)) != 0 || version != kGameConfigCacheVersion ||
+            byteOrder != detail::kCacheByteOrder || hash != sourceHash) {
+            return std::nullopt;
+        }
+        const std::size_t offset = header.position();
+        if (file.size() - offset != size || detail::fnv1a64(file.data() + offset, size) != payloadHash) {
+            return std::nullopt;
+        }
+        GameConfig cfg;
+        detail::CacheReader body(file.data() + offset, size);
+        body(cfg);
+        if (!body.atEnd()) {
+            return std::nullopt;
+        }
+        compileGameConfig(cfg);
+        return cfg;
+    } catch (const std::runtime_error&) {
+        return std::nullopt;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// loadGameConfigCached
+//
+// Charge la configuration depuis cachePath si le cache correspond au contenu
+// actuel de luaPath (ce seul fichier, voir hashGameConfigSource()) ; sinon exécute le script avec loadGameConfig() et
+// régénère le cache.  Un échec d’écriture du cache n’est pas fatal (avertissement
+// sur std::cerr).  Lève std::runtime_error comme loadGameConfig().
+// -----------------------------------------------------------------------------
+inline GameConfig loadGameConfigCached(const std::string& luaPath, const std::string& cachePath) {
+    const std::uint64_t sourceHash = hashGameConfigSource(luaPath);
+    if (auto cached = loadGameConfigCache(cachePath, sourceHash)) {
+        return std::move(*cached);
+    }
+    GameConfig cfg = loadGameConfig(luaPath);
+    try {
+        saveGameConfigCache(cfg, sourceHash, cachePath);
+    } catch (const std::exception& e) {
+        std::cerr << "[ConfigCache] Warning: " << e.what() << std::endl;
+    }
+    return cfg;
+}
+
+} // namespace engine
@@ -11,14 +11,22 @@
 #include <cstdint>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <limits>
 #include <vector>
 #include <functional>
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <span>
+#include <type_traits>
 
 #include "ecs/ecs.hpp"
 #include "engine/resources.hpp"
 #include "ecs/zipper.hpp"
+#include "ecs/group.hpp"
+#include "engine/spatial.hpp"
+#include "engine/simd.hpp"
+#include "engine/hot_reload.hpp"
 
 namespace engine {
 
@@ -100,14 +108,43 @@ struct PendingDamage {
         : amount(amt), source(src) {}
 };
 
-// Capacité de perforation : nombre de cibles restantes et entités déjà touchées
+// Capacité de perforation : nombre de cibles restantes et indices des entités
+// déjà touchées.  Les kInlineHits premiers indices sont rangés dans le
+// composant (64 octets) ; les suivants, rares, débordent dans un vecteur.
 struct Piercing {
+    static constexpr std::size_t kInlineHits = 8;
+
     int remainingHits = 0;
-    std::unordered_set<std::size_t> hitEntities;
+    std::uint32_t hitCount = 0;
+    std::array<std::uint32_t, kInlineHits> hits{};
+    std::vector<std::uint32_t> overflow;
 
     Piercing() = default;
-    Piercing(int hits, std::unordered_set<std::size_t> set = {})
-        : remainingHits(hits), hitEntities(std::move(set)) {}
+    Piercing(int h) : remainingHits(h) {}
+
+    // Vrai si l’entité d’indice donné a déjà été touchée.
+    bool contains(std::size_t index) const {
+        const auto id = static_cast<std::uint32_t>(index);
+        const auto inlineEnd = hits.begin() + (std::min)(static_cast<std::ptrdiff_t>(hitCount),
+                                                         static_cast<std::ptrdiff_t>(kInlineHits));
+        return std::find(hits.begin(), inlineEnd, id) != inlineEnd
+            || std::find(overflow.begin(), overflow.end(), id) != overflow.end();
+    }
+
+    // Enregistre un impact ; renvoie faux si l’entité avait déjà été touchée.
+    bool insert(std::size_t index) {
+        if (contains(index)) {
+            return false;
+        }
+        const auto id = static_cast<std::uint32_t>(index);
+        if (hitCount < kInlineHits) {
+            hits[hitCount] = id;
+        } else {
+            overflow.push_back(id);
+        }
+        ++hitCount;
+        return true;
+    }
 };
 
 // Épines : inflige des dégâts au contact lorsque activé
@@ -125,17 +162,12 @@ struct ArchetypeRef {
     explicit ArchetypeRef(const Archetype* a) : def(a) {}
 };
 
-// Liste des noms d’archétypes cibles (IA)
+// Ordre de priorité des cibles (IA) : plan compilé de l’archétype, détenu par
+// la configuration du moteur.  Sans plan, l’IA vise l’ennemi le plus proche.
 struct TargetList {
-    // Ordre de priorité des cibles (défini dans la configuration)
-    std::vector<std::string> names;
-    // Mode de sélection par catégorie (par exemple « closest_in_class »)
-    std::unordered_map<std::string, std::string> modes;
-
+    const TargetPlan* plan = nullptr;
     TargetList() = default;
-    TargetList(const std::vector<std::string>& ns,
-               const std::unordered_map<std::string, std::string>& md = {})
-        : names(ns), modes(md) {}
+    explicit TargetList(const TargetPlan* p) : plan(p) {}
 };
 
 // Portée d’attaque
@@ -182,6 +214,16 @@ struct InputState {
     bool  fireReleased = false;
 };
 
+// Gabarit d’un tir pour une arme et un niveau de charge : composants du
+// projectile préinitialisés (voir ProjectilePool).
+struct ProjectileTemplate {
+    float    speed = 0.f;
+    Lifetime lifetime;
+    Damage   damage;
+    Hitbox   hitbox;
+    int      piercingHits = 0;
+};
+
 // Référence à une arme et état associé (cooldown, chargement, etc.)
 struct WeaponRef {
     const WeaponDef* def = nullptr;
@@ -191,6 +233,113 @@ struct WeaponRef {
     float            chargeTimeAccum = 0.f;
     // Le niveau de charge est calculé lors du relâchement et réinitialisé après le tir
     std::size_t      chargeLevel    = 0;
+    // Gabarits de tir de l’arme, un par niveau de charge (aucun si le projectile est inconnu)
+    const ProjectileTemplate* shots = nullptr;
+    std::size_t      shotCount      = 0;
+};
+
+} // namespace engine
+
+// -----------------------------------------------------------------------------
+// Stockage compact pour les composants portés par peu d’entités (armes,
+// projectiles, dégâts en attente) : les systèmes qui les parcourent ne visitent
+// que les composants présents au lieu de toute la plage d’indices.  Position et
+// Velocity sont compacts pour être possédés par le groupe de mouvement.
+// -----------------------------------------------------------------------------
+template <> struct ecs::component_storage<engine::Position>      { using type = ecs::packed_array<engine::Position>; };
+template <> struct ecs::component_storage<engine::Velocity>      { using type = ecs::packed_array<engine::Velocity>; };
+template <> struct ecs::component_storage<engine::WeaponRef>     { using type = ecs::packed_array<engine::WeaponRef>; };
+template <> struct ecs::component_storage<engine::Lifetime>      { using type = ecs::packed_array<engine::Lifetime>; };
+template <> struct ecs::component_storage<engine::Damage>        { using type = ecs::packed_array<engine::Damage>; };
+template <> struct ecs::component_storage<engine::Piercing>      { using type = ecs::packed_array<engine::Piercing>; };
+template <> struct ecs::component_storage<engine::PendingDamage> { using type = ecs::packed_array<engine::PendingDamage>; };
+template <> struct ecs::component_storage<engine::Thorns>        { using type = ecs::packed_array<engine::Thorns>; };
+
+namespace engine {
+
+// Filtre des requêtes spatiales de cibles : exclut une faction (si renseignée)
+// et exige un identifiant d’archétype (si positif ; voir Archetype::id).
+struct TargetFilter {
+    std::optional<int> excludeFaction;
+    int                archetypeId = -1;
+};
+
+// -----------------------------------------------------------------------------
+// Gabarits de projectiles, construits une fois à partir de la configuration :
+// pour chaque arme, la définition du projectile est résolue et un gabarit est
+// préparé par niveau de charge (un seul si l’arme n’a pas de niveaux).  Le tir
+// copie le gabarit dans une unique commande de création ; l’indice de l’entité
+// est repris de la liste libre du registre, sans allocation une fois les
+// tableaux de composants à leur taille.
+// -----------------------------------------------------------------------------
+class ProjectilePool {
+public:
+    ProjectilePool() = default;
+    explicit ProjectilePool(const GameConfig& cfg) {
+        for (const auto& [name, wdef] : cfg.weapons) {
+            std::vector<ProjectileTemplate>& shots = m_shots[name];
+            auto pit = cfg.projectiles.find(wdef.projectileName);
+            if (pit == cfg.projectiles.end()) {
+                continue;
+            }
+            const ProjectileDef& pdef = pit->second;
+            const auto& levels = wdef.charge.levels;
+            if (levels.empty()) {
+                shots.push_back(makeTemplate(wdef, pdef, wdef.damage, wdef.speed, 1.f, wdef.piercingHits));
+            }
+            for (const auto& lev : levels) {
+                int damage = static_cast<int>(std::round(static_cast<float>(wdef.damage) * lev.damageMul));
+                shots.push_back(makeTemplate(wdef, pdef, damage, wdef.speed * lev.speedMul, lev.sizeMul,
+                                             wdef.piercingHits + lev.piercingHits));
+            }
+        }
+    }
+
+    // Gabarits de l’arme nommée, indexés par niveau de charge ; vide si l’arme
+    // est inconnue ou si son projectile n’est pas défini.
+    const std::vector<ProjectileTemplate>& shots(const std::string& weaponName) const {
+        static const std::vector<ProjectileTemplate> none;
+        auto it = m_shots.find(weaponName);
+        return it != m_shots.end() ? it->second : none;
+    }
+
+private:
+    static ProjectileTemplate makeTemplate(const WeaponDef& wdef, const ProjectileDef& pdef, int damage,
+                                           float speed, float sizeMul, int piercingHits) {
+        ProjectileTemplate t;
+        t.speed = speed;
+        t.lifetime = Lifetime{wdef.lifetime};
+        t.damage = Damage{damage};
+        t.hitbox = Hitbox(pdef.width * 0.5f * sizeMul, pdef.height * 0.5f * sizeMul);
+        t.piercingHits = piercingHits;
+        return t;
+    }
+
+    // Les vecteurs ne sont plus modifiés après la construction : WeaponRef
+    // conserve un pointeur vers leurs éléments.
+    std::unordered_map<std::string, std::vector<ProjectileTemplate>> m_shots;
+};
+
+// État de la simulation capturé par Engine::saveState() : registre complet et
+// horloge du moteur.  Réécrire toujours les mêmes objets (tampon circulaire
+// d’états) réutilise leurs copies sans allocation.
+class WorldState {
+public:
+    bool empty() const { return m_registry.empty(); }
+    // Valeur de Engine::tickCount() à la capture.
+    std::uint64_t tick() const { return m_tick; }
+    // Tableaux de composants recopiés par la capture (les autres sont partagés).
+    std::size_t copiedArrays() const { return m_registry.copied_arrays(); }
+    void clear() { m_registry.clear(); }
+
+private:
+    friend class Engine;
+    ecs::registry_state m_registry;
+    std::uint64_t m_tick = 0;
+    float m_dt = 0.f;
+    double m_accumulator = 0.0;
+    std::uint64_t m_droppedSteps = 0;
+    std::uint64_t m_configRevision = 0;
 };
 
 // -----------------------------------------------------------------------------
@@ -201,6 +350,10 @@ public:
     // Construit le moteur à partir de la configuration ; enregistre composants et systèmes.  Lève une exception si une définition manque.
     explicit Engine(const GameConfig& cfg)
         : m_config(cfg) {
+        // Identifiants d’archétypes et plans de ciblage (la configuration a pu être construite à la main)
+        compileGameConfig(m_config);
+        // Gabarits de projectiles par arme et niveau de charge
+        m_projectilePool = ProjectilePool(m_config);
         // Enregistre tous les types de composants dans le registry
         m_registry.register_component<Position>();
         m_registry.register_component<Velocity>();
@@ -224,6 +377,22 @@ public:
         // Composants supplémentaires
         m_registry.register_component<Thorns>();
         m_registry.register_component<ArchetypeRef>();
+        // Groupe de mouvement : Position et Velocity alignées pour l’intégration
+        m_registry.group<Position, Velocity>();
+        // Zones et compteurs des phases de tick() (voir profiler())
+        ecs::profiler& prof = m_registry.profiler();
+        m_profile.movement   = prof.zone("movement");
+        m_profile.systems    = prof.zone("systems");
+        m_profile.solids     = prof.zone("solids");
+        m_profile.commit     = prof.zone("commit");
+        m_profile.collisions = prof.zone("collisions");
+        m_profile.damage     = prof.zone("damage");
+        m_profile.expire     = prof.zone("expire");
+        m_profile.entities    = prof.counter("entities");
+        m_profile.projectiles = prof.counter("projectiles");
+        m_profile.pairs       = prof.counter("collision.pairs");
+        m_profile.solidItems  = prof.counter("collision.solids");
+        m_profile.pending     = prof.counter("damage.pending");
         // Enregistre les systèmes ; ils capturent m_dt par référence et cette valeur
         // sera mise à jour dans update() avant leur exécution.
         registerSystems();
@@ -232,137 +401,408 @@ public:
     // Fait apparaître une entité depuis un archétype ; position initiale facultative.
     // Lève invalid_argument si l’archétype ou l’arme associée est inconnu.
     ecs::entity_t spawn(const std::string& archetypeName, float x = 0.f, float y = 0.f) {
-        auto it = m_config.archetypes.find(archetypeName);
-        if (it == m_config.archetypes.end()) {
-            throw std::invalid_argument("Unknown archetype: " + archetypeName);
+        const Vec2 at{x, y};
+        ecs::entity_t ent;
+        spawnArchetype(findArchetype(archetypeName), std::span<const Vec2>(&at, 1), &ent);
+        return ent;
+    }
+
+    // Fait apparaître une entité par position, toutes du même archétype, et
+    // renvoie leurs handles dans l’ordre des positions.  Le résultat est celui
+    // d’appels successifs à spawn() ; les tableaux de composants ne sont agrandis
+    // qu’une fois et remplis type par type.  Lève invalid_argument comme spawn(),
+    // avant toute création.
+    std::vector<ecs::entity_t> spawnBatch(const std::string& archetypeName, std::span<const Vec2> positions) {
+        std::vector<ecs::entity_t> out(positions.size());
+        spawnArchetype(findArchetype(archetypeName), positions, out.data());
+        return out;
+    }
+
+    // Renvoie une référence au registry sous‑jacent (ne pas la conserver au‑delà de la durée de vie du moteur).
+    ecs::registry& getRegistry() { return m_registry; }
+    const ecs::registry& getRegistry() const { return m_registry; }
+
+    // Statistiques par frame (un pas) : zones des systèmes (« weapons »,
+    // « lifetime », « ai ») et des phases de tick(), compteurs d’entités et de
+    // paires.  Nulles sans COMMON_LIBS_PROFILING.
+    ecs::profiler& profiler() { return m_registry.profiler(); }
+    const ecs::profiler& profiler() const { return m_registry.profiler(); }
+
+    // Requêtes spatiales sur les entités possédant Position et Faction.  L’index
+    // reflète l’état après le dernier update() ou spawn().  Les résultats
+    // (handles courants) remplacent le contenu de out et sont triés de la plus
+    // proche à la plus lointaine, le plus petit indice départageant les égalités.
+    void queryRadius(float x, float y, float radius, const TargetFilter& filter,
+                     std::vector<ecs::entity_t>& out) {
+        queryNearest(x, y, radius, std::numeric_limits<std::size_t>::max(), filter, out);
+    }
+
+    // Les k entités les plus proches dans le rayon donné, dans le même ordre.
+    void queryNearest(float x, float y, float radius, std::size_t k, const TargetFilter& filter,
+                      std::vector<ecs::entity_t>& out) {
+        ensureTargetIndex();
+        m_targetScratch.clear();
+        forEachTarget(x, y, radius, filter, [&](std::size_t id, float distSq) {
+            m_targetScratch.emplace_back(distSq, id);
+        });
+        auto last = m_targetScratch.begin() + static_cast<std::ptrdiff_t>((std::min)(k, m_targetScratch.size()));
+        std::partial_sort(m_targetScratch.begin(), last, m_targetScratch.end());
+        out.clear();
+        for (auto it = m_targetScratch.begin(); it != last; ++it) {
+            out.push_back(m_registry.entity_from_index(it->second));
         }
-        const Archetype& arch = it->second;
-        ecs::entity_t ent = m_registry.spawn_entity();
-        // Position et vitesse initiales
-        m_registry.emplace_component<Position>(ent, x, y);
-        m_registry.emplace_component<Velocity>(ent, 0.f, 0.f);
-        // Vitesse de déplacement
-        m_registry.emplace_component<Speed>(ent, arch.speed);
-        // Direction de visée
-        m_registry.emplace_component<LookDirection>(ent, arch.lookDirection.x, arch.lookDirection.y);
-        // Points de vie
-        m_registry.emplace_component<Health>(ent, arch.health);
-        // Boîte de collision (demi‑dimensions)
-        // Inclut les décalages si présents
-        m_registry.emplace_component<Hitbox>(ent, arch.hitbox.width * 0.5f, arch.hitbox.height * 0.5f,
-                                             arch.hitbox.offsetX, arch.hitbox.offsetY);
-        // Composant de collision
-        m_registry.emplace_component<Collider>(ent, arch.colliderLayer, arch.colliderMask,
-                                              arch.colliderSolid, arch.colliderTrigger, arch.colliderStatic);
-        // Faction
-        m_registry.emplace_component<Faction>(ent, arch.faction);
-        // Liste de cibles : utilise l’ordre et les modes de la configuration ; si vide, l’IA vise le plus proche
-        m_registry.emplace_component<TargetList>(ent, arch.targetOrder, arch.targetMode);
-        // Portée d’attaque
-        m_registry.emplace_component<Range>(ent, arch.range);
-        // Réapparition possible
-        m_registry.emplace_component<Respawnable>(ent, arch.respawnable);
-        // Motif de déplacement
-        m_registry.emplace_component<MovementPatternComp>(ent, arch.pattern.offsets, 0u);
-        // Référence vers l’archétype pour l’IA
-        m_registry.emplace_component<ArchetypeRef>(ent, &arch);
-        // État d’entrée (initialement inactif)
-        m_registry.emplace_component<InputState>(ent, 0.f, 0.f, false);
-        // Arme
-        if (!arch.weaponName.empty()) {
-            auto wit = m_config.weapons.find(arch.weaponName);
-            if (wit == m_config.weapons.end()) {
-                throw std::invalid_argument("Archetype references unknown weapon: " + arch.weaponName);
+    }
+
+    // Remplace la configuration par cfg, entre deux appels à update().  La
+    // nouvelle configuration et ses gabarits de projectiles sont construits à
+    // part puis échangés ; les références des entités vivantes (ArchetypeRef,
+    // WeaponRef, TargetList) sont ensuite reportées sur les définitions de même
+    // nom.  Une définition retirée de cfg est conservée, pour les entités qui
+    // l’utilisent encore.  Les valeurs copiées à la création (points de vie,
+    // vitesse, hitbox…) ne changent que pour les entités créées ensuite.
+    // Renvoie les différences avec la configuration précédente.
+    ConfigDiff reloadConfig(const GameConfig& cfg) {
+        ConfigDiff diff = diffGameConfig(m_config, cfg);
+        GameConfig next = cfg;
+        for (const std::string& name : diff.projectiles.removed) {
+            next.projectiles.emplace(name, m_config.projectiles.at(name));
+        }
+        for (const std::string& name : diff.weapons.removed) {
+            next.weapons.emplace(name, m_config.weapons.at(name));
+        }
+        for (const std::string& name : diff.archetypes.removed) {
+            next.archetypes.emplace(name, m_config.archetypes.at(name));
+        }
+        compileGameConfig(next);
+        ProjectilePool nextPool(next);
+
+        // Noms des définitions actuellement référencées
+        std::unordered_map<const Archetype*, const std::string*> archetypeNames;
+        for (const auto& kv : m_config.archetypes) {
+            archetypeNames.emplace(&kv.second, &kv.first);
+        }
+        std::unordered_map<const WeaponDef*, const std::string*> weaponNames;
+        for (const auto& kv : m_config.weapons) {
+            weaponNames.emplace(&kv.second, &kv.first);
+        }
+        // Les nœuds des tables sont conservés par le déplacement : les pointeurs
+        // vers next restent valides une fois next installé dans m_config
+        for (auto &refOpt : m_registry.get_components<ArchetypeRef>()) {
+            if (refOpt && refOpt->def) {
+                refOpt->def = &next.archetypes.at(*archetypeNames.at(refOpt->def));
             }
-            const WeaponDef& wdef = wit->second;
-            // Calcule le temps de recharge (inverse de la cadence de tir)
-            float cooldown = (wdef.rate > 0.f) ? (1.f / wdef.rate) : std::numeric_limits<float>::infinity();
-            m_registry.emplace_component<WeaponRef>(ent, &wdef, cooldown, 0.f);
         }
-        // Composant épines
-        if (arch.thornsEnabled || arch.thornsDamage > 0) {
-            m_registry.emplace_component<Thorns>(ent, arch.thornsDamage, arch.thornsEnabled);
+        // Le plan de ciblage est celui de l’archétype (déjà reporté ci-dessus)
+        auto &archRefs = m_registry.get_components<ArchetypeRef>();
+        auto &targets  = m_registry.get_components<TargetList>();
+        for (std::size_t idx = 0; idx < targets.size(); ++idx) {
+            ecs::entity_t ent{idx};
+            auto &targOpt = targets[ent];
+            if (targOpt && targOpt->plan) {
+                auto &archOpt = archRefs[ent];
+                targOpt->plan = archOpt && archOpt->def ? &archOpt->def->targetPlan : nullptr;
+            }
         }
-        return ent;
+        for (auto &wOpt : m_registry.get_components<WeaponRef>()) {
+            if (!wOpt || !wOpt->def) {
+                continue;
+            }
+            const std::string& name = *weaponNames.at(wOpt->def);
+            const WeaponDef& wdef = next.weapons.at(name);
+            const auto &shots = nextPool.shots(name);
+            wOpt->def = &wdef;
+            wOpt->cooldown = (wdef.rate > 0.f) ? (1.f / wdef.rate) : std::numeric_limits<float>::infinity();
+            wOpt->shots = shots.data();
+            wOpt->shotCount = shots.size();
+        }
+        m_config = std::move(next);
+        m_projectilePool = std::move(nextPool);
+        // Les états capturés pointent vers les anciennes définitions
+        ++m_configRevision;
+        // Identifiants d’archétypes et limites du monde ont pu changer
+        m_targetIndexDirty = true;
+        m_staticGridValid = false;
+        return diff;
     }
 
-    // Renvoie une référence au registry sous‑jacent (ne pas la conserver au‑delà de la durée de vie du moteur).
-    ecs::registry& getRegistry() { return m_registry; }
+    // Fixe le nombre de threads utilisés pour exécuter les systèmes (1 par
+    // défaut) ; la simulation reste identique quel que soit ce nombre.
+    void setThreadCount(std::size_t count) { m_registry.set_thread_count(count); }
 
     // Avance la simulation de dt secondes et exécute les systèmes enregistrés.
     void update(float dt) {
         m_dt = dt;
-        // Exécute tous les systèmes pour mettre à jour les composants
-        m_registry.run_systems();
+        tick();
+    }
+
+    // -----------------------------------------------------------------
+    // Pas fixe
+    //
+    // step(n) exécute n pas de fixedTimestep() d’affilée (rattrapage d’un
+    // serveur, simulation hors ligne).  advance(elapsed) accumule le temps
+    // réel écoulé et exécute les pas fixes dus, au plus maxCatchUpSteps() par
+    // appel : au-delà, le retard est abandonné (droppedSteps()) pour qu’une
+    // frame trop longue ne provoque pas une spirale de rattrapage.  Les
+    // entrées fixées avant l’appel valent pour tous les pas ; les indicateurs
+    // de tir (firePressed, fireReleased) ne valent que pour le premier.
+    // -----------------------------------------------------------------
+
+    // Fixe la durée d’un pas ; lève std::invalid_argument si dt n’est pas
+    // strictement positif et fini.
+    void setFixedTimestep(float dt) {
+        if (!(dt > 0.f) || !std::isfinite(dt)) {
+            throw std::invalid_argument("Fixed timestep must be positive and finite");
+        }
+        m_fixedDt = dt;
+    }
+    float fixedTimestep() const { return m_fixedDt; }
+
+    // Nombre maximal de pas exécutés par advance() (au moins 1).
+    void setMaxCatchUpSteps(std::size_t steps) { m_maxCatchUpSteps = (std::max)(steps, std::size_t{1}); }
+    std::size_t maxCatchUpSteps() const { return m_maxCatchUpSteps; }
+
+    // Exécute n pas fixes.
+    void step(std::size_t n = 1) {
+        m_dt = m_fixedDt;
+        for (std::size_t i = 0; i < n; ++i) {
+            tick();
+        }
+    }
+
+    // Ajoute elapsed secondes (ignorées si négatives ou non finies) au temps
+    // accumulé et exécute les pas fixes dus, dans la limite du budget de
+    // rattrapage.  Renvoie le nombre de pas exécutés.
+    std::size_t advance(float elapsed) {
+        if (elapsed > 0.f && std::isfinite(elapsed)) {
+            m_accumulator += elapsed;
+        }
+        const double dt = m_fixedDt;
+        std::size_t due = static_cast<std::size_t>(m_accumulator / dt);
+        std::size_t run = (std::min)(due, m_maxCatchUpSteps);
+        if (due > run) {
+            // Retard abandonné : seule la fraction de pas en cours est conservée
+            m_droppedSteps += due - run;
+            m_accumulator -= static_cast<double>(due - run) * dt;
+        }
+        m_accumulator = (std::max)(m_accumulator - static_cast<double>(run) * dt, 0.0);
+        step(run);
+        return run;
+    }
+
+    // Fraction du pas suivant déjà écoulée, dans [0, 1) : facteur
+    // d’interpolation de l’affichage entre les deux derniers états.
+    float interpolationAlpha() const { return static_cast<float>(m_accumulator / m_fixedDt); }
+    // Nombre total de pas abandonnés par advance().
+    std::uint64_t droppedSteps() const { return m_droppedSteps; }
+
+    // -----------------------------------------------------------------
+    // Capture et restauration (rollback, rejeu)
+    //
+    // saveState() capture le registre et l’horloge de la simulation (pas
+    // courant, dt, temps accumulé) ; restoreState() les rétablit, après quoi
+    // les mêmes entrées redonnent les mêmes pas au bit près (voir InputLog).
+    // Le coût suit les tableaux de composants modifiés depuis la capture ou
+    // la restauration précédente (ecs::registry::save_state()).  Les réglages
+    // (configuration, pas fixe, budget de rattrapage, nombre de threads) ne
+    // sont pas capturés ; ils n’influent pas sur le résultat d’un pas, sauf
+    // la configuration : un état capturé avant reloadConfig() est refusé.
+    // -----------------------------------------------------------------
+
+    // Nombre de pas exécutés (update(), step() ou advance()).
+    std::uint64_t tickCount() const { return m_tickCount; }
+
+    // Capture l’état courant dans out, entre deux pas.
+    void saveState(WorldState& out) {
+        m_registry.save_state(out.m_registry);
+        out.m_tick = m_tickCount;
+        out.m_dt = m_dt;
+        out.m_accumulator = m_accumulator;
+        out.m_droppedSteps = m_droppedSteps;
+        out.m_configRevision = m_configRevision;
+    }
+
+    // Rétablit un état capturé par ce moteur.  Lève std::invalid_argument si
+    // l’état est vide ou vient d’un autre moteur, std::logic_error s’il a été
+    // capturé avant le dernier reloadConfig().
+    void restoreState(const WorldState& state) {
+        if (!state.empty() && state.m_configRevision != m_configRevision) {
+            throw std::logic_error("World state was saved before the last configuration reload");
+        }
+        m_registry.restore_state(state.m_registry);
+        m_tickCount = state.m_tick;
+        m_dt = state.m_dt;
+        m_accumulator = state.m_accumulator;
+        m_droppedSteps = state.m_droppedSteps;
+        m_targetIndexDirty = true;
+        m_staticGridValid = false;
+    }
+
+private:
+    // Lecture seule : ne marque pas le tableau comme modifié pour saveState().
+    template <typename Component>
+    const ecs::storage_t<Component>& readComponents() const {
+        return m_registry.get_components<Component>();
+    }
+
+    // Pas de simulation de durée m_dt.
+    void tick() {
+        ECS_PROFILE_BEGIN_FRAME(m_registry.profiler());
+        // Le registre a pu être modifié depuis la dernière frame
+        m_targetIndexDirty = true;
+        // Entrées, vitesses et motifs : calcule les positions désirées
+        integrateMovement();
+        // Exécute les systèmes enregistrés (armes, durées de vie, IA)
+        {
+            ECS_PROFILE_SCOPE(m_registry.profiler(), m_profile.systems);
+            m_registry.run_systems();
+        }
         // Résout les collisions solides sans mettre à jour immédiatement Position
         resolveSolidCollisions();
-        // Applique les limites de la zone jouable pour le joueur
-        enforcePlayableBoundsForPlayer();
-        // Copie les positions désirées résolues dans Position
-        commitPositions();
-        // Supprime les entités hors des limites du monde
-        cullOutsideWorldBounds();
+        // Serre le joueur dans la zone jouable, copie les positions désirées
+        // dans Position et supprime les entités hors des limites du monde
+        commitMovement();
         // Gère les collisions, projectiles et épines après mise à jour des positions
         handleCollisions();
         // Applique les dégâts accumulés et détruit les entités sans points de vie
         applyDamage();
         // Supprime les entités dont la durée de vie est expirée
-        auto &lifetimes = m_registry.get_components<Lifetime>();
-        for (std::size_t idx = 0; idx < lifetimes.size(); ++idx) {
-            ecs::entity_t ent{idx};
-            auto &opt = lifetimes[ent];
-            if (opt && opt->remaining <= 0.f) {
-                m_registry.kill_entity(ent);
+        removeExpired();
+        m_targetIndexDirty = true;
+        ++m_tickCount;
+        ECS_PROFILE_COUNTER(m_registry.profiler(), m_profile.entities, m_registry.alive_count());
+        ECS_PROFILE_COUNTER(m_registry.profiler(), m_profile.projectiles, readComponents<Damage>().dense_size());
+        ECS_PROFILE_END_FRAME(m_registry.profiler());
+    }
+
+    // Les destructions sont différées jusqu’à la fin du parcours dense.
+    void removeExpired() {
+        ECS_PROFILE_SCOPE(m_registry.profiler(), m_profile.expire);
+        const auto &lifetimes = readComponents<Lifetime>();
+        auto &cmd = m_registry.commands();
+        for (std::size_t k = 0; k < lifetimes.dense_size(); ++k) {
+            if (lifetimes.data()[k]->remaining <= 0.f) {
+                cmd.kill(m_registry.entity_from_index(lifetimes.entities()[k]));
             }
         }
+        m_registry.flush_commands();
     }
 
-private:
-    // Enregistre les systèmes internes.  Les lambdas capturent m_dt par référence pour utiliser la valeur mise à jour dans update().
-    void registerSystems() {
-        // Système d’entrée : convertit InputState et Speed en Velocity
-        m_registry.template add_system<InputState, Velocity, Speed>([this](ecs::registry &,
-                                                                           auto &inputs,
-                                                                           auto &vels,
-                                                                           auto &speeds) {
-            for (auto [in, vel, spd] : ecs::zip(inputs, vels, speeds)) {
-                // Axes de déplacement
-                vel.x = in.moveX * spd.value;
-                vel.y = in.moveY * spd.value;
+    const Archetype& findArchetype(const std::string& archetypeName) const {
+        auto it = m_config.archetypes.find(archetypeName);
+        if (it == m_config.archetypes.end()) {
+            throw std::invalid_argument("Unknown archetype: " + archetypeName);
+        }
+        return it->second;
+    }
+
+    // Crée une entité de l’archétype par position (handles écrits dans out) :
+    // les indices sont d’abord réservés, puis chaque composant est ajouté à
+    // toutes les entités par une boucle sur son seul tableau.
+    void spawnArchetype(const Archetype& arch, std::span<const Vec2> at, ecs::entity_t* out) {
+        // Arme résolue avant toute création
+        const WeaponDef* wdef = nullptr;
+        if (!arch.weaponName.empty()) {
+            auto wit = m_config.weapons.find(arch.weaponName);
+            if (wit == m_config.weapons.end()) {
+                throw std::invalid_argument("Archetype references unknown weapon: " + arch.weaponName);
             }
-        });
-        // Système de position désirée : intègre Velocity dans DesiredPosition avec dt
-        m_registry.template add_system<Position, Velocity, DesiredPosition>([this](ecs::registry &r,
-                                                                                  auto &positions,
-                                                                                  auto &vels,
-                                                                                  auto &desired) {
-            for (std::size_t idx = 0; idx < positions.size(); ++idx) {
-                ecs::entity_t ent{idx};
-                auto &posOpt = positions[ent];
-                auto &velOpt = vels[ent];
-                if (!posOpt || !velOpt) {
-                    continue;
+            wdef = &wit->second;
+        }
+        for (std::size_t i = 0; i < at.size(); ++i) {
+            out[i] = m_registry.spawn_entity();
+        }
+        // Au-delà de la capacité réservée, tous les tableaux sont agrandis en
+        // une fois, au moins du double pour que des lots successifs restent en
+        // temps amorti
+        const std::size_t indexCount = m_registry.index_count();
+        if (indexCount > m_registry.capacity()) {
+            m_registry.reserve((std::max)(indexCount, 2 * m_registry.capacity()));
+        }
+        m_targetIndexDirty = true;
+        const std::span<const ecs::entity_t> ents(out, at.size());
+        // Ajoute à chaque entité le composant construit par make(i).  Un
+        // tableau compact ne réserve que les composants de ce lot (au moins
+        // le double de sa capacité, comme le registre)
+        auto fill = [&](auto type, auto &&make) {
+            using Component = typename decltype(type)::type;
+            auto &arr = m_registry.get_components<Component>();
+            if constexpr (std::is_same_v<ecs::storage_t<Component>, ecs::packed_array<Component>>) {
+                const std::size_t needed = arr.dense_size() + ents.size();
+                if (needed > arr.dense_capacity()) {
+                    arr.reserve_dense((std::max)(needed, 2 * arr.dense_capacity()));
                 }
-                    float newX = posOpt->x + velOpt->x * m_dt;
-                    float newY = posOpt->y + velOpt->y * m_dt;
-                    auto &desOpt = desired[ent];
-                    if (desOpt) {
-                        desOpt->x = newX;
-                        desOpt->y = newY;
-                    } else {
-                        r.emplace_component<DesiredPosition>(ent, newX, newY);
-                    }
             }
+            for (std::size_t i = 0; i < ents.size(); ++i) {
+                arr.emplace_at(ents[i], make(i));
+            }
+        };
+        // Position et vitesse initiales
+        fill(std::type_identity<Position>{}, [&](std::size_t i) { return Position{at[i].x, at[i].y}; });
+        fill(std::type_identity<Velocity>{}, [](std::size_t) { return Velocity{0.f, 0.f}; });
+        // Vitesse de déplacement
+        fill(std::type_identity<Speed>{}, [&](std::size_t) { return Speed{arch.speed}; });
+        // Direction de visée
+        fill(std::type_identity<LookDirection>{}, [&](std::size_t) {
+            return LookDirection{arch.lookDirection.x, arch.lookDirection.y};
+        });
+        // Points de vie
+        fill(std::type_identity<Health>{}, [&](std::size_t) { return Health{arch.health}; });
+        // Boîte de collision (demi‑dimensions), décalages inclus
+        const Hitbox hitbox(arch.hitbox.width * 0.5f, arch.hitbox.height * 0.5f, arch.hitbox.offsetX, arch.hitbox.offsetY);
+        fill(std::type_identity<Hitbox>{}, [&](std::size_t) { return hitbox; });
+        // Composant de collision
+        const Collider collider(arch.colliderLayer, arch.colliderMask, arch.colliderSolid, arch.colliderTrigger,
+                                arch.colliderStatic);
+        fill(std::type_identity<Collider>{}, [&](std::size_t) { return collider; });
+        // Faction
+        fill(std::type_identity<Faction>{}, [&](std::size_t) { return Faction(arch.faction); });
+        // Liste de cibles : plan compilé depuis l’ordre et les modes de la configuration
+        fill(std::type_identity<TargetList>{}, [&](std::size_t) { return TargetList(&arch.targetPlan); });
+        // Portée d’attaque
+        fill(std::type_identity<Range>{}, [&](std::size_t) { return Range{arch.range}; });
+        // Réapparition possible
+        fill(std::type_identity<Respawnable>{}, [&](std::size_t) { return Respawnable{arch.respawnable}; });
+        // Motif de déplacement
+        fill(std::type_identity<MovementPatternComp>{}, [&](std::size_t) {
+            return MovementPatternComp{arch.pattern.offsets, 0u};
         });
+        // Référence vers l’archétype pour l’IA
+        fill(std::type_identity<ArchetypeRef>{}, [&](std::size_t) { return ArchetypeRef(&arch); });
+        // État d’entrée (initialement inactif)
+        fill(std::type_identity<InputState>{}, [](std::size_t) { return InputState{}; });
+        // Arme ; le temps de recharge est l’inverse de la cadence de tir
+        if (wdef) {
+            float cooldown = (wdef->rate > 0.f) ? (1.f / wdef->rate) : std::numeric_limits<float>::infinity();
+            const auto &shots = m_projectilePool.shots(arch.weaponName);
+            WeaponRef weapon;
+            weapon.def = wdef;
+            weapon.cooldown = cooldown;
+            weapon.shots = shots.data();
+            weapon.shotCount = shots.size();
+            fill(std::type_identity<WeaponRef>{}, [&](std::size_t) { return weapon; });
+        }
+        // Composant épines
+        if (arch.thornsEnabled || arch.thornsDamage > 0) {
+            fill(std::type_identity<Thorns>{}, [&](std::size_t) { return Thorns(arch.thornsDamage, arch.thornsEnabled); });
+        }
+    }
+
+    // Enregistre les systèmes internes.  Les lambdas capturent m_dt par référence pour utiliser la valeur mise à jour dans update().
+    // Chaque système déclare ses accès (`const T&` en lecture, `T&` en écriture)
+    // pour l’exécution parallèle ; le système d’armes est structurel.
+    void registerSystems() {
         // Système d’armes : gère la charge et crée les projectiles selon le niveau de charge
-        m_registry.template add_system<WeaponRef, InputState, Position, LookDirection>([this](ecs::registry &r,
-                                                                                              auto &weapons,
-                                                                                              auto &inputs,
-                                                                                              auto &positions,
-                                                                                              auto &looks) {
-            for (std::size_t idx = 0; idx < weapons.size(); ++idx) {
-                ecs::entity_t ent{idx};
-                auto &wOpt = weapons[ent];
+        m_registry.template add_system<WeaponRef&, InputState&, const Position&, const LookDirection&, const Faction&>(
+            ecs::structural, "weapons", [this](ecs::registry &r,
+                                               auto &weapons,
+                                               auto &inputs,
+                                               auto &positions,
+                                               auto &looks,
+                                               auto &factions) {
+            // Parcourt uniquement les porteurs d’arme (stockage compact)
+            for (std::size_t k = 0; k < weapons.dense_size(); ++k) {
+                ecs::entity_t ent{weapons.entities()[k]};
+                auto &wOpt = weapons.data()[k];
                 auto &inOpt = inputs[ent];
                 auto &posOpt = positions[ent];
                 auto &lookOpt = looks[ent];
@@ -371,8 +811,8 @@ private:
                 }
                 WeaponRef &w = *wOpt;
                 InputState &in = *inOpt;
-                Position &pos = *posOpt;
-                LookDirection &look = *lookOpt;
+                const Position &pos = *posOpt;
+                const LookDirection &look = *lookOpt;
                 // Avance le compteur de rechargement
                 if (w.timer > 0.f) {
                     w.timer -= m_dt;
@@ -416,54 +856,28 @@ private:
                         dx = 1.f;
                         dy = 0.f;
                     }
-                    // Crée l’entité projectile
-                    const WeaponDef* wdef = w.def;
-                    // Recherche la définition du projectile
-                    auto pit = m_config.projectiles.find(wdef->projectileName);
-                    if (pit != m_config.projectiles.end()) {
-                        const ProjectileDef& pdef = pit->second;
-                        ecs::entity_t proj = r.spawn_entity();
-                        // Position
-                        r.emplace_component<Position>(proj, pos.x, pos.y);
-                        // Calcule la vitesse finale
-                        float baseSpeed = wdef->speed;
-                        float finalSpeed = baseSpeed;
-                        int finalPierce = wdef->piercingHits;
-                        int finalDamage = wdef->damage;
-                        float sizeMul = 1.f;
-                        if (level < spec.levels.size()) {
-                            const auto &lev = spec.levels[level];
-                            finalDamage = static_cast<int>(std::round(static_cast<float>(wdef->damage) * lev.damageMul));
-                            finalSpeed  = baseSpeed * lev.speedMul;
-                            sizeMul     = lev.sizeMul;
-                            finalPierce = wdef->piercingHits + lev.piercingHits;
-                        }
-                        // Vitesse
-                        r.emplace_component<Velocity>(proj, dx * finalSpeed, dy * finalSpeed);
-                        // Durée de vie
-                        r.emplace_component<Lifetime>(proj, wdef->lifetime);
-                        // Dégâts
-                        r.emplace_component<Damage>(proj, finalDamage);
-                        // Hitbox mise à l’échelle
-                        float hw = pdef.width * 0.5f * sizeMul;
-                        float hh = pdef.height * 0.5f * sizeMul;
-                        r.emplace_component<Hitbox>(proj, hw, hh);
-                        // Les projectiles ne réapparaissent pas
-                        r.emplace_component<Respawnable>(proj, false);
+                    // Crée l’entité projectile depuis le gabarit du niveau de charge.
+                    // La création passe par le tampon de commandes : elle est
+                    // appliquée après le système, sans modifier les tableaux
+                    // parcourus ici.
+                    if (w.shotCount != 0) {
+                        const ProjectileTemplate &shot = w.shots[(std::min)(level, w.shotCount - 1)];
                         // Attribue la couche et le masque selon la faction du tireur
                         int factionId = 0;
-                        auto &facOpt = r.get_components<Faction>()[ent];
+                        auto &facOpt = factions[ent];
                         if (facOpt) {
                             factionId = facOpt->id;
                         }
                         // Attribue des couches exemples : 0x4 pour les projectiles du joueur et 0x8 pour ceux de l’ennemi
                         std::uint32_t layer = (factionId == 0 ? 0x4u : 0x8u);
                         std::uint32_t mask  = (factionId == 0 ? 0x2u : 0x1u);
-                        // Les projectiles sont des déclencheurs et ne bloquent pas
-                        r.emplace_component<Collider>(proj, layer, mask, /*solid*/ false, /*trigger*/ true, /*static*/ false);
-                        r.emplace_component<Faction>(proj, factionId);
-                        // Capacité de perforation
-                        r.emplace_component<Piercing>(proj, finalPierce, std::unordered_set<std::size_t>{});
+                        // Une seule commande : position, vitesse, durée de vie, dégâts,
+                        // hitbox, non réapparition, collider déclencheur (ne bloque
+                        // pas), faction et perforation
+                        r.commands().spawn_with(Position{pos.x, pos.y}, Velocity{dx * shot.speed, dy * shot.speed},
+                                                shot.lifetime, shot.damage, shot.hitbox, Respawnable{false},
+                                                Collider(layer, mask, /*solid*/ false, /*trigger*/ true, /*static*/ false),
+                                                Faction(factionId), Piercing(shot.piercingHits));
                     }
                     // Réinitialise l’état de charge
                     w.isCharging = false;
@@ -477,168 +891,58 @@ private:
             }
         });
         // Système de durée de vie : diminue la durée restante à chaque frame
-        m_registry.template add_system<Lifetime>([this](ecs::registry &,
-                                                        auto &lifetimes) {
-            for (std::size_t idx = 0; idx < lifetimes.size(); ++idx) {
-                auto &opt = lifetimes[ecs::entity_t{idx}];
-                if (opt) {
-                    opt->remaining -= m_dt;
-                }
-            }
+        m_registry.template add_system<Lifetime&>("lifetime", [this](ecs::registry &r,
+                                                                     auto &lifetimes) {
+            ecs::parallel_for_each(r, ecs::views::zip(lifetimes), [this](Lifetime &life) {
+                life.remaining -= m_dt;
+            });
         });
 
         // -----------------------------------------------------------------
-        // Système de pattern de mouvement : applique les offsets de mouvement définis en Lua
-        m_registry.template add_system<Position, MovementPatternComp, DesiredPosition>([this](ecs::registry &r,
-                                                                                             auto &positions,
-                                                                                             auto &patterns,
-                                                                                             auto &desired) {
-            std::size_t count = patterns.size();
-            for (std::size_t idx = 0; idx < count; ++idx) {
-                ecs::entity_t ent{idx};
-                auto &patOpt = patterns[ent];
-                auto &posOpt = positions[ent];
-                if (!patOpt || !posOpt) {
-                    continue;
-                }
-                auto &pat = *patOpt;
-                if (pat.offsets.empty()) {
+        // Système d’IA ennemie : vise et tire vers des cibles selon la priorité et la portée.
+        // Les cibles sont cherchées dans l’index spatial des cibles, limité à la portée.
+        m_registry.template add_system<const WeaponRef&, InputState&, const Position&, LookDirection&, const Faction&,
+                                       const Range&, const TargetList&, const ArchetypeRef&>("ai", [this](ecs::registry &,
+                                                                                                          auto &weapons,
+                                                                                                          auto &inputs,
+                                                                                                          auto &positions,
+                                                                                                          auto &lookdirs,
+                                                                                                          auto &factions,
+                                                                                                          auto &ranges,
+                                                                                                          auto &targets,
+                                                                                                          auto &) {
+            ensureTargetIndex();
+            // Parcourt toutes les entités avec une arme ; la vue est pilotée par
+            // le tableau compact des armes
+            for (auto [idx, w, in, myPos, look, fac, rng, targ] :
+                 ecs::views::indexed_zip(weapons, inputs, positions, lookdirs, factions, ranges, targets)) {
+                // Ignore la faction du joueur (id 0)
+                if (fac.id == 0) {
                     continue;
                 }
-                // Calcule le déplacement en fonction de dt
-                const auto &off = pat.offsets[pat.index];
-                float dx = off.first * m_dt;
-                float dy = off.second * m_dt;
-                auto &desOpt = desired[ent];
-                if (desOpt) {
-                    desOpt->x += dx;
-                    desOpt->y += dy;
-                } else {
-                    // Crée une position désirée à partir de la position actuelle
-                    const Position &pos = *posOpt;
-                    r.emplace_component<DesiredPosition>(ent, pos.x + dx, pos.y + dy);
-                }
-                // Avance l’index du motif avec remise à zéro
-                ++pat.index;
-                if (pat.index >= pat.offsets.size()) {
-                    pat.index = 0;
-                }
-            }
-        });
-
-        // -----------------------------------------------------------------
-        // Système d’IA ennemie : vise et tire vers des cibles selon la priorité et la portée
-        m_registry.template add_system<WeaponRef, InputState, Position, LookDirection, Faction, Range, TargetList, ArchetypeRef>([this](ecs::registry &r,
-                                                                                                                                     auto &weapons,
-                                                                                                                                     auto &inputs,
-                                                                                                                                     auto &positions,
-                                                                                                                                     auto &lookdirs,
-                                                                                                                                     auto &factions,
-                                                                                                                                     auto &ranges,
-                                                                                                                                     auto &targets,
-                                                                                                                                     auto &archRefs) {
-            std::size_t total = positions.size();
-            // Parcourt toutes les entités avec une arme
-            for (std::size_t idx = 0; idx < weapons.size(); ++idx) {
-                ecs::entity_t ent{idx};
-                auto &wOpt     = weapons[ent];
-                auto &inOpt    = inputs[ent];
-                auto &posOpt   = positions[ent];
-                auto &lookOpt  = lookdirs[ent];
-                auto &facOpt   = factions[ent];
-                auto &rangeOpt = ranges[ent];
-                auto &targOpt  = targets[ent];
-                if (!wOpt || !inOpt || !posOpt || !lookOpt || !facOpt || !rangeOpt || !targOpt) {
-                    continue;
-                }
-                // Ignore la faction du joueur (id 0)
-                if (facOpt->id == 0) {
-                    continue;
-                }
-                WeaponRef &w = *wOpt;
                 // Tire seulement si l’arme est prête (timer ≤ 0)
                 if (w.timer > 0.f) {
                     continue;
                 }
-                const Position &myPos = *posOpt;
-                int myFaction = facOpt->id;
-                float maxDistSq = rangeOpt->value * rangeOpt->value;
-                const auto &order = targOpt->names;
-                const auto &modeMap = targOpt->modes;
+                int myFaction = fac.id;
                 std::size_t chosenIdx = static_cast<std::size_t>(-1);
-                float chosenDistSq = 0.f;
-                // Traite les catégories de priorité
-                for (const std::string &cat : order) {
-                    bool useClosest = false;
-                    auto mit = modeMap.find(cat);
-                    if (mit != modeMap.end()) {
-                        std::string mode = mit->second;
-                        if (mode == "closest_in_class" || mode == "closest") {
-                            useClosest = true;
-                        }
-                    }
-                    std::size_t bestCandidate = static_cast<std::size_t>(-1);
-                    float bestDistSq = std::numeric_limits<float>::max();
-                    for (std::size_t j = 0; j < total; ++j) {
-                        if (j == idx) continue;
-                        ecs::entity_t other{j};
-                        auto &oPosOpt = positions[other];
-                        auto &oFacOpt = factions[other];
-                        auto &oArchOpt = archRefs[other];
-                        if (!oPosOpt || !oFacOpt || !oArchOpt) continue;
-                        // Ignore la même faction
-                        if (oFacOpt->id == myFaction) continue;
-                        const Archetype *adef = oArchOpt->def;
-                        if (!adef) continue;
-                        if (adef->name != cat) continue;
-                        // Vérifie la portée
-                        const Position &oPos = *oPosOpt;
-                        float dx = oPos.x - myPos.x;
-                        float dy = oPos.y - myPos.y;
-                        float distSq = dx * dx + dy * dy;
-                        if (distSq > maxDistSq) continue;
-                        if (useClosest) {
-                            if (distSq < bestDistSq || (distSq == bestDistSq && j < bestCandidate)) {
-                                bestDistSq = distSq;
-                                bestCandidate = j;
-                            }
-                        } else {
-                            bestCandidate = j;
-                            bestDistSq = distSq;
+                // Traite les catégories de priorité du plan compilé
+                if (targ.plan) {
+                    for (const TargetPlanEntry &entry : targ.plan->entries) {
+                        TargetFilter filter{myFaction, entry.archetypeId};
+                        // Closest : la plus proche ; sinon la première par indice
+                        std::size_t bestCandidate = entry.mode == TargetMode::Closest
+                            ? findClosestTarget(myPos.x, myPos.y, rng.value, filter)
+                            : findLowestIdTarget(myPos.x, myPos.y, rng.value, filter);
+                        if (bestCandidate != static_cast<std::size_t>(-1)) {
+                            chosenIdx = bestCandidate;
                             break;
                         }
                     }
-                    if (bestCandidate != static_cast<std::size_t>(-1)) {
-                        chosenIdx = bestCandidate;
-                        chosenDistSq = bestDistSq;
-                        break;
-                    }
                 }
                 // Si aucune catégorie n’est spécifiée, vise l’ennemi le plus proche
-                if (chosenIdx == static_cast<std::size_t>(-1) && order.empty()) {
-                    float bestDistSq = std::numeric_limits<float>::max();
-                    std::size_t bestIdx = static_cast<std::size_t>(-1);
-                    for (std::size_t j = 0; j < total; ++j) {
-                        if (j == idx) continue;
-                        ecs::entity_t other{j};
-                        auto &oPosOpt = positions[other];
-                        auto &oFacOpt = factions[other];
-                        if (!oPosOpt || !oFacOpt) continue;
-                        if (oFacOpt->id == myFaction) continue;
-                        const Position &oPos = *oPosOpt;
-                        float dx = oPos.x - myPos.x;
-                        float dy = oPos.y - myPos.y;
-                        float distSq = dx * dx + dy * dy;
-                        if (distSq > maxDistSq) continue;
-                        if (distSq < bestDistSq || (distSq == bestDistSq && j < bestIdx)) {
-                            bestDistSq = distSq;
-                            bestIdx = j;
-                        }
-                    }
-                    if (bestIdx != static_cast<std::size_t>(-1)) {
-                        chosenIdx = bestIdx;
-                        chosenDistSq = bestDistSq;
-                    }
+                if (chosenIdx == static_cast<std::size_t>(-1) && (!targ.plan || targ.plan->nearestIfEmpty)) {
+                    chosenIdx = findClosestTarget(myPos.x, myPos.y, rng.value, TargetFilter{myFaction, -1});
                 }
                 // Vise et tire si une cible est trouvée
                 if (chosenIdx != static_cast<std::size_t>(-1)) {
@@ -656,9 +960,8 @@ private:
                             dx = 1.f;
                             dy = 0.f;
                         }
-                        lookOpt->x = dx;
-                        lookOpt->y = dy;
-                        InputState &in = *inOpt;
+                        look.x = dx;
+                        look.y = dy;
                         in.firePressed  = true;
                         in.fireReleased = true;
                         in.fireHeld     = false;
@@ -671,147 +974,259 @@ private:
     }
 
     GameConfig m_config;
+    ProjectilePool m_projectilePool;
     ecs::registry m_registry;
     float m_dt = 0.f;
+    // Pas fixe : durée, temps accumulé par advance(), budget de rattrapage
+    float m_fixedDt = 1.f / 60.f;
+    double m_accumulator = 0.0;
+    std::size_t m_maxCatchUpSteps = 8;
+    std::uint64_t m_droppedSteps = 0;
+    // Pas exécutés ; révision de la configuration (reloadConfig())
+    std::uint64_t m_tickCount = 0;
+    std::uint64_t m_configRevision = 0;
+    // Identifiants des zones et compteurs de profiler()
+    struct ProfileIds {
+        ecs::profiler::zone_id    movement = 0;
+        ecs::profiler::zone_id    systems = 0;
+        ecs::profiler::zone_id    solids = 0;
+        ecs::profiler::zone_id    commit = 0;
+        ecs::profiler::zone_id    collisions = 0;
+        ecs::profiler::zone_id    damage = 0;
+        ecs::profiler::zone_id    expire = 0;
+        ecs::profiler::counter_id entities = 0;
+        ecs::profiler::counter_id projectiles = 0;
+        ecs::profiler::counter_id pairs = 0;
+        ecs::profiler::counter_id solidItems = 0;
+        ecs::profiler::counter_id pending = 0;
+    };
+    ProfileIds m_profile;
+    // Taille des blocs de la passe d’intégration (tranches parallèles)
+    static constexpr std::size_t kMovementBlock = 256;
+    // Phase large des collisions ; grille et paires réutilisées d’une frame à l’autre
+    SpatialGrid m_collisionGrid;
+    std::vector<SpatialGrid::Pair> m_collisionPairs;
+    // Résolution solide : statiques persistants, mobiles reconstruits à chaque frame
+    SpatialGrid m_staticSolids;
+    SpatialGrid m_dynamicSolids;
+    std::vector<SpatialGrid::Item> m_staticScratch;
+    std::vector<const SpatialGrid::Item*> m_solidCandidates;
+    bool m_staticGridValid = false;
+
+    // Index des cibles de l’IA : entités avec Position et Faction, sous forme de
+    // points, avec leur faction et leur archétype.  Reconstruit à la demande.
+    struct TargetInfo {
+        int faction;
+        int archetypeId;
+    };
+    SpatialGrid m_targetIndex;
+    std::vector<TargetInfo> m_targetInfo;
+    std::vector<std::pair<float, std::size_t>> m_targetScratch;
+    bool m_targetIndexDirty = true;
+
+    void ensureTargetIndex() {
+        if (!m_targetIndexDirty) {
+            return;
+        }
+        const auto &positions = readComponents<Position>();
+        const auto &factions  = readComponents<Faction>();
+        const auto &archRefs  = readComponents<ArchetypeRef>();
+        const auto &ranges    = readComponents<Range>();
+        m_targetIndex.clear();
+        m_targetInfo.clear();
+        std::size_t count = positions.size();
+        for (std::size_t idx = 0; idx < count; ++idx) {
+            ecs::entity_t ent{idx};
+            auto &posOpt = positions[ent];
+            auto &facOpt = factions[ent];
+            if (!posOpt || !facOpt) {
+                continue;
+            }
+            auto &archOpt = archRefs[ent];
+            m_targetIndex.insert(idx, Aabb{posOpt->x, posOpt->y, posOpt->x, posOpt->y}, 0u, 0u);
+            m_targetInfo.push_back(TargetInfo{facOpt->id, archOpt && archOpt->def ? archOpt->def->id : -1});
+        }
+        // Cellules d’une demi‑portée : une requête couvre quelques cellules
+        float maxRange = 0.f;
+        for (const auto &rngOpt : ranges) {
+            if (rngOpt) {
+                maxRange = (std::max)(maxRange, rngOpt->value);
+            }
+        }
+        m_targetIndex.build(m_config.worldBounds, maxRange * 0.5f);
+        m_targetIndexDirty = false;
+    }
+
+    // Appelle fn(indice, distance au carré) pour chaque cible du rayon qui passe le filtre.
+    template <typename Function>
+    void forEachTarget(float x, float y, float radius, const TargetFilter& filter, Function&& fn) const {
+        m_targetIndex.queryRadius(x, y, radius, [&](std::size_t k, float distSq) {
+            const TargetInfo &info = m_targetInfo[k];
+            if (filter.excludeFaction && info.faction == *filter.excludeFaction) {
+                return;
+            }
+            if (filter.archetypeId >= 0 && info.archetypeId != filter.archetypeId) {
+                return;
+            }
+            fn(m_targetIndex.item(k).id, distSq);
+        });
+    }
+
+    // Cible la plus proche dans le rayon (plus petit indice en cas d’égalité), ou -1.
+    std::size_t findClosestTarget(float x, float y, float radius, const TargetFilter& filter) const {
+        std::size_t best = static_cast<std::size_t>(-1);
+        float bestDistSq = std::numeric_limits<float>::max();
+        forEachTarget(x, y, radius, filter, [&](std::size_t id, float distSq) {
+            if (distSq < bestDistSq || (distSq == bestDistSq && id < best)) {
+                bestDistSq = distSq;
+                best = id;
+            }
+        });
+        return best;
+    }
+
+    // Cible de plus petit indice dans le rayon, ou -1.
+    std::size_t findLowestIdTarget(float x, float y, float radius, const TargetFilter& filter) const {
+        std::size_t best = static_cast<std::size_t>(-1);
+        forEachTarget(x, y, radius, filter, [&](std::size_t id, float) {
+            best = (std::min)(best, id);
+        });
+        return best;
+    }
+
+    // Boîte de collision en coordonnées monde.
+    static Aabb worldBox(const Position& pos, const Hitbox& hb) {
+        return Aabb{pos.x + hb.offsetX - hb.halfWidth, pos.y + hb.offsetY - hb.halfHeight,
+                    pos.x + hb.offsetX + hb.halfWidth, pos.y + hb.offsetY + hb.halfHeight};
+    }
 
     // ---------------------------------------------------------------------
     // Gestion des collisions et des dégâts entre entités
     void handleCollisions() {
+        ECS_PROFILE_SCOPE(m_registry.profiler(), m_profile.collisions);
         // Récupère les tableaux de composants
-        auto &positions = m_registry.get_components<Position>();
-        auto &hitboxes  = m_registry.get_components<Hitbox>();
-        auto &colliders = m_registry.get_components<Collider>();
-        auto &factions  = m_registry.get_components<Faction>();
-        auto &damages   = m_registry.get_components<Damage>();
+        const auto &positions = readComponents<Position>();
+        const auto &hitboxes  = readComponents<Hitbox>();
+        const auto &colliders = readComponents<Collider>();
+        const auto &factions  = readComponents<Faction>();
+        const auto &damages   = readComponents<Damage>();
+        const auto &thorns    = readComponents<Thorns>();
         auto &piercings = m_registry.get_components<Piercing>();
-        auto &thorns    = m_registry.get_components<Thorns>();
-        // Collecte les entités qui possèdent position, hitbox et collider
-        std::vector<std::size_t> ents;
+        // Phase large : insère dans la grille, par indice croissant, les entités
+        // qui possèdent position, hitbox et collider
+        m_collisionGrid.clear();
         std::size_t maxCount = positions.size();
-        ents.reserve(maxCount);
         for (std::size_t idx = 0; idx < maxCount; ++idx) {
             ecs::entity_t ent{idx};
-            if (positions[ent] && hitboxes[ent] && colliders[ent]) {
-                ents.push_back(idx);
+            auto &posOpt = positions[ent];
+            auto &hbOpt  = hitboxes[ent];
+            auto &colOpt = colliders[ent];
+            if (posOpt && hbOpt && colOpt) {
+                m_collisionGrid.insert(idx, worldBox(*posOpt, *hbOpt), colOpt->layer, colOpt->mask);
             }
         }
-        std::vector<ecs::entity_t> toKill;
-        // Vérifie chaque paire une fois
-        for (std::size_t a = 0; a < ents.size(); ++a) {
-            for (std::size_t b = a + 1; b < ents.size(); ++b) {
-                std::size_t ia = ents[a];
-                std::size_t ib = ents[b];
-                ecs::entity_t entA{ia};
-                ecs::entity_t entB{ib};
-                auto &posAOpt = positions[entA];
-                auto &posBOpt = positions[entB];
-                if (!posAOpt || !posBOpt) {
-                    continue;
-                }
-                auto &hbAOpt = hitboxes[entA];
-                auto &hbBOpt = hitboxes[entB];
-                auto &colAOpt = colliders[entA];
-                auto &colBOpt = colliders[entB];
-                if (!hbAOpt || !hbBOpt || !colAOpt || !colBOpt) {
-                    continue;
-                }
-                Collider &colA = *colAOpt;
-                Collider &colB = *colBOpt;
-                // Calcule les hitbox en coordonnées monde
-                Position &posA = *posAOpt;
-                Hitbox &hbA  = *hbAOpt;
-                Position &posB = *posBOpt;
-                Hitbox &hbB  = *hbBOpt;
-                float leftA   = posA.x + hbA.offsetX - hbA.halfWidth;
-                float rightA  = posA.x + hbA.offsetX + hbA.halfWidth;
-                float topA    = posA.y + hbA.offsetY - hbA.halfHeight;
-                float bottomA = posA.y + hbA.offsetY + hbA.halfHeight;
-                float leftB   = posB.x + hbB.offsetX - hbB.halfWidth;
-                float rightB  = posB.x + hbB.offsetX + hbB.halfWidth;
-                float topB    = posB.y + hbB.offsetY - hbB.halfHeight;
-                float bottomB = posB.y + hbB.offsetY + hbB.halfHeight;
-                bool intersects = !(leftA > rightB || rightA < leftB || topA > bottomB || bottomA < topB);
-                if (!intersects) {
-                    continue;
-                }
-                // Vérifie les masques de collision
-                if (((colA.mask & colB.layer) == 0) && ((colB.mask & colA.layer) == 0)) {
-                    continue;
-                }
-                // Applique les dégâts d’épines indépendamment du statut de déclencheur
-                auto &thAOpt = thorns[entA];
-                if (thAOpt && thAOpt->enabled && thAOpt->damage > 0) {
-                    int tdmg = thAOpt->damage;
-                    auto &pdOptB = m_registry.get_components<PendingDamage>()[entB];
-                    if (!pdOptB) {
-                        m_registry.emplace_component<PendingDamage>(entB, tdmg, entA.value());
-                    } else {
-                        pdOptB->amount += tdmg;
-                    }
-                }
-                auto &thBOpt = thorns[entB];
-                if (thBOpt && thBOpt->enabled && thBOpt->damage > 0) {
-                    int tdmg = thBOpt->damage;
-                    auto &pdOptA = m_registry.get_components<PendingDamage>()[entA];
-                    if (!pdOptA) {
-                        m_registry.emplace_component<PendingDamage>(entA, tdmg, entB.value());
-                    } else {
-                        pdOptA->amount += tdmg;
-                    }
+        m_collisionGrid.build(m_config.worldBounds);
+        // Paires qui se chevauchent et passent le filtre couche/masque, triées
+        // par indices : même ordre que la double boucle sur toutes les paires
+        m_collisionGrid.collectPairs(m_collisionPairs);
+        ECS_PROFILE_COUNTER(m_registry.profiler(), m_profile.pairs, m_collisionPairs.size());
+        // Les projectiles épuisés sont détruits après le parcours des paires
+        auto &cmd = m_registry.commands();
+        // Obtenu une fois : chaque accès non const renouvelle la version du tableau
+        auto &pendings = m_registry.get_components<PendingDamage>();
+        for (const auto &pair : m_collisionPairs) {
+            ecs::entity_t entA{m_collisionGrid.item(pair.first).id};
+            ecs::entity_t entB{m_collisionGrid.item(pair.second).id};
+            const Collider &colA = *colliders[entA];
+            const Collider &colB = *colliders[entB];
+            // Applique les dégâts d’épines indépendamment du statut de déclencheur
+            auto &thAOpt = thorns[entA];
+            if (thAOpt && thAOpt->enabled && thAOpt->damage > 0) {
+                int tdmg = thAOpt->damage;
+                auto pdOptB = pendings[entB];
+                if (!pdOptB) {
+                    pendings.emplace_at(entB, tdmg, entA.value());
+                } else {
+                    pdOptB->amount += tdmg;
                 }
-                // Ignore le reste si les deux colliders sont solides (résolution déjà faite)
-                if (!colA.isTrigger && !colB.isTrigger) {
-                    continue;
+            }
+            auto &thBOpt = thorns[entB];
+            if (thBOpt && thBOpt->enabled && thBOpt->damage > 0) {
+                int tdmg = thBOpt->damage;
+                auto pdOptA = pendings[entA];
+                if (!pdOptA) {
+                    pendings.emplace_at(entA, tdmg, entB.value());
+                } else {
+                    pdOptA->amount += tdmg;
                 }
-                // Identifie si les entités sont des projectiles
-                bool aProjectile = damages[entA].has_value();
-                bool bProjectile = damages[entB].has_value();
-                // Si une seule entité est un projectile, applique ses dégâts
-                if (aProjectile != bProjectile) {
-                    ecs::entity_t proj  = aProjectile ? entA : entB;
-                    ecs::entity_t target = aProjectile ? entB : entA;
-                    // Ignore les tirs alliés lors du calcul des dégâts
-                    auto &facProj = factions[proj];
-                    auto &facTarget = factions[target];
-                    if (!facProj || !facTarget || facProj->id != facTarget->id) {
-                        // Évite plusieurs impacts sur la même cible pour les projectiles perforants
-                        auto &pOpt = piercings[proj];
-                        if (!pOpt || pOpt->hitEntities.insert(target.value()).second) {
-                            // Accumule les dégâts
-                            int dmg = damages[proj]->value;
-                            auto &pdOpt = m_registry.get_components<PendingDamage>()[target];
-                            if (!pdOpt) {
-                                m_registry.emplace_component<PendingDamage>(target, dmg, proj.value());
-                            } else {
-                                pdOpt->amount += dmg;
-                            }
-                            // Diminue les perforations restantes et marque le projectile à supprimer
-                            if (pOpt) {
-                                if (--pOpt->remainingHits <= 0) {
-                                    toKill.push_back(proj);
-                                }
-                            } else {
-                                toKill.push_back(proj);
+            }
+            // Ignore le reste si les deux colliders sont solides (résolution déjà faite)
+            if (!colA.isTrigger && !colB.isTrigger) {
+                continue;
+            }
+            // Identifie si les entités sont des projectiles
+            bool aProjectile = damages[entA].has_value();
+            bool bProjectile = damages[entB].has_value();
+            // Si une seule entité est un projectile, applique ses dégâts
+            if (aProjectile != bProjectile) {
+                ecs::entity_t proj  = aProjectile ? entA : entB;
+                ecs::entity_t target = aProjectile ? entB : entA;
+                // Ignore les tirs alliés lors du calcul des dégâts
+                auto &facProj = factions[proj];
+                auto &facTarget = factions[target];
+                if (!facProj || !facTarget || facProj->id != facTarget->id) {
+                    // Évite plusieurs impacts sur la même cible pour les projectiles perforants
+                    auto pOpt = piercings[proj];
+                    if (!pOpt || pOpt->insert(target.value())) {
+                        // Accumule les dégâts
+                        int dmg = damages[proj]->value;
+                        auto pdOpt = pendings[target];
+                        if (!pdOpt) {
+                            pendings.emplace_at(target, dmg, proj.value());
+                        } else {
+                            pdOpt->amount += dmg;
+                        }
+                        // Diminue les perforations restantes et marque le projectile à supprimer
+                        if (pOpt) {
+                            if (--pOpt->remainingHits <= 0) {
+                                cmd.kill(m_registry.entity_from_index(proj.value()));
                             }
+                        } else {
+                            cmd.kill(m_registry.entity_from_index(proj.value()));
                         }
                     }
                 }
             }
         }
-        for (auto ent : toKill) {
-            m_registry.kill_entity(ent);
-        }
+        m_registry.flush_commands();
     }
 
     // ---------------------------------------------------------------------
     // Résolution des collisions solides : ajuste DesiredPosition pour éviter les pénétrations
     void resolveSolidCollisions() {
-        auto &positions = m_registry.get_components<Position>();
-        auto &desired   = m_registry.get_components<DesiredPosition>();
-        auto &vels      = m_registry.get_components<Velocity>();
-        auto &hitboxes  = m_registry.get_components<Hitbox>();
-        auto &colliders = m_registry.get_components<Collider>();
+        ECS_PROFILE_SCOPE(m_registry.profiler(), m_profile.solids);
+        const auto &positions = readComponents<Position>();
+        const auto &hitboxes  = readComponents<Hitbox>();
+        const auto &colliders = readComponents<Collider>();
+        auto &desired = m_registry.get_components<DesiredPosition>();
+        auto &vels    = m_registry.get_components<Velocity>();
         std::size_t count = positions.size();
+        // Obstacles : solides statiques (grille persistante) et solides mobiles
+        // (grille reconstruite à chaque appel), à leur position actuelle
+        refreshStaticSolids();
+        m_dynamicSolids.clear();
+        for (std::size_t j = 0; j < count; ++j) {
+            ecs::entity_t other{j};
+            auto &posBO = positions[other];
+            auto &hbBO  = hitboxes[other];
+            auto &colBO = colliders[other];
+            if (posBO && hbBO && colBO && colBO->isSolid && !colBO->isStatic) {
+                m_dynamicSolids.insert(j, worldBox(*posBO, *hbBO), colBO->layer, colBO->mask);
+            }
+        }
+        m_dynamicSolids.build(m_config.worldBounds);
+        ECS_PROFILE_COUNTER(m_registry.profiler(), m_profile.solidItems,
+                            m_staticSolids.items().size() + m_dynamicSolids.items().size());
         // Premier passage : ajuste la composante X de DesiredPosition contre les autres solides
         for (std::size_t i = 0; i < count; ++i) {
             ecs::entity_t ent{i};
@@ -819,7 +1234,7 @@ private:
             auto &desOpt = desired[ent];
             auto &hbOpt  = hitboxes[ent];
             auto &colOpt = colliders[ent];
-            auto &velOpt = vels[ent];
+            auto velOpt = vels[ent];
             if (!posOpt || !desOpt || !hbOpt || !colOpt || !colOpt->isSolid) {
                 continue;
             }
@@ -827,49 +1242,39 @@ private:
             float oldX = posOpt->x;
             float oldY = posOpt->y;
             float candX = desOpt->x;
-            float candY = desOpt->y;
-            Hitbox &hbA = *hbOpt;
-            Collider &colA = *colOpt;
+            const Hitbox &hbA = *hbOpt;
+            const Collider &colA = *colOpt;
             // Résolution sur l’axe X
             float resolvedX = candX;
-            for (std::size_t j = 0; j < count; ++j) {
-                if (i == j) continue;
-                ecs::entity_t other{j};
-                auto &posBO = positions[other];
-                auto &hbBO  = hitboxes[other];
-                auto &colBO = colliders[other];
-                if (!posBO || !hbBO || !colBO) continue;
-                if (!colBO->isSolid) continue;
-                if (((colA.mask & colBO->layer) == 0) && ((colBO->mask & colA.layer) == 0)) continue;
-                bool otherIsStatic = colBO->isStatic || i < j;
-                if (!otherIsStatic) continue;
-                Position &posB = *posBO;
-                Hitbox &hbB = *hbBO;
+            float topA      = oldY + hbA.offsetY - hbA.halfHeight;
+            float bottomA   = oldY + hbA.offsetY + hbA.halfHeight;
+            float oldRightA = oldX + hbA.offsetX + hbA.halfWidth;
+            float oldLeftA  = oldX + hbA.offsetX - hbA.halfWidth;
+            // Seuls les obstacles qui touchent la boîte balayée peuvent arrêter le
+            // déplacement ; ils sont visités par indice croissant
+            Aabb sweep{(std::min)(oldX, candX) + hbA.offsetX - hbA.halfWidth, topA,
+                       (std::max)(oldX, candX) + hbA.offsetX + hbA.halfWidth, bottomA};
+            gatherSolidObstacles(i, sweep);
+            for (const SpatialGrid::Item *obstacle : m_solidCandidates) {
+                if (((colA.mask & obstacle->layer) == 0) && ((obstacle->mask & colA.layer) == 0)) continue;
+                const Aabb &b = obstacle->box;
                 // Vérifie si le déplacement en X entraîne un croisement
-                float oldRightA = oldX + hbA.offsetX + hbA.halfWidth;
-                float oldLeftA  = oldX + hbA.offsetX - hbA.halfWidth;
                 float newRightA = resolvedX + hbA.offsetX + hbA.halfWidth;
                 float newLeftA  = resolvedX + hbA.offsetX - hbA.halfWidth;
-                float topA      = oldY + hbA.offsetY - hbA.halfHeight;
-                float bottomA   = oldY + hbA.offsetY + hbA.halfHeight;
-                float leftB     = posB.x + hbB.offsetX - hbB.halfWidth;
-                float rightB    = posB.x + hbB.offsetX + hbB.halfWidth;
-                float topB      = posB.y + hbB.offsetY - hbB.halfHeight;
-                float bottomB   = posB.y + hbB.offsetY + hbB.halfHeight;
-                bool overlapY = !(topA > bottomB || bottomA < topB);
+                bool overlapY = !(topA > b.bottom || bottomA < b.top);
                 if (!overlapY) continue;
                 // Déplacement vers la droite
                 if (resolvedX > oldX) {
                     // Vérifie le croisement du côté gauche de B
-                    if (newRightA > leftB && oldRightA <= leftB) {
-                        resolvedX = leftB - hbA.offsetX - hbA.halfWidth;
+                    if (newRightA > b.left && oldRightA <= b.left) {
+                        resolvedX = b.left - hbA.offsetX - hbA.halfWidth;
                         if (velOpt) velOpt->x = 0.f;
                     }
                 }
                 // Déplacement vers la gauche
                 if (resolvedX < oldX) {
-                    if (newLeftA < rightB && oldLeftA >= rightB) {
-                        resolvedX = rightB - hbA.offsetX + hbA.halfWidth;
+                    if (newLeftA < b.right && oldLeftA >= b.right) {
+                        resolvedX = b.right - hbA.offsetX + hbA.halfWidth;
                         if (velOpt) velOpt->x = 0.f;
                     }
                 }
@@ -883,53 +1288,41 @@ private:
             auto &desOpt = desired[ent];
             auto &hbOpt  = hitboxes[ent];
             auto &colOpt = colliders[ent];
-            auto &velOpt = vels[ent];
+            auto velOpt = vels[ent];
             if (!posOpt || !desOpt || !hbOpt || !colOpt || !colOpt->isSolid) continue;
-            float oldX = posOpt->x;
             float oldY = posOpt->y;
             float finalX = desOpt->x;
             float candY = desOpt->y;
-            Hitbox &hbA = *hbOpt;
-            Collider &colA = *colOpt;
+            const Hitbox &hbA = *hbOpt;
+            const Collider &colA = *colOpt;
             float resolvedY = candY;
-            for (std::size_t j = 0; j < count; ++j) {
-                if (i == j) continue;
-                ecs::entity_t other{j};
-                auto &posBO = positions[other];
-                auto &hbBO  = hitboxes[other];
-                auto &colBO = colliders[other];
-                if (!posBO || !hbBO || !colBO) continue;
-                if (!colBO->isSolid) continue;
-                if (((colA.mask & colBO->layer) == 0) && ((colBO->mask & colA.layer) == 0)) continue;
-                bool otherIsStatic = colBO->isStatic || i < j;
-                if (!otherIsStatic) continue;
-                Position &posB = *posBO;
-                Hitbox &hbB = *hbBO;
+            float oldBottomA = oldY + hbA.offsetY + hbA.halfHeight;
+            float oldTopA    = oldY + hbA.offsetY - hbA.halfHeight;
+            // Utilise finalX pour les bornes horizontales
+            float leftA  = finalX + hbA.offsetX - hbA.halfWidth;
+            float rightA = finalX + hbA.offsetX + hbA.halfWidth;
+            Aabb sweep{leftA, (std::min)(oldY, candY) + hbA.offsetY - hbA.halfHeight,
+                       rightA, (std::max)(oldY, candY) + hbA.offsetY + hbA.halfHeight};
+            gatherSolidObstacles(i, sweep);
+            for (const SpatialGrid::Item *obstacle : m_solidCandidates) {
+                if (((colA.mask & obstacle->layer) == 0) && ((obstacle->mask & colA.layer) == 0)) continue;
+                const Aabb &b = obstacle->box;
                 // Calcule les boîtes englobantes pour détecter un croisement
-                float oldBottomA = oldY + hbA.offsetY + hbA.halfHeight;
-                float oldTopA    = oldY + hbA.offsetY - hbA.halfHeight;
                 float newBottomA = resolvedY + hbA.offsetY + hbA.halfHeight;
                 float newTopA    = resolvedY + hbA.offsetY - hbA.halfHeight;
-                // Utilise finalX pour les bornes horizontales
-                float leftA  = finalX + hbA.offsetX - hbA.halfWidth;
-                float rightA = finalX + hbA.offsetX + hbA.halfWidth;
-                float leftB  = posB.x + hbB.offsetX - hbB.halfWidth;
-                float rightB = posB.x + hbB.offsetX + hbB.halfWidth;
-                float topB   = posB.y + hbB.offsetY - hbB.halfHeight;
-                float bottomB= posB.y + hbB.offsetY + hbB.halfHeight;
-                bool overlapX = !(leftA > rightB || rightA < leftB);
+                bool overlapX = !(leftA > b.right || rightA < b.left);
                 if (!overlapX) continue;
                 // Déplacement vers le bas
                 if (resolvedY > oldY) {
-                    if (newBottomA > topB && oldBottomA <= topB) {
-                        resolvedY = topB - hbA.offsetY - hbA.halfHeight;
+                    if (newBottomA > b.top && oldBottomA <= b.top) {
+                        resolvedY = b.top - hbA.offsetY - hbA.halfHeight;
                         if (velOpt) velOpt->y = 0.f;
                     }
                 }
                 // Déplacement vers le haut
                 if (resolvedY < oldY) {
-                    if (newTopA < bottomB && oldTopA >= bottomB) {
-                        resolvedY = bottomB - hbA.offsetY + hbA.halfHeight;
+                    if (newTopA < b.bottom && oldTopA >= b.bottom) {
+                        resolvedY = b.bottom - hbA.offsetY + hbA.halfHeight;
                         if (velOpt) velOpt->y = 0.f;
                     }
                 }
@@ -938,167 +1331,223 @@ private:
         }
     }
 
-    // Copie les positions désirées résolues dans les composants Position
-    void commitPositions() {
-        auto &positions = m_registry.get_components<Position>();
-        auto &desired   = m_registry.get_components<DesiredPosition>();
-        for (std::size_t idx = 0; idx < positions.size(); ++idx) {
+    // Reconstruit la grille des solides statiques seulement si leur ensemble
+    // (indices, boîtes, couches ou masques) a changé depuis l’appel précédent.
+    void refreshStaticSolids() {
+        const auto &positions = readComponents<Position>();
+        const auto &hitboxes  = readComponents<Hitbox>();
+        const auto &colliders = readComponents<Collider>();
+        m_staticScratch.clear();
+        std::size_t count = positions.size();
+        for (std::size_t j = 0; j < count; ++j) {
+            ecs::entity_t other{j};
+            auto &posBO = positions[other];
+            auto &hbBO  = hitboxes[other];
+            auto &colBO = colliders[other];
+            if (posBO && hbBO && colBO && colBO->isSolid && colBO->isStatic) {
+                m_staticScratch.push_back(SpatialGrid::Item{j, worldBox(*posBO, *hbBO), colBO->layer, colBO->mask});
+            }
+        }
+        if (m_staticGridValid && m_staticScratch == m_staticSolids.items()) {
+            return;
+        }
+        m_staticSolids.assign(m_staticScratch);
+        m_staticSolids.build(m_config.worldBounds);
+        m_staticGridValid = true;
+    }
+
+    // Remplit m_solidCandidates avec les obstacles solides de l’entité i qui
+    // touchent la boîte balayée : les statiques et les mobiles d’indice
+    // supérieur à i, triés par indice (ordre d’une boucle sur tous les indices).
+    // La boîte est légèrement élargie pour couvrir les arrondis des bornes.
+    void gatherSolidObstacles(std::size_t i, Aabb sweep) {
+        float pad = 1e-4f + 1e-6f * (std::max)({std::abs(sweep.left), std::abs(sweep.right),
+                                                std::abs(sweep.top), std::abs(sweep.bottom)});
+        sweep.left -= pad;
+        sweep.top -= pad;
+        sweep.right += pad;
+        sweep.bottom += pad;
+        m_solidCandidates.clear();
+        m_staticSolids.query(sweep, [&](std::size_t k) {
+            const SpatialGrid::Item &it = m_staticSolids.item(k);
+            if (it.id != i) {
+                m_solidCandidates.push_back(&it);
+            }
+        });
+        m_dynamicSolids.query(sweep, [&](std::size_t k) {
+            const SpatialGrid::Item &it = m_dynamicSolids.item(k);
+            if (it.id > i) {
+                m_solidCandidates.push_back(&it);
+            }
+        });
+        std::sort(m_solidCandidates.begin(), m_solidCandidates.end(),
+                  [](const SpatialGrid::Item *a, const SpatialGrid::Item *b) { return a->id < b->id; });
+    }
+
+    // ---------------------------------------------------------------------
+    // Intégration du mouvement (première passe)
+    //
+    // Convertit les entrées en vitesses, puis calcule en une passe sur le
+    // groupe Position/Velocity la position désirée de chaque entité mobile :
+    // position + vitesse × dt, plus le pas de son motif de déplacement.  Le
+    // groupe est traité par blocs de kMovementBlock entités, répartis sur le
+    // pool de threads : chaque bloc est copié dans des tableaux SoA pour le
+    // noyau simd::integrate(), puis écrit dans DesiredPosition.  Les positions
+    // désirées manquantes sont créées par le tampon de commandes.
+    void integrateMovement() {
+        ECS_PROFILE_SCOPE(m_registry.profiler(), m_profile.movement);
+        const auto &inputs    = readComponents<InputState>();
+        const auto &speeds    = readComponents<Speed>();
+        const auto &positions = readComponents<Position>();
+        auto &vels     = m_registry.get_components<Velocity>();
+        auto &desired  = m_registry.get_components<DesiredPosition>();
+        auto &patterns = m_registry.get_components<MovementPatternComp>();
+        // Axes de déplacement
+        for (auto [in, vel, spd] : ecs::views::zip(inputs, vels, speeds)) {
+            vel.x = in.moveX * spd.value;
+            vel.y = in.moveY * spd.value;
+        }
+        auto &moving = m_registry.group<Position, Velocity>();
+        const std::size_t total = moving.size();
+        m_registry.parallel_for((total + kMovementBlock - 1) / kMovementBlock, [&](std::size_t block) {
+            const std::size_t first = block * kMovementBlock;
+            const std::size_t n = (std::min)(kMovementBlock, total - first);
+            alignas(32) float x[kMovementBlock];
+            alignas(32) float y[kMovementBlock];
+            alignas(32) float vx[kMovementBlock];
+            alignas(32) float vy[kMovementBlock];
+            for (std::size_t i = 0; i < n; ++i) {
+                const Position &pos = moving.get<Position>(first + i);
+                const Velocity &vel = moving.get<Velocity>(first + i);
+                x[i]  = pos.x;
+                y[i]  = pos.y;
+                vx[i] = vel.x;
+                vy[i] = vel.y;
+            }
+            simd::integrate(x, y, vx, vy, m_dt, x, y, n);
+            for (std::size_t i = 0; i < n; ++i) {
+                ecs::entity_t ent{moving.entity_at(first + i)};
+                float newX = x[i];
+                float newY = y[i];
+                // contains() évite l’agrandissement des tableaux depuis plusieurs threads
+                if (patterns.contains(ent)) {
+                    advancePattern(*patterns[ent], newX, newY);
+                }
+                if (desired.contains(ent)) {
+                    auto &des = *desired[ent];
+                    des.x = newX;
+                    des.y = newY;
+                } else {
+                    m_registry.commands().emplace_component<DesiredPosition>(m_registry.entity_from_index(ent.value()),
+                                                                             newX, newY);
+                }
+            }
+        });
+        m_registry.flush_commands();
+        // Entités à motif sans vitesse : le pas décale leur position désirée
+        for (auto [idx, pat, pos] : ecs::views::indexed_zip(patterns, positions)) {
             ecs::entity_t ent{idx};
-            auto &posOpt = positions[ent];
-            auto &desOpt = desired[ent];
-            if (posOpt && desOpt) {
-                posOpt->x = desOpt->x;
-                posOpt->y = desOpt->y;
+            if (vels.contains(ent) || pat.offsets.empty()) {
+                continue;
             }
+            auto &desOpt = desired[ent];
+            float newX = desOpt ? desOpt->x : pos.x;
+            float newY = desOpt ? desOpt->y : pos.y;
+            advancePattern(pat, newX, newY);
+            desired.emplace_at(ent, newX, newY);
+        }
+    }
+
+    // Ajoute à (x, y) le pas courant du motif de déplacement, mis à l’échelle
+    // par dt, puis avance l’index du motif avec remise à zéro.
+    void advancePattern(MovementPatternComp &pat, float &x, float &y) const {
+        if (pat.offsets.empty()) {
+            return;
+        }
+        const auto &off = pat.offsets[pat.index];
+        x += off.first * m_dt;
+        y += off.second * m_dt;
+        ++pat.index;
+        if (pat.index >= pat.offsets.size()) {
+            pat.index = 0;
         }
     }
 
     // ---------------------------------------------------------------------
     // Application des dégâts : soustrait les dégâts accumulés et détruit les entités à 0 PV
     void applyDamage() {
+        ECS_PROFILE_SCOPE(m_registry.profiler(), m_profile.damage);
+        ECS_PROFILE_COUNTER(m_registry.profiler(), m_profile.pending, readComponents<PendingDamage>().dense_size());
+        // Sans dégâts en attente, les tableaux restent intacts (non marqués)
+        if (readComponents<PendingDamage>().dense_size() == 0) {
+            return;
+        }
         auto &pendings = m_registry.get_components<PendingDamage>();
         auto &healths  = m_registry.get_components<Health>();
-        std::vector<ecs::entity_t> toKill;
-        for (std::size_t idx = 0; idx < pendings.size(); ++idx) {
-            ecs::entity_t ent{idx};
-            auto &pdOpt = pendings[ent];
-            if (!pdOpt) {
-                continue;
-            }
-            int amount = pdOpt->amount;
+        auto &cmd = m_registry.commands();
+        for (std::size_t k = 0; k < pendings.dense_size(); ++k) {
+            ecs::entity_t ent{pendings.entities()[k]};
+            int amount = pendings.data()[k]->amount;
             auto &hOpt = healths[ent];
             if (hOpt) {
                 hOpt->value -= amount;
                 if (hOpt->value <= 0) {
-                    toKill.push_back(ent);
+                    cmd.kill(m_registry.entity_from_index(ent.value()));
                 }
             }
-            // Supprime le composant PendingDamage
-            pendings.erase(ent);
-        }
-        for (auto ent : toKill) {
-            m_registry.kill_entity(ent);
         }
+        // Supprime tous les composants PendingDamage
+        pendings.clear();
+        m_registry.flush_commands();
     }
 
     // ---------------------------------------------------------------------
-    // Limites jouables pour le joueur
+    // Fin du mouvement : limites jouables, validation et limites du monde
     //
-    // Serre la DesiredPosition du joueur dans la zone jouable définie dans la
-    // configuration.  Le serrage est appliqué indépendamment sur chaque axe et
-    // annule la composante de vitesse correspondante lorsque l’entité touche
-    // la frontière.  N’a aucun effet si la zone jouable est désactivée ou
-    // si aucune entité joueur n’existe (identifiée par faction 0 et nom
-    // d’archétype « player »).
-    void enforcePlayableBoundsForPlayer() {
-        const auto &bounds = m_config.playableBounds;
-        if (!bounds.enabled) {
-            return;
-        }
+    // Une seule passe par indice croissant.  Pour chaque entité qui possède
+    // une Position :
+    //  - le joueur (premier indice de faction 0 et d’archétype « player ») voit
+    //    sa DesiredPosition serrée dans la zone jouable si elle est activée ;
+    //  - la DesiredPosition, si présente, est copiée dans Position ;
+    //  - l’entité est supprimée si sa hitbox dépasse les limites du monde (ou,
+    //    sans hitbox, si son centre en sort), lorsqu’elles sont activées.
+    // Les suppressions passent par le tampon de commandes, appliqué après
+    // l’itération pour ne pas invalider les indices.
+    void commitMovement() {
+        ECS_PROFILE_SCOPE(m_registry.profiler(), m_profile.commit);
+        const auto &playable = m_config.playableBounds;
+        const auto &world    = m_config.worldBounds;
+        const auto &hitboxes = readComponents<Hitbox>();
+        const auto &factions = readComponents<Faction>();
+        const auto &archRefs = readComponents<ArchetypeRef>();
         auto &positions = m_registry.get_components<Position>();
         auto &desired   = m_registry.get_components<DesiredPosition>();
         auto &vels      = m_registry.get_components<Velocity>();
-        auto &hitboxes  = m_registry.get_components<Hitbox>();
-        auto &factions  = m_registry.get_components<Faction>();
-        auto &archRefs  = m_registry.get_components<ArchetypeRef>();
+        auto &cmd = m_registry.commands();
+        // Un seul joueur est attendu : le serrage s’arrête au premier trouvé
+        bool playerPending = playable.enabled;
         std::size_t count = positions.size();
         for (std::size_t idx = 0; idx < count; ++idx) {
             ecs::entity_t ent{idx};
-            auto &posOpt = positions[ent];
-            auto &desOpt = desired[ent];
-            auto &facOpt = factions[ent];
-            auto &archOpt= archRefs[ent];
-            if (!posOpt || !desOpt || !facOpt || !archOpt) {
-                continue;
-            }
-            // Vérifie si cette entité est le joueur : identifiant de faction 0 et nom d’archétype « player »
-            if (facOpt->id != 0) {
-                continue;
-            }
-            const Archetype* def = archOpt->def;
-            if (!def || def->name != "player") {
+            auto posOpt = positions[ent];
+            if (!posOpt) {
                 continue;
             }
-            // Joueur trouvé : serre sa position désirée
-            // Récupère les demi‑dimensions et décalages de la hitbox si disponible
-            float halfW = 0.f;
-            float halfH = 0.f;
-            float offX  = 0.f;
-            float offY  = 0.f;
             auto &hbOpt = hitboxes[ent];
-            if (hbOpt) {
-                halfW = hbOpt->halfWidth;
-                halfH = hbOpt->halfHeight;
-                offX  = hbOpt->offsetX;
-                offY  = hbOpt->offsetY;
-            }
-            // Calcule les bornes autorisées pour le centre de l’entité
-            float minX = bounds.minX + halfW - offX;
-            float maxX = bounds.maxX - halfW - offX;
-            float minY = bounds.minY + halfH - offY;
-            float maxY = bounds.maxY - halfH - offY;
-            // Applique le serrage et ajuste la vitesse si nécessaire
-            float newX = desOpt->x;
-            float newY = desOpt->y;
-            bool clampedX = false;
-            bool clampedY = false;
-            if (newX < minX) {
-                newX = minX;
-                clampedX = true;
-            } else if (newX > maxX) {
-                newX = maxX;
-                clampedX = true;
-            }
-            if (newY < minY) {
-                newY = minY;
-                clampedY = true;
-            } else if (newY > maxY) {
-                newY = maxY;
-                clampedY = true;
-            }
-            if (clampedX) {
-                desOpt->x = newX;
-                auto &velOpt = vels[ent];
-                if (velOpt) {
-                    velOpt->x = 0.f;
-                }
-            }
-            if (clampedY) {
-                desOpt->y = newY;
-                auto &velOpt = vels[ent];
-                if (velOpt) {
-                    velOpt->y = 0.f;
+            auto &desOpt = desired[ent];
+            if (desOpt) {
+                if (playerPending && isPlayer(factions[ent], archRefs[ent])) {
+                    auto velOpt = vels[ent];
+                    clampToPlayableBounds(*desOpt, velOpt ? &*velOpt : nullptr, hbOpt);
+                    playerPending = false;
                 }
+                posOpt->x = desOpt->x;
+                posOpt->y = desOpt->y;
             }
-            // Un seul joueur est attendu ; arrêt après traitement
-            break;
-        }
-    }
-
-    // ---------------------------------------------------------------------
-    // Suppression des entités hors des limites du monde
-    //
-    // Élimine les entités dont la hitbox dépasse les limites configurées (ou,
-    // sans hitbox, dont le centre sort de la zone).  Aucun traitement si les
-    // limites sont désactivées.  Les suppressions sont différées après
-    // l’itération pour éviter d’invalider les indices.
-    void cullOutsideWorldBounds() {
-        const auto &bounds = m_config.worldBounds;
-        if (!bounds.enabled) {
-            return;
-        }
-        auto &positions = m_registry.get_components<Position>();
-        auto &hitboxes  = m_registry.get_components<Hitbox>();
-        std::vector<ecs::entity_t> toKill;
-        std::size_t count = positions.size();
-        for (std::size_t idx = 0; idx < count; ++idx) {
-            ecs::entity_t ent{idx};
-            auto &posOpt = positions[ent];
-            if (!posOpt) {
+            if (!world.enabled) {
                 continue;
             }
             float left, right, top, bottom;
-            auto &hbOpt = hitboxes[ent];
             if (hbOpt) {
                 left   = posOpt->x + hbOpt->offsetX - hbOpt->halfWidth;
                 right  = posOpt->x + hbOpt->offsetX + hbOpt->halfWidth;
@@ -1109,12 +1558,55 @@ private:
                 left = right = posOpt->x;
                 top  = bottom = posOpt->y;
             }
-            if (left < bounds.minX || right > bounds.maxX || top < bounds.minY || bottom > bounds.maxY) {
-                toKill.push_back(ent);
+            if (left < world.minX || right > world.maxX || top < world.minY || bottom > world.maxY) {
+                cmd.kill(m_registry.entity_from_index(idx));
             }
         }
-        for (auto ent : toKill) {
-            m_registry.kill_entity(ent);
+        m_registry.flush_commands();
+    }
+
+    // Vrai pour l’entité joueur : identifiant de faction 0 et nom d’archétype « player ».
+    static bool isPlayer(const std::optional<Faction> &facOpt, const std::optional<ArchetypeRef> &archOpt) {
+        if (!facOpt || !archOpt || facOpt->id != 0) {
+            return false;
+        }
+        const Archetype* def = archOpt->def;
+        return def && def->name == "player";
+    }
+
+    // Serre la position désirée dans la zone jouable, en tenant compte des
+    // demi‑dimensions et décalages de la hitbox si elle existe.  Le serrage
+    // est appliqué indépendamment sur chaque axe et annule la composante de
+    // vitesse correspondante lorsque l’entité touche la frontière.
+    void clampToPlayableBounds(DesiredPosition &des, Velocity *vel,
+                               const std::optional<Hitbox> &hbOpt) const {
+        const auto &bounds = m_config.playableBounds;
+        float halfW = 0.f;
+        float halfH = 0.f;
+        float offX  = 0.f;
+        float offY  = 0.f;
+        if (hbOpt) {
+            halfW = hbOpt->halfWidth;
+            halfH = hbOpt->halfHeight;
+            offX  = hbOpt->offsetX;
+            offY  = hbOpt->offsetY;
+        }
+        // Bornes autorisées pour le centre de l’entité
+        float minX = bounds.minX + halfW - offX;
+        float maxX = bounds.maxX - halfW - offX;
+        float minY = bounds.minY + halfH - offY;
+        float maxY = bounds.maxY - halfH - offY;
+        if (des.x < minX || des.x > maxX) {
+            des.x = des.x < minX ? minX : maxX;
+            if (vel) {
+                vel->x = 0.f;
+            }
+        }
+        if (des.y < minY || des.y > maxY) {
+            des.y = des.y < minY ? minY : maxY;
+            if (vel) {
+                vel->y = 0.f;
+            }
         }
     }
 };
@@ -0,0 +1,161 @@
+// Rechargement à chaud de la configuration Lua : surveillance du fichier
+// source et comparaison de deux GameConfig.  L’application au moteur, entre
+// deux frames, est faite par Engine::reloadConfig() (engine.hpp).
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "engine/config_cache.hpp"
+#include "engine/resources.hpp"
+
+namespace engine {
+
+// Différences entre deux configurations, par catégorie de définitions.  Les
+// noms sont triés.
+struct ConfigDiff {
+    struct Names {
+        std::vector<std::string> added;
+        std::vector<std::string> removed;
+        std::vector<std::string> changed;
+
+        bool empty() const { return added.empty() && removed.empty() && changed.empty(); }
+    };
+
+    Names projectiles;
+    Names weapons;
+    Names archetypes;
+    // Limites du monde ou de la zone jouable modifiées
+    bool  boundsChanged = false;
+
+    bool empty() const {
+        return projectiles.empty() && weapons.empty() && archetypes.empty() && !boundsChanged;
+    }
+};
+
+namespace detail {
+
+// Deux définitions sont égales si leurs champs sérialisés le sont ; les champs
+// dérivés (identifiants, plans compilés) sont ainsi ignorés.
+template <typename Def>
+bool sameDefinition(const Def& a, const Def& b) {
+    CacheWriter wa;
+    CacheWriter wb;
+    wa(a);
+    wb(b);
+    return wa.bytes() == wb.bytes();
+}
+
+template <typename Def>
+ConfigDiff::Names diffDefinitions(const std::unordered_map<std::string, Def>& before,
+                                  const std::unordered_map<std::string, Def>& after) {
+    ConfigDiff::Names names;
+    for (const auto& [name, def] : after) {
+        auto it = before.find(name);
+        if (it == before.end()) {
+            names.added.push_back(name);
+        } else if (!sameDefinition(it->second, def)) {
+            names.changed.push_back(name);
+        }
+    }
+    for (const auto& kv : before) {
+        if (after.find(kv.first) == after.end()) {
+            names.removed.push_back(kv.first);
+        }
+    }
+    std::sort(names.added.begin(), names.added.end());
+    std::sort(names.removed.begin(), names.removed.end());
+    std::sort(names.changed.begin(), names.changed.end());
+    return names;
+}
+
+} // namespace detail
+
+// Compare deux configurations définition par définition.
+inline ConfigDiff diffGameConfig(const GameConfig& before, const GameConfig& after) {
+    ConfigDiff diff;
+    diff.projectiles = detail::diffDefinitions(before.projectiles, after.projectiles);
+    diff.weapons     = detail::diffDefinitions(before.weapons, after.weapons);
+    diff.archetypes  = detail::diffDefinitions(before.archetypes, after.archetypes);
+    diff.boundsChanged = !detail::sameDefinition(before.worldBounds, after.worldBounds) ||
+                         !detail::sameDefinition(before.playableBounds, after.playableBounds);
+    return diff;
+}
+
+// -----------------------------------------------------------------------------
+// Surveillance d’un fichier de configuration Lua.  poll() est peu coûteux
+// (une lecture de la date de modification) et peut être appelé à chaque frame :
+// le script n’est relu et exécuté que si son contenu a changé.
+//
+//     engine::ConfigWatcher watcher("config/game.lua");
+//     while (running) {
+//         if (auto cfg = watcher.poll()) {
+//             eng.reloadConfig(*cfg);
+//         }
+//         eng.update(dt);
+//     }
+// -----------------------------------------------------------------------------
+class ConfigWatcher {
+public:
+    // Mémorise l’état actuel du fichier ; la configuration en cours est
+    // supposée correspondre à ce contenu.
+    explicit ConfigWatcher(std::string luaPath) : m_path(std::move(luaPath)) {
+        std::error_code ec;
+        m_writeTime = std::filesystem::last_write_time(m_path, ec);
+        m_sourceHash = currentHash();
+    }
+
+    // Renvoie la nouvelle configuration si le contenu du fichier a changé et
+    // qu’elle se charge sans erreur.  En cas d’erreur Lua, lastError() la
+    // décrit et le fichier n’est relu qu’après une nouvelle modification.
+    std::optional<GameConfig> poll() {
+        std::error_code ec;
+        auto writeTime = std::filesystem::last_write_time(m_path, ec);
+        if (ec || writeTime == m_writeTime) {
+            return std::nullopt;
+        }
+        m_writeTime = writeTime;
+        const std::optional<std::uint64_t> hash = currentHash();
+        if (!hash || hash == m_sourceHash) {
+            return std::nullopt;
+        }
+        m_sourceHash = hash;
+        try {
+            GameConfig cfg = loadGameConfig(m_path);
+            m_lastError.clear();
+            return cfg;
+        } catch (const std::runtime_error& e) {
+            m_lastError = e.what();
+            return std::nullopt;
+        }
+    }
+
+    const std::string& path() const { return m_path; }
+    // Message de la dernière erreur de chargement (vide après un succès).
+    const std::string& lastError() const { return m_lastError; }
+
+private:
+    std::optional<std::uint64_t> currentHash() const {
+        try {
+            return hashGameConfigSource(m_path);
+        } catch (const std::runtime_error&) {
+            return std::nullopt;
+        }
+    }
+
+    std::string                     m_path;
+    std::filesystem::file_time_type m_writeTime{};
+    std::optional<std::uint64_t>    m_sourceHash;
+    std::string                     m_lastError;
+};
+
+} // namespace engine
@@ -0,0 +1,132 @@
+// Journal des entrées par pas, pour la re-simulation déterministe : après
+// Engine::restoreState(), rejouer les entrées enregistrées à partir du pas
+// rétabli redonne exactement la même simulation.  Seules les entités pilotées
+// de l’extérieur (joueurs locaux ou distants) y figurent : les entrées
+// écrites par l’IA pendant un pas se recalculent d’elles-mêmes.
+//
+//     engine::InputLog log;
+//     std::array<engine::WorldState, 16> states;
+//     auto stepOnce = [&] {
+//         eng.saveState(states[eng.tickCount() % states.size()]);
+//         log.apply(eng, eng.tickCount());
+//         eng.step();
+//     };
+//     // À chaque pas :
+//     log.record(eng.tickCount(), player, input);
+//     stepOnce();
+//     // Entrée tardive pour un pas passé (moins de 16 pas) : retour à l’état
+//     // de ce pas, puis re-simulation jusqu’au pas courant
+//     log.record(pastTick, remote, lateInput);
+//     const std::uint64_t now = eng.tickCount();
+//     eng.restoreState(states[pastTick % states.size()]);
+//     while (eng.tickCount() < now) {
+//         stepOnce();
+//     }
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine/engine.hpp"
+
+namespace engine {
+
+class InputLog {
+public:
+    struct Entry {
+        std::uint64_t tick = 0;
+        ecs::entity_t entity;
+        InputState    input;
+    };
+
+    // Enregistre l’entrée d’une entité pour un pas ; remplace celle déjà
+    // enregistrée pour ce pas et cette entité.  Les entrées sont gardées
+    // triées par pas puis par indice d’entité : un ajout en fin de journal
+    // (pas courant) ne déplace rien.
+    void record(std::uint64_t tick, ecs::entity_t entity, const InputState& input) {
+        auto it = lowerBound(tick, entity.value());
+        if (it != m_entries.end() && it->tick == tick && it->entity.value() == entity.value()) {
+            it->entity = entity;
+            it->input = input;
+            return;
+        }
+        m_entries.insert(it, Entry{tick, entity, input});
+    }
+
+    // Écrit dans le registre les entrées enregistrées pour ce pas, sur les
+    // entités encore vivantes qui possèdent un InputState.
+    void apply(Engine& eng, std::uint64_t tick) const {
+        ecs::registry& reg = eng.getRegistry();
+        auto first = lowerBound(tick, 0);
+        if (first == m_entries.end() || first->tick != tick) {
+            return;
+        }
+        auto& inputs = reg.get_components<InputState>();
+        for (auto it = first; it != m_entries.end() && it->tick == tick; ++it) {
+            if (reg.is_alive(it->entity) && inputs.contains(it->entity)) {
+                *inputs[it->entity] = it->input;
+            }
+        }
+    }
+
+    // Rejoue les pas jusqu’à ce que eng.tickCount() atteigne untilTick :
+    // applique les entrées de chaque pas puis appelle eng.update(dt).  dt
+    // doit être celui de la simulation d’origine (fixedTimestep() pour
+    // step() et advance()).
+    void replay(Engine& eng, std::uint64_t untilTick, float dt) const {
+        while (eng.tickCount() < untilTick) {
+            apply(eng, eng.tickCount());
+            eng.update(dt);
+        }
+    }
+
+    // Variante au pas fixe du moteur.
+    void replay(Engine& eng, std::uint64_t untilTick) const { replay(eng, untilTick, eng.fixedTimestep()); }
+
+    // Oublie les entrées des pas antérieurs à tick (plus aucun état capturé
+    // ne permet d’y revenir).
+    void discardBefore(std::uint64_t tick) {
+        m_entries.erase(m_entries.begin(), lowerBound(tick, 0));
+    }
+
+    // Oublie les entrées à partir du pas tick inclus.
+    void discardFrom(std::uint64_t tick) { m_entries.erase(lowerBound(tick, 0), m_entries.end()); }
+
+    void clear() { m_entries.clear(); }
+    bool empty() const { return m_entries.empty(); }
+    std::size_t size() const { return m_entries.size(); }
+
+    // Entrées triées par pas puis par indice d’entité.
+    const std::vector<Entry>& entries() const { return m_entries; }
+
+private:
+    using Iterator = std::vector<Entry>::iterator;
+    using ConstIterator = std::vector<Entry>::const_iterator;
+
+    static bool before(const Entry& e, std::uint64_t tick, ecs::entity_t::value_type index) {
+        return e.tick < tick || (e.tick == tick && e.entity.value() < index);
+    }
+
+    Iterator lowerBound(std::uint64_t tick, ecs::entity_t::value_type index) {
+        // Cas courant : le pas enregistré suit la dernière entrée
+        if (m_entries.empty() || before(m_entries.back(), tick, index)) {
+            return m_entries.end();
+        }
+        return std::lower_bound(m_entries.begin(), m_entries.end(), tick, [&](const Entry& e, std::uint64_t t) {
+            return before(e, t, index);
+        });
+    }
+
+    ConstIterator lowerBound(std::uint64_t tick, ecs::entity_t::value_type index) const {
+        return std::lower_bound(m_entries.begin(), m_entries.end(), tick, [&](const Entry& e, std::uint64_t t) {
+            return before(e, t, index);
+        });
+    }
+
+    std::vector<Entry> m_entries;
+};
+
+} // namespace engine
@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -81,6 +83,26 @@ struct WeaponDef {
     } charge;
 };
 
+// Mode de sélection d’une catégorie de cibles : la première par indice d’entité, ou la plus proche.
+enum class TargetMode : std::uint8_t {
+    First,
+    Closest
+};
+
+// Catégorie de cibles compilée : identifiant d’archétype et mode de sélection.
+struct TargetPlanEntry {
+    int        archetypeId = -1;
+    TargetMode mode        = TargetMode::First;
+};
+
+// Ordre de priorité compilé d’un archétype.  Les catégories qui ne désignent
+// aucun archétype connu sont retirées ; nearestIfEmpty indique que l’ordre
+// configuré est vide et que l’IA vise alors l’ennemi le plus proche.
+struct TargetPlan {
+    std::vector<TargetPlanEntry> entries;
+    bool nearestIfEmpty = true;
+};
+
 // Définition d’un archétype : modèle pour générer des entités avec options (réapparition,
 // santé initiale, collision, vitesse, direction par défaut, cibles, portée,
 // arme et motif de mouvement).
@@ -109,6 +131,10 @@ struct Archetype {
     // la cible la plus proche est choisie.
     std::vector<std::string> targetOrder;
     std::unordered_map<std::string, std::string> targetMode;
+    // Forme compilée des deux champs précédents, utilisée par l’IA (voir compileGameConfig)
+    TargetPlan  targetPlan;
+    // Identifiant entier de l’archétype (rang de son nom dans l’ordre lexicographique), -1 avant compilation
+    int         id           = -1;
 
     // --- Extensions épines ---
     // Active des dégâts de contact ; thornsDamage indique la valeur infligée.
@@ -121,6 +147,8 @@ struct GameConfig {
     std::unordered_map<std::string, ProjectileDef> projectiles;
     std::unordered_map<std::string, WeaponDef>     weapons;
     std::unordered_map<std::string, Archetype>     archetypes;
+    // Noms des archétypes indexés par identifiant (rempli par compileGameConfig)
+    std::vector<std::string>                       archetypeNames;
 
     // ---------------------------------------------------------------------
     // Limites optionnelles du monde et de la zone jouable
@@ -529,6 +557,43 @@ inline void readArchetypes(lua_State* L, int index, GameConfig& cfg) {
 
 } // namespace detail
 
+// -----------------------------------------------------------------------------
+// compileGameConfig
+//
+// Attribue à chaque archétype un identifiant entier (rang de son nom trié, donc
+// indépendant de l’ordre de la table de hachage) et compile targetOrder et
+// targetMode en TargetPlan.  Appelée par loadGameConfig() ; à rappeler après
+// toute modification manuelle des archétypes.  Idempotente.
+// -----------------------------------------------------------------------------
+inline void compileGameConfig(GameConfig& cfg) {
+    cfg.archetypeNames.clear();
+    cfg.archetypeNames.reserve(cfg.archetypes.size());
+    for (const auto& kv : cfg.archetypes) {
+        cfg.archetypeNames.push_back(kv.first);
+    }
+    std::sort(cfg.archetypeNames.begin(), cfg.archetypeNames.end());
+    for (std::size_t i = 0; i < cfg.archetypeNames.size(); ++i) {
+        cfg.archetypes[cfg.archetypeNames[i]].id = static_cast<int>(i);
+    }
+    for (auto& kv : cfg.archetypes) {
+        Archetype& arch = kv.second;
+        arch.targetPlan.entries.clear();
+        arch.targetPlan.nearestIfEmpty = arch.targetOrder.empty();
+        for (const std::string& cat : arch.targetOrder) {
+            auto ait = cfg.archetypes.find(cat);
+            if (ait == cfg.archetypes.end()) {
+                continue;
+            }
+            TargetMode mode = TargetMode::First;
+            auto mit = arch.targetMode.find(cat);
+            if (mit != arch.targetMode.end() && (mit->second == "closest_in_class" || mit->second == "closest")) {
+                mode = TargetMode::Closest;
+            }
+            arch.targetPlan.entries.push_back(TargetPlanEntry{ait->second.id, mode});
+        }
+    }
+}
+
 // -----------------------------------------------------------------------------
 // loadGameConfig
 //
@@ -623,6 +688,7 @@ inline GameConfig loadGameConfig(const std::string& filename) {
     }
     lua_pop(L, 1);
     lua_close(L);
+    compileGameConfig(cfg);
     return cfg;
 }
 
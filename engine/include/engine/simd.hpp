@@ -0,0 +1,136 @@
+// Noyaux vectoriels du moteur : boucles sur des tableaux de flottants (SoA),
+// en AVX, SSE2 ou NEON selon la cible de compilation, avec repli scalaire pour
+// les autres cibles et pour les éléments restants.  Chaque noyau effectue les
+// mêmes opérations flottantes, dans le même ordre, que son équivalent
+// scalaire : les résultats sont identiques au bit près quel que soit le
+// chemin (à condition que le compilateur ne fusionne pas multiplication et
+// addition, voir -ffp-contract=off dans CMakeLists.txt).
+//
+// Définir ENGINE_SIMD_SCALAR force le chemin scalaire.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(ENGINE_SIMD_SCALAR)
+#if defined(__AVX__)
+#define ENGINE_SIMD_AVX 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENGINE_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define ENGINE_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
+namespace engine::simd {
+
+// Jeu d’instructions retenu à la compilation.
+#if defined(ENGINE_SIMD_AVX)
+inline constexpr const char* kBackend = "avx";
+inline constexpr std::size_t kLanes = 8;
+#elif defined(ENGINE_SIMD_SSE2)
+inline constexpr const char* kBackend = "sse2";
+inline constexpr std::size_t kLanes = 4;
+#elif defined(ENGINE_SIMD_NEON)
+inline constexpr const char* kBackend = "neon";
+inline constexpr std::size_t kLanes = 4;
+#else
+inline constexpr const char* kBackend = "scalar";
+inline constexpr std::size_t kLanes = 1;
+#endif
+
+// Intégration d’Euler explicite : outX[i] = x[i] + vx[i] * dt (idem en Y),
+// pour i dans [0, n).  Les sorties peuvent recouvrir exactement les entrées.
+inline void integrate(const float* x, const float* y, const float* vx, const float* vy, float dt,
+                      float* outX, float* outY, std::size_t n) {
+    std::size_t i = 0;
+#if defined(ENGINE_SIMD_AVX)
+    const __m256 step = _mm256_set1_ps(dt);
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(outX + i, _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_mul_ps(_mm256_loadu_ps(vx + i), step)));
+        _mm256_storeu_ps(outY + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(_mm256_loadu_ps(vy + i), step)));
+    }
+#elif defined(ENGINE_SIMD_SSE2)
+    const __m128 step = _mm_set1_ps(dt);
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(outX + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(_mm_loadu_ps(vx + i), step)));
+        _mm_storeu_ps(outY + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(_mm_loadu_ps(vy + i), step)));
+    }
+#elif defined(ENGINE_SIMD_NEON)
+    // Multiplication et addition séparées (et non vmlaq/vfmaq) : même arrondi
+    // que le chemin scalaire
+    const float32x4_t step = vdupq_n_f32(dt);
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(outX + i, vaddq_f32(vld1q_f32(x + i), vmulq_f32(vld1q_f32(vx + i), step)));
+        vst1q_f32(outY + i, vaddq_f32(vld1q_f32(y + i), vmulq_f32(vld1q_f32(vy + i), step)));
+    }
+#endif
+    for (; i < n; ++i) {
+        outX[i] = x[i] + vx[i] * dt;
+        outY[i] = y[i] + vy[i] * dt;
+    }
+}
+
+// Test de chevauchement d’une boîte contre un lot de n boîtes (n <= 32)
+// rangées en SoA : le bit i du résultat vaut 1 si la boîte i chevauche
+// (left, top, right, bottom).  Test inclusif, identique à Aabb::intersects() :
+// !(left > rights[i] || right < lefts[i] || top > bottoms[i] || bottom < tops[i]).
+inline std::uint32_t overlapMask(float left, float top, float right, float bottom,
+                                 const float* lefts, const float* tops, const float* rights, const float* bottoms,
+                                 std::size_t n) {
+    std::uint32_t mask = 0;
+    std::size_t i = 0;
+#if defined(ENGINE_SIMD_AVX)
+    const __m256 l = _mm256_set1_ps(left);
+    const __m256 t = _mm256_set1_ps(top);
+    const __m256 r = _mm256_set1_ps(right);
+    const __m256 b = _mm256_set1_ps(bottom);
+    for (; i + 8 <= n; i += 8) {
+        // Comparaisons ordonnées : fausses avec NaN, comme en scalaire
+        __m256 apart = _mm256_or_ps(_mm256_cmp_ps(l, _mm256_loadu_ps(rights + i), _CMP_GT_OQ),
+                                    _mm256_cmp_ps(r, _mm256_loadu_ps(lefts + i), _CMP_LT_OQ));
+        apart = _mm256_or_ps(apart, _mm256_or_ps(_mm256_cmp_ps(t, _mm256_loadu_ps(bottoms + i), _CMP_GT_OQ),
+                                                 _mm256_cmp_ps(b, _mm256_loadu_ps(tops + i), _CMP_LT_OQ)));
+        mask |= (~static_cast<std::uint32_t>(_mm256_movemask_ps(apart)) & 0xFFu) << i;
+    }
+#elif defined(ENGINE_SIMD_SSE2)
+    const __m128 l = _mm_set1_ps(left);
+    const __m128 t = _mm_set1_ps(top);
+    const __m128 r = _mm_set1_ps(right);
+    const __m128 b = _mm_set1_ps(bottom);
+    for (; i + 4 <= n; i += 4) {
+        __m128 apart = _mm_or_ps(_mm_cmpgt_ps(l, _mm_loadu_ps(rights + i)), _mm_cmplt_ps(r, _mm_loadu_ps(lefts + i)));
+        apart = _mm_or_ps(apart, _mm_or_ps(_mm_cmpgt_ps(t, _mm_loadu_ps(bottoms + i)),
+                                           _mm_cmplt_ps(b, _mm_loadu_ps(tops + i))));
+        mask |= (~static_cast<std::uint32_t>(_mm_movemask_ps(apart)) & 0xFu) << i;
+    }
+#elif defined(ENGINE_SIMD_NEON)
+    const float32x4_t l = vdupq_n_f32(left);
+    const float32x4_t t = vdupq_n_f32(top);
+    const float32x4_t r = vdupq_n_f32(right);
+    const float32x4_t b = vdupq_n_f32(bottom);
+    static const std::uint32_t kLaneBits[4] = {1u, 2u, 4u, 8u};
+    const uint32x4_t laneBits = vld1q_u32(kLaneBits);
+    for (; i + 4 <= n; i += 4) {
+        uint32x4_t apart = vorrq_u32(vcgtq_f32(l, vld1q_f32(rights + i)), vcltq_f32(r, vld1q_f32(lefts + i)));
+        apart = vorrq_u32(apart, vorrq_u32(vcgtq_f32(t, vld1q_f32(bottoms + i)), vcltq_f32(b, vld1q_f32(tops + i))));
+        // Équivalent de movemask : somme des bits des voies qui se chevauchent
+        const uint32x4_t hit = vandq_u32(vmvnq_u32(apart), laneBits);
+        uint32x2_t sum = vadd_u32(vget_low_u32(hit), vget_high_u32(hit));
+        sum = vpadd_u32(sum, sum);
+        mask |= vget_lane_u32(sum, 0) << i;
+    }
+#endif
+    for (; i < n; ++i) {
+        if (!(left > rights[i] || right < lefts[i] || top > bottoms[i] || bottom < tops[i])) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+} // namespace engine::simd
@@ -0,0 +1,134 @@
+// Construction des snapshots réseau depuis le registre du moteur : un seul
+// parcours des entités qui ont une Position, écrit directement sous forme
+// quantifiée dans le tampon d’état de net::Server (beginSnapshot()), sans
+// vecteur de net::SnapshotEntity intermédiaire.  Les entités sont produites
+// par indice croissant : le serveur n’a pas à les trier.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine/engine.hpp"
+#include "net/net.hpp"
+
+namespace engine {
+
+// État d’une entité fixé à sa création (type d’archétype, hitbox,
+// Respawnable) : mis en cache par indice et relu seulement quand la
+// génération ou l’archétype de l’entité change.  Après une modification de
+// Hitbox ou de Respawnable sur une entité existante, appeler invalidate().
+//
+//     engine::SnapshotBuilder builder;
+//     while (running) {
+//         eng.step();
+//         builder.broadcast(eng, server, frame, controlledIds);
+//     }
+class SnapshotBuilder {
+public:
+    // Remplace le contenu de out par l’état quantifié des entités qui ont une
+    // Position, triées par identifiant (indice de l’entité).  type vaut
+    // Archetype::id + 1 (0 sans archétype) et generation la génération du
+    // handle, tronquée à 16 bits.
+    void build(const Engine& eng, std::vector<net::QuantizedEntity>& out) {
+        const ecs::registry& reg = eng.getRegistry();
+        const auto& positions    = reg.get_components<Position>();
+        const auto& velocities   = reg.get_components<Velocity>();
+        const auto& healths      = reg.get_components<Health>();
+        const auto& hitboxes     = reg.get_components<Hitbox>();
+        const auto& respawnables = reg.get_components<Respawnable>();
+        const auto& archetypes   = reg.get_components<ArchetypeRef>();
+
+        out.clear();
+        out.reserve(positions.dense_size());
+        if (m_cache.size() < positions.size()) {
+            m_cache.resize(positions.size());
+        }
+        for (std::size_t idx = 0; idx < positions.size(); ++idx) {
+            const ecs::entity_t ent = reg.entity_from_index(idx);
+            const auto& posOpt = positions[ent];
+            if (!posOpt) {
+                continue;
+            }
+            const auto& archOpt = archetypes[ent];
+            const Archetype* def = archOpt ? archOpt->def : nullptr;
+            Cached& cached = m_cache[idx];
+            if (!cached.valid || cached.generation != ent.generation() || cached.archetype != def) {
+                cached = Cached{};
+                cached.valid = true;
+                cached.generation = ent.generation();
+                cached.archetype = def;
+                cached.type = def ? static_cast<std::uint16_t>(def->id + 1) : 0;
+                if (const auto& hitOpt = hitboxes[ent]) {
+                    cached.state |= net::STATE_COLLISION;
+                    cached.hitHalfWidth = net::quantize(hitOpt->halfWidth);
+                    cached.hitHalfHeight = net::quantize(hitOpt->halfHeight);
+                }
+                if (const auto& respOpt = respawnables[ent]; respOpt && respOpt->value) {
+                    cached.state |= net::STATE_RESPAWNABLE;
+                }
+            }
+
+            net::QuantizedEntity& q = out.emplace_back();
+            q.id = static_cast<std::uint32_t>(idx);
+            q.generation = static_cast<std::uint16_t>(ent.generation());
+            q.type = cached.type;
+            q.state = static_cast<std::uint8_t>(net::STATE_ALIVE | net::STATE_POSITION | cached.state);
+            q.x = net::quantize(posOpt->x);
+            q.y = net::quantize(posOpt->y);
+            if (const auto& velOpt = velocities[ent]) {
+                q.state |= net::STATE_VELOCITY;
+                q.vx = net::quantize(velOpt->x);
+                q.vy = net::quantize(velOpt->y);
+            }
+            if (const auto& hpOpt = healths[ent]) {
+                q.state |= net::STATE_HEALTH;
+                q.health = net::quantize(static_cast<float>(hpOpt->value));
+            }
+            q.hitHalfWidth = cached.hitHalfWidth;
+            q.hitHalfHeight = cached.hitHalfHeight;
+        }
+    }
+
+    // Construit l’état dans le tampon du serveur et l’envoie à tous les
+    // clients actifs (net::Server::broadcastPreparedSnapshot()).
+    void broadcast(const Engine& eng, net::Server& server, std::uint32_t packedFrameData,
+                   const std::vector<std::uint32_t>& controlledIds) {
+        build(eng, server.beginSnapshot());
+        server.broadcastPreparedSnapshot(packedFrameData, controlledIds);
+    }
+
+    // Construit l’état dans le tampon du serveur et l’envoie à un client.
+    void send(const Engine& eng, net::Server& server, std::size_t slotIndex, std::uint32_t packedFrameData,
+              std::uint32_t controlledId) {
+        build(eng, server.beginSnapshot());
+        server.sendPreparedSnapshot(slotIndex, packedFrameData, controlledId);
+    }
+
+    // Oublie l’état mis en cache pour cette entité.
+    void invalidate(ecs::entity_t e) {
+        if (e.value() < m_cache.size()) {
+            m_cache[e.value()].valid = false;
+        }
+    }
+
+    // Oublie tout l’état mis en cache.
+    void clear() { m_cache.clear(); }
+
+private:
+    struct Cached {
+        bool                           valid = false;
+        ecs::entity_t::generation_type generation = 0;
+        const Archetype*               archetype = nullptr;
+        std::uint16_t                  type = 0;
+        // Bits STATE_COLLISION et STATE_RESPAWNABLE
+        std::uint8_t                   state = 0;
+        std::int32_t                   hitHalfWidth = 0;
+        std::int32_t                   hitHalfHeight = 0;
+    };
+
+    std::vector<Cached> m_cache;
+};
+
+} // namespace engine
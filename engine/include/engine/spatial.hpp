@@ -0,0 +1,284 @@
+// Index spatial du moteur : grille uniforme reconstruite à chaque frame pour la
+// phase large des collisions.  Les éléments sont rangés par cellule (tri par
+// comptage) dans des tableaux réutilisés : après quelques frames, la
+// reconstruction ne provoque plus d’allocation.  Les boîtes de chaque cellule
+// sont aussi rangées en SoA, pour que la phase étroite teste une boîte contre
+// un lot de candidates avec simd::overlapMask().
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "engine/resources.hpp"
+#include "engine/simd.hpp"
+
+namespace engine {
+
+// Boîte englobante alignée sur les axes, en coordonnées monde.
+struct Aabb {
+    float left   = 0.f;
+    float top    = 0.f;
+    float right  = 0.f;
+    float bottom = 0.f;
+
+    // Intersection inclusive : deux boîtes qui se touchent se chevauchent.
+    bool intersects(const Aabb& o) const {
+        return !(left > o.right || right < o.left || top > o.bottom || bottom < o.top);
+    }
+
+    bool operator==(const Aabb&) const = default;
+};
+
+// -----------------------------------------------------------------------------
+// Grille uniforme couvrant les limites du monde (ou, si elles sont désactivées,
+// l’union des boîtes insérées).  La taille de cellule vaut deux fois la
+// dimension moyenne des boîtes, bornée pour limiter le nombre de cellules ; les
+// éléments hors de la grille sont rattachés aux cellules du bord.
+// -----------------------------------------------------------------------------
+class SpatialGrid {
+public:
+    struct Item {
+        std::size_t   id;
+        Aabb          box;
+        std::uint32_t layer;
+        std::uint32_t mask;
+
+        bool operator==(const Item&) const = default;
+    };
+
+    // Paire d’indices d’éléments (premier < second).
+    using Pair = std::pair<std::uint32_t, std::uint32_t>;
+
+    // Nombre maximal de cellules par axe.
+    static constexpr int kMaxCellsPerAxis = 256;
+    // Nombre de boîtes candidates testées par appel à simd::overlapMask().
+    static constexpr std::size_t kOverlapBatch = 16;
+
+    // Vide la grille ; les capacités sont conservées.
+    void clear() { m_items.clear(); }
+
+    // Ajoute un élément.  Les éléments doivent être insérés par id croissant
+    // pour que collectPairs() respecte l’ordre des ids.
+    void insert(std::size_t id, const Aabb& box, std::uint32_t layer, std::uint32_t mask) {
+        m_items.push_back(Item{id, box, layer, mask});
+    }
+
+    std::size_t size() const { return m_items.size(); }
+    const Item& item(std::size_t i) const { return m_items[i]; }
+    const std::vector<Item>& items() const { return m_items; }
+
+    // Remplace les éléments par ceux de items (échange des stockages) ; build()
+    // doit être rappelé ensuite.
+    void assign(std::vector<Item>& items) { m_items.swap(items); }
+
+    // Range les éléments insérés dans les cellules ; minCellSize impose une
+    // taille de cellule minimale (utile pour des éléments ponctuels interrogés
+    // par rayon).
+    void build(const GameConfig::Bounds& bounds, float minCellSize = 0.f) {
+        float minX = bounds.minX, minY = bounds.minY, maxX = bounds.maxX, maxY = bounds.maxY;
+        double sumExtent = 0.0;
+        if (!bounds.enabled && !m_items.empty()) {
+            minX = minY = std::numeric_limits<float>::max();
+            maxX = maxY = std::numeric_limits<float>::lowest();
+        }
+        for (const Item& it : m_items) {
+            if (!bounds.enabled) {
+                minX = (std::min)(minX, it.box.left);
+                minY = (std::min)(minY, it.box.top);
+                maxX = (std::max)(maxX, it.box.right);
+                maxY = (std::max)(maxY, it.box.bottom);
+            }
+            sumExtent += (std::max)(it.box.right - it.box.left, it.box.bottom - it.box.top);
+        }
+        float width  = (std::max)(maxX - minX, 0.f);
+        float height = (std::max)(maxY - minY, 0.f);
+        float cell = m_items.empty() ? 0.f : static_cast<float>(2.0 * sumExtent / static_cast<double>(m_items.size()));
+        cell = (std::max)(cell, (std::max)(width, height) / static_cast<float>(kMaxCellsPerAxis));
+        cell = (std::max)(cell, minCellSize);
+        if (!(cell > 0.f)) {
+            cell = 1.f;
+        }
+        m_originX = minX;
+        m_originY = minY;
+        m_invCell = 1.f / cell;
+        m_cols = std::clamp(static_cast<int>(std::ceil(width * m_invCell)), 1, kMaxCellsPerAxis);
+        m_rows = std::clamp(static_cast<int>(std::ceil(height * m_invCell)), 1, kMaxCellsPerAxis);
+
+        // Tri par comptage : nombre d’éléments par cellule, puis remplissage
+        const std::size_t cellCount = static_cast<std::size_t>(m_cols) * static_cast<std::size_t>(m_rows);
+        m_cellStart.assign(cellCount + 1, 0);
+        for (const Item& it : m_items) {
+            forEachCell(it.box, [&](std::size_t c) { ++m_cellStart[c + 1]; });
+        }
+        for (std::size_t c = 0; c < cellCount; ++c) {
+            m_cellStart[c + 1] += m_cellStart[c];
+        }
+        const std::size_t entries = m_cellStart[cellCount];
+        m_cellItems.resize(entries);
+        m_cellLeft.resize(entries);
+        m_cellTop.resize(entries);
+        m_cellRight.resize(entries);
+        m_cellBottom.resize(entries);
+        m_fill.assign(m_cellStart.begin(), m_cellStart.end() - 1);
+        for (std::size_t i = 0; i < m_items.size(); ++i) {
+            const Aabb &box = m_items[i].box;
+            forEachCell(box, [&](std::size_t c) {
+                const std::uint32_t k = m_fill[c]++;
+                m_cellItems[k]  = static_cast<std::uint32_t>(i);
+                m_cellLeft[k]   = box.left;
+                m_cellTop[k]    = box.top;
+                m_cellRight[k]  = box.right;
+                m_cellBottom[k] = box.bottom;
+            });
+        }
+    }
+
+    // Remplit out avec les paires d’éléments dont les boîtes se chevauchent et
+    // dont les filtres couche/masque s’acceptent (dans un sens au moins).  Les
+    // paires sont triées par (premier, second) ; avec des éléments insérés par
+    // id croissant, l’ordre est celui d’une double boucle sur les ids.
+    void collectPairs(std::vector<Pair>& out) const {
+        out.clear();
+        for (int cy = 0; cy < m_rows; ++cy) {
+            for (int cx = 0; cx < m_cols; ++cx) {
+                const std::size_t c = static_cast<std::size_t>(cy) * static_cast<std::size_t>(m_cols) + static_cast<std::size_t>(cx);
+                const std::uint32_t begin = m_cellStart[c];
+                const std::uint32_t end   = m_cellStart[c + 1];
+                for (std::uint32_t i = begin; i < end; ++i) {
+                    const std::uint32_t a = m_cellItems[i];
+                    const Item& A = m_items[a];
+                    // Les boîtes suivantes de la cellule sont testées par lots ;
+                    // seules les candidates qui chevauchent A sont examinées
+                    forEachOverlap(A.box, i + 1, end, [&](std::uint32_t j) {
+                        const std::uint32_t b = m_cellItems[j];
+                        const Item& B = m_items[b];
+                        // Filtre couche/masque
+                        if ((A.mask & B.layer) == 0 && (B.mask & A.layer) == 0) {
+                            return;
+                        }
+                        // Une paire partage plusieurs cellules ; seule celle qui
+                        // contient le coin minimal de l’intersection la rapporte
+                        if (cellX((std::max)(A.box.left, B.box.left)) != cx ||
+                            cellY((std::max)(A.box.top, B.box.top)) != cy) {
+                            return;
+                        }
+                        out.emplace_back(a, b);
+                    });
+                }
+            }
+        }
+        std::sort(out.begin(), out.end());
+    }
+
+    // Appelle fn(indice d’élément) une seule fois pour chaque élément dont la
+    // boîte chevauche box (test inclusif).  L’ordre suit les cellules ; trier
+    // les résultats pour un ordre par id.  La grille doit avoir été construite.
+    template <typename Function>
+    void query(const Aabb& box, Function&& fn) const {
+        if (m_items.empty() || m_cellStart.empty()) {
+            return;
+        }
+        const int x0 = cellX(box.left), x1 = cellX(box.right);
+        const int y0 = cellY(box.top),  y1 = cellY(box.bottom);
+        for (int cy = y0; cy <= y1; ++cy) {
+            for (int cx = x0; cx <= x1; ++cx) {
+                const std::size_t c = static_cast<std::size_t>(cy) * static_cast<std::size_t>(m_cols) + static_cast<std::size_t>(cx);
+                forEachOverlap(box, m_cellStart[c], m_cellStart[c + 1], [&](std::uint32_t k) {
+                    const std::uint32_t i = m_cellItems[k];
+                    const Aabb& b = m_items[i].box;
+                    // Même règle que collectPairs() : rapporté par une seule cellule
+                    if (cellX((std::max)(b.left, box.left)) != cx || cellY((std::max)(b.top, box.top)) != cy) {
+                        return;
+                    }
+                    fn(static_cast<std::size_t>(i));
+                });
+            }
+        }
+    }
+
+    // Appelle fn(indice d’élément, distance au carré) pour chaque élément dont
+    // le centre est à une distance au plus radius de (x, y).  La distance est
+    // calculée comme dx * dx + dy * dy et comparée à radius * radius.
+    template <typename Function>
+    void queryRadius(float x, float y, float radius, Function&& fn) const {
+        const float maxDistSq = radius * radius;
+        // Boîte de recherche légèrement élargie pour couvrir les arrondis
+        const float reach = radius + 1e-4f + 1e-6f * (std::max)(std::abs(x), std::abs(y));
+        query(Aabb{x - reach, y - reach, x + reach, y + reach}, [&](std::size_t i) {
+            const Aabb& b = m_items[i].box;
+            const float dx = (b.left + b.right) * 0.5f - x;
+            const float dy = (b.top + b.bottom) * 0.5f - y;
+            const float distSq = dx * dx + dy * dy;
+            if (distSq <= maxDistSq) {
+                fn(i, distSq);
+            }
+        });
+    }
+
+private:
+    // Cellule d’une coordonnée, bornée à la grille (le bornage en flottant
+    // évite tout dépassement lors de la conversion).
+    static int toCell(float v, int count) {
+        float c = std::floor(v);
+        if (!(c > 0.f)) {
+            return 0;
+        }
+        return c >= static_cast<float>(count - 1) ? count - 1 : static_cast<int>(c);
+    }
+    int cellX(float x) const { return toCell((x - m_originX) * m_invCell, m_cols); }
+    int cellY(float y) const { return toCell((y - m_originY) * m_invCell, m_rows); }
+
+    // Appelle fn(k), par k croissant, pour chaque entrée k de [first, last) de
+    // m_cellItems dont la boîte chevauche box (test inclusif, comme
+    // Aabb::intersects()).  Les entrées sont testées par lots de kOverlapBatch.
+    template <typename Function>
+    void forEachOverlap(const Aabb& box, std::uint32_t first, std::uint32_t last, Function&& fn) const {
+        for (std::uint32_t base = first; base < last; base += kOverlapBatch) {
+            const std::size_t n = (std::min)(static_cast<std::size_t>(last - base), kOverlapBatch);
+            std::uint32_t hits = simd::overlapMask(box.left, box.top, box.right, box.bottom, m_cellLeft.data() + base,
+                                                   m_cellTop.data() + base, m_cellRight.data() + base,
+                                                   m_cellBottom.data() + base, n);
+            while (hits != 0) {
+                fn(base + static_cast<std::uint32_t>(std::countr_zero(hits)));
+                hits &= hits - 1;
+            }
+        }
+    }
+
+    // Appelle fn(indice de cellule) pour chaque cellule couverte par la boîte.
+    template <typename Function>
+    void forEachCell(const Aabb& box, Function&& fn) const {
+        const int x0 = cellX(box.left), x1 = cellX(box.right);
+        const int y0 = cellY(box.top),  y1 = cellY(box.bottom);
+        for (int cy = y0; cy <= y1; ++cy) {
+            for (int cx = x0; cx <= x1; ++cx) {
+                fn(static_cast<std::size_t>(cy) * static_cast<std::size_t>(m_cols) + static_cast<std::size_t>(cx));
+            }
+        }
+    }
+
+    std::vector<Item>          m_items;
+    // Début de chaque cellule dans m_cellItems (taille : cellules + 1)
+    std::vector<std::uint32_t> m_cellStart;
+    std::vector<std::uint32_t> m_cellItems;
+    // Boîtes des entrées de m_cellItems, en SoA
+    std::vector<float>         m_cellLeft;
+    std::vector<float>         m_cellTop;
+    std::vector<float>         m_cellRight;
+    std::vector<float>         m_cellBottom;
+    std::vector<std::uint32_t> m_fill;
+    float m_originX = 0.f;
+    float m_originY = 0.f;
+    float m_invCell = 1.f;
+    int   m_cols = 1;
+    int   m_rows = 1;
+};
+
+} // namespace engine
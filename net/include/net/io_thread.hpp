@@ -0,0 +1,136 @@
+// Thread d’entrées-sorties optionnel de Server et Client : il possède les
+// appels système sur la socket (attente, réception et envoi par lots) et
+// échange les datagrammes avec le thread de simulation par deux SpscRing.
+// Le thread de simulation ne fait alors plus que copier des octets.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "net/socket.hpp"
+#include "net/spsc_ring.hpp"
+
+namespace net {
+
+// Capacité par défaut de chaque file, en datagrammes.
+inline constexpr std::size_t IO_RING_CAPACITY = 1024;
+// Attente maximale du thread d’E/S quand il n’a rien à faire.  Un datagramme
+// mis en file le réveille aussitôt : ce délai ne borne que les cas perdus.
+inline constexpr std::chrono::milliseconds IO_THREAD_POLL_TIMEOUT{1};
+
+class IoThread {
+public:
+    // datagramSize : taille maximale des datagrammes reçus.
+    IoThread(socket_handle s, std::size_t datagramSize, std::size_t ringCapacity = IO_RING_CAPACITY)
+        : _socket(s), _receiver(datagramSize), _inbound(ringCapacity), _outbound(ringCapacity) {
+        _thread = std::thread([this] { run(); });
+    }
+
+    IoThread(const IoThread&) = delete;
+    IoThread& operator=(const IoThread&) = delete;
+
+    ~IoThread() {
+        _stop.store(true, std::memory_order_relaxed);
+        _wakeup.signal();
+        _thread.join();
+    }
+
+    // Thread de simulation : met en file un datagramme pour to.  Renvoie faux,
+    // et le datagramme est perdu, si la file est pleine.
+    bool send(const sockaddr_in& to, const char* data, std::size_t size) {
+        Datagram* d = _outbound.beginPush();
+        if (!d) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        d->addr = to;
+        d->bytes.resize(size);
+        std::memcpy(d->bytes.data(), data, size);
+        _outbound.commitPush();
+        // Publication avant la lecture de _sleeping, qui l’écrit avant de
+        // relire la file : l’un des deux voit toujours l’autre.  Un seul
+        // appel système par sommeil, quel que soit le nombre d’envois.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_sleeping.load(std::memory_order_relaxed) && _sleeping.exchange(false, std::memory_order_relaxed)) {
+            _wakeup.signal();
+        }
+        return true;
+    }
+
+    // Thread de simulation : appelle fn(sender, data, size) pour chaque
+    // datagramme reçu, dans l’ordre de réception.
+    template <typename Fn>
+    void drain(Fn&& fn) {
+        while (Datagram* d = _inbound.beginPop()) {
+            const Datagram& received = *d;
+            fn(received.addr, received.bytes.data(), received.bytes.size());
+            _inbound.commitPop();
+        }
+    }
+
+    // Datagrammes perdus faute de place dans l’une des files.
+    std::uint64_t droppedDatagrams() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Datagram {
+        sockaddr_in addr{};
+        std::vector<char> bytes;
+    };
+
+    void run() {
+        while (!_stop.load(std::memory_order_relaxed)) {
+            bool busy = false;
+            while (Datagram* d = _outbound.beginPop()) {
+                std::vector<char>& bytes = _queue.push(d->addr);
+                bytes.resize(d->bytes.size());
+                std::memcpy(bytes.data(), d->bytes.data(), d->bytes.size());
+                _outbound.commitPop();
+                busy = true;
+            }
+            _queue.flush(_socket);
+
+            const std::size_t received = _receiver.receive(_socket);
+            for (std::size_t i = 0; i < received; ++i) {
+                Datagram* d = _inbound.beginPush();
+                if (!d) {
+                    _dropped.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                d->addr = _receiver.sender(i);
+                d->bytes.resize(_receiver.size(i));
+                std::memcpy(d->bytes.data(), _receiver.data(i), _receiver.size(i));
+                _inbound.commitPush();
+            }
+            busy = busy || received > 0;
+
+            if (!busy) {
+                _sleeping.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!_outbound.beginPop() && !_stop.load(std::memory_order_relaxed)) {
+                    socket_wait_readable(_socket, _wakeup, IO_THREAD_POLL_TIMEOUT);
+                }
+                _sleeping.store(false, std::memory_order_relaxed);
+                _wakeup.clear();
+            }
+        }
+    }
+
+    socket_handle              _socket;
+    DatagramReceiver           _receiver;
+    DatagramQueue              _queue;
+    SpscRing<Datagram>         _inbound;
+    SpscRing<Datagram>         _outbound;
+    SocketWakeup               _wakeup;
+    // Vrai quand le thread d’E/S va attendre : send() doit le réveiller
+    std::atomic<bool>          _sleeping{false};
+    std::atomic<bool>          _stop{false};
+    std::atomic<std::uint64_t> _dropped{0};
+    std::thread                _thread;
+};
+
+} // namespace net
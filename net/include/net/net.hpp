@@ -2,82 +2,66 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <optional>
+#include <random>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
-#ifdef _WIN32
-    #ifndef NOMINMAX
-        #define NOMINMAX
-    #endif
-    #ifndef WIN32_LEAN_AND_MEAN
-        #define WIN32_LEAN_AND_MEAN
-    #endif
-    #include <winsock2.h>
-    #include <ws2tcpip.h>
-    #pragma comment(lib, "ws2_32.lib")
-#else
-    #include <arpa/inet.h>
-    #include <fcntl.h>
-    #include <netinet/in.h>
-    #include <sys/socket.h>
-    #include <unistd.h>
-#endif
+#include "net/io_thread.hpp"
+#include "net/snapshot_codec.hpp"
+#include "net/socket.hpp"
 
 namespace net {
 
-#ifdef _WIN32
-    using socket_handle = SOCKET;
-    using socklen_type  = int;
-    using recv_len      = int;
-    static constexpr socket_handle invalid_socket = INVALID_SOCKET;
-
-    struct WSAInit {
-        WSAInit() {
-            WSADATA wsaData;
-            WSAStartup(MAKEWORD(2, 2), &wsaData);
-        }
-        ~WSAInit() {
-            WSACleanup();
-        }
-    };
-#else
-    using socket_handle = int;
-    using socklen_type  = socklen_t;
-    using recv_len      = ssize_t;
-    static constexpr socket_handle invalid_socket = -1;
-#endif
-
-inline void socket_close(socket_handle s) {
-#ifdef _WIN32
-    if (s != invalid_socket) closesocket(s);
-#else
-    if (s != invalid_socket) ::close(s);
-#endif
-}
-
-inline void socket_set_nonblocking(socket_handle s) {
-#ifdef _WIN32
-    u_long mode = 1;
-    ioctlsocket(s, FIONBIO, &mode);
-#else
-    int flags = fcntl(s, F_GETFL, 0);
-    if (flags >= 0) {
-        fcntl(s, F_SETFL, flags | O_NONBLOCK);
-    }
-#endif
-}
-
 inline constexpr std::size_t MAX_DEFAULT_CLIENTS = 4;
+// Délai sans paquet au-delà duquel le slot d’un client est libéré.
+inline constexpr std::chrono::milliseconds DEFAULT_CLIENT_TIMEOUT{10000};
 inline constexpr std::uint32_t MAX_ENTITIES = 512;
-inline constexpr std::uint16_t PROTOCOL_VERSION = 1;
+inline constexpr std::uint16_t PROTOCOL_VERSION = 5;
+// Taille maximale d’un datagramme UDP sur IPv4.
+inline constexpr std::size_t MAX_DATAGRAM_SIZE = 65507;
+// Taille par défaut des datagrammes de snapshot : sous le MTU Ethernet (1500)
+// avec les en-têtes IP et UDP, et une marge pour les tunnels.
+inline constexpr std::size_t SNAPSHOT_DATAGRAM_SIZE = 1200;
+// Taille des tampons de réception des entrées côté serveur.
+inline constexpr std::size_t INPUT_DATAGRAM_SIZE = 1024;
+// Nombre maximal de fragments d’un snapshot.
+inline constexpr std::size_t SNAPSHOT_MAX_FRAGMENTS = 64;
+// Snapshots en cours de réassemblage simultanément côté client.
+inline constexpr std::size_t SNAPSHOT_REASSEMBLY_SLOTS = 4;
+// Distance (unités du monde) à l’entité contrôlée à laquelle la priorité
+// par défaut d’une entité est divisée par deux.
+inline constexpr float SNAPSHOT_RELEVANCE_RADIUS = 256.f;
+// Nombre maximal d’entrées d’un lot (InputBatchHeader::count).
+inline constexpr std::size_t INPUT_BATCH_MAX = 32;
+// Entrées envoyées par défaut dans chaque lot : la plus récente et les
+// précédentes, répétées pour compenser les pertes.
+inline constexpr std::size_t INPUT_REDUNDANCY = 8;
+// Entrées en attente par client côté serveur ; au-delà, la plus ancienne est
+// perdue.
+inline constexpr std::size_t INPUT_QUEUE_CAPACITY = 64;
+// Les axes de déplacement d’un lot sont transmis en entiers de
+// 1/INPUT_AXIS_SCALE.
+inline constexpr float INPUT_AXIS_SCALE = 127.f;
 
 inline constexpr std::uint32_t INPUT_MAGIC = 0x49505431u;
 inline constexpr std::uint32_t SNAP_MAGIC  = 0x534E5031u;
+inline constexpr std::uint32_t INPUT_BATCH_MAGIC = 0x49505442u;
+
+// Bits de tir d’un enregistrement de lot d’entrées.
+inline constexpr std::uint8_t INPUT_FIRE_PRESSED  = 1u << 0;
+inline constexpr std::uint8_t INPUT_FIRE_HELD     = 1u << 1;
+inline constexpr std::uint8_t INPUT_FIRE_RELEASED = 1u << 2;
 
 #pragma pack(push, 1)
 
@@ -88,6 +72,11 @@ struct InputPacket {
 
     std::uint32_t inputSequence{0};
     std::uint32_t clientFrame{0};
+    // Dernier snapshot reçu et décodé par le client (0 : aucun), renseigné
+    // par Client::sendInput() ; sert de référence aux snapshots suivants.
+    std::uint32_t ackedSnapshot{0};
+    // Connexion (SnapshotHeader::epoch) à laquelle appartient ackedSnapshot.
+    std::uint32_t ackedEpoch{0};
 
     float moveX{0.f};
     float moveY{0.f};
@@ -133,11 +122,213 @@ struct SnapshotHeader {
     std::uint32_t serverFrame{0};
     std::uint32_t controlledId{0};
     std::uint32_t playerCount{0};
+    // Nombre d’enregistrements d’entités qui suivent l’en-tête (voir
+    // snapshot_codec.hpp) ; dans le SnapshotPacket reconstruit par le client,
+    // nombre d’entités de l’état complet.
     std::uint32_t entityCount{0};
+    // Snapshot de référence du codage différentiel (0 : snapshot complet).
+    std::uint32_t baseline{0};
+    // Connexion du client : tirée par le serveur à chaque admission d’une
+    // adresse (jamais 0).  Les séquences ne sont comparables qu’à epoch égal.
+    std::uint32_t epoch{0};
+};
+
+// En-tête de chaque datagramme de snapshot.  Le snapshot (SnapshotHeader
+// puis enregistrements d’entités) est découpé en fragmentCount morceaux
+// envoyés dans l’ordre ; le client les réassemble avant de le décoder.
+struct SnapshotFragmentHeader {
+    std::uint32_t magic{SNAP_MAGIC};
+    std::uint16_t protocolVersion{PROTOCOL_VERSION};
+    std::uint16_t _pad0{0};
+
+    std::uint32_t sequence{0};
+    std::uint16_t fragmentIndex{0};
+    std::uint16_t fragmentCount{1};
+    // Même valeur que SnapshotHeader::epoch.
+    std::uint32_t epoch{0};
+};
+
+// En-tête d’un lot d’entrées, suivi de count enregistrements de la plus
+// récente à la plus ancienne (voir encodeInputBatch()).  Les champs de la
+// plus récente sont dans l’en-tête.
+struct InputBatchHeader {
+    std::uint32_t magic{INPUT_BATCH_MAGIC};
+    std::uint16_t protocolVersion{PROTOCOL_VERSION};
+    std::uint8_t  count{0};
+    std::uint8_t  _pad0{0};
+
+    std::uint32_t ackedSnapshot{0};
+    std::uint32_t ackedEpoch{0};
+    std::uint32_t inputSequence{0};
+    std::uint32_t clientFrame{0};
 };
 
 #pragma pack(pop)
 
+// Compteurs de trafic d’un Server ou d’un Client, tenus seulement avec
+// COMMON_LIBS_PROFILING (nuls sinon).  Les octets sont ceux des charges UDP ;
+// les datagrammes perdus par le thread d’E/S sont comptés à part
+// (droppedDatagrams()).
+struct NetStats {
+    std::uint64_t packetsIn{0};
+    std::uint64_t bytesIn{0};
+    std::uint64_t packetsOut{0};
+    std::uint64_t bytesOut{0};
+    // Datagrammes reçus écartés : magic inattendu, version de protocole
+    // différente, autre défaut (taille, champs, expéditeur, lot invalide)
+    std::uint64_t rejectedMagic{0};
+    std::uint64_t rejectedVersion{0};
+    std::uint64_t rejectedOther{0};
+
+    void countIn(std::size_t bytes) {
+        ++packetsIn;
+        bytesIn += bytes;
+    }
+
+    void countOut(std::size_t bytes) {
+        ++packetsOut;
+        bytesOut += bytes;
+    }
+
+    // Classe un datagramme écarté d’après son en-tête : tous les paquets
+    // commencent par magic puis protocolVersion.
+    void countRejected(const char* data, std::size_t size, std::uint32_t expectedMagic) {
+        std::uint32_t magic = 0;
+        std::uint16_t version = 0;
+        if (size < sizeof(magic) + sizeof(version)) {
+            ++rejectedOther;
+            return;
+        }
+        std::memcpy(&magic, data, sizeof(magic));
+        std::memcpy(&version, data + sizeof(magic), sizeof(version));
+        if (magic != expectedMagic) {
+            ++rejectedMagic;
+        } else if (version != PROTOCOL_VERSION) {
+            ++rejectedVersion;
+        } else {
+            ++rejectedOther;
+        }
+    }
+};
+
+// Instruction de comptage, supprimée sans COMMON_LIBS_PROFILING.
+#if defined(COMMON_LIBS_PROFILING)
+#define NET_STAT(statement) statement
+#else
+#define NET_STAT(statement) ((void)0)
+#endif
+
+inline std::uint8_t quantizeAxis(float v) {
+    if (!(v == v)) return 0;
+    const float clamped = std::clamp(v, -1.f, 1.f);
+    return static_cast<std::uint8_t>(static_cast<std::int8_t>(std::lround(clamped * INPUT_AXIS_SCALE)));
+}
+
+inline float dequantizeAxis(std::uint8_t q) {
+    return static_cast<float>(static_cast<std::int8_t>(q)) / INPUT_AXIS_SCALE;
+}
+
+// Écrit un lot de count entrées (1 à INPUT_BATCH_MAX), inputs[0] étant la
+// plus récente et les numéros de séquence strictement décroissants.  Chaque
+// enregistrement après le premier commence par l’écart de séquence (varint)
+// et l’écart de clientFrame (zigzag) avec le précédent ; tous finissent par
+// les deux axes quantifiés et l’octet des bits de tir.
+inline void encodeInputBatch(const InputPacket* inputs, std::size_t count, std::uint32_t ackedSnapshot,
+                             std::uint32_t ackedEpoch, std::vector<char>& out) {
+    InputBatchHeader hdr{};
+    hdr.count = static_cast<std::uint8_t>(count);
+    hdr.ackedSnapshot = ackedSnapshot;
+    hdr.ackedEpoch = ackedEpoch;
+    hdr.inputSequence = inputs[0].inputSequence;
+    hdr.clientFrame = inputs[0].clientFrame;
+    out.resize(sizeof(hdr));
+    std::memcpy(out.data(), &hdr, sizeof(hdr));
+
+    ByteWriter w(out);
+    for (std::size_t i = 0; i < count; ++i) {
+        const InputPacket& in = inputs[i];
+        if (i > 0) {
+            w.varint(inputs[i - 1].inputSequence - in.inputSequence);
+            w.delta(static_cast<std::int32_t>(inputs[i - 1].clientFrame), static_cast<std::int32_t>(in.clientFrame));
+        }
+        w.u8(quantizeAxis(in.moveX));
+        w.u8(quantizeAxis(in.moveY));
+        w.u8(static_cast<std::uint8_t>((in.firePressed ? INPUT_FIRE_PRESSED : 0u) |
+                                       (in.fireHeld ? INPUT_FIRE_HELD : 0u) |
+                                       (in.fireReleased ? INPUT_FIRE_RELEASED : 0u)));
+    }
+}
+
+// Décode un lot dans out (au moins INPUT_BATCH_MAX éléments), de la plus
+// récente à la plus ancienne ; renvoie le nombre d’entrées, 0 si le lot est
+// invalide.
+inline std::size_t decodeInputBatch(const char* data, std::size_t size, InputPacket* out) {
+    if (size < sizeof(InputBatchHeader)) return 0;
+    InputBatchHeader hdr{};
+    std::memcpy(&hdr, data, sizeof(hdr));
+    if (hdr.magic != INPUT_BATCH_MAGIC || hdr.protocolVersion != PROTOCOL_VERSION ||
+        hdr.count == 0 || hdr.count > INPUT_BATCH_MAX) return 0;
+
+    ByteReader r(data + sizeof(hdr), size - sizeof(hdr));
+    for (std::size_t i = 0; i < hdr.count; ++i) {
+        InputPacket& in = out[i];
+        in = InputPacket{};
+        in.ackedSnapshot = hdr.ackedSnapshot;
+        in.ackedEpoch = hdr.ackedEpoch;
+        if (i == 0) {
+            in.inputSequence = hdr.inputSequence;
+            in.clientFrame = hdr.clientFrame;
+        } else {
+            const std::uint64_t gap = r.varint();
+            if (gap == 0 || gap > out[i - 1].inputSequence) return 0;
+            in.inputSequence = out[i - 1].inputSequence - static_cast<std::uint32_t>(gap);
+            in.clientFrame = static_cast<std::uint32_t>(r.delta(static_cast<std::int32_t>(out[i - 1].clientFrame)));
+        }
+        in.moveX = dequantizeAxis(r.u8());
+        in.moveY = dequantizeAxis(r.u8());
+        const std::uint8_t fire = r.u8();
+        in.firePressed  = (fire & INPUT_FIRE_PRESSED) ? 1 : 0;
+        in.fireHeld     = (fire & INPUT_FIRE_HELD) ? 1 : 0;
+        in.fireReleased = (fire & INPUT_FIRE_RELEASED) ? 1 : 0;
+    }
+    return (r.ok() && r.atEnd()) ? hdr.count : 0;
+}
+
+// File des entrées reçues d’un client, par numéro de séquence croissant.  De
+// capacité fixe (INPUT_QUEUE_CAPACITY) : pleine, elle perd la plus ancienne.
+class InputQueue {
+public:
+    bool empty() const { return _count == 0; }
+    std::size_t size() const { return _count; }
+
+    void push(const InputPacket& in) {
+        if (_count == _items.size()) {
+            _head = (_head + 1) % _items.size();
+            --_count;
+        }
+        _items[(_head + _count) % _items.size()] = in;
+        ++_count;
+    }
+
+    bool pop(InputPacket& out) {
+        if (_count == 0) return false;
+        out = _items[_head];
+        _head = (_head + 1) % _items.size();
+        --_count;
+        return true;
+    }
+
+    void clear() {
+        _head = 0;
+        _count = 0;
+    }
+
+private:
+    std::array<InputPacket, INPUT_QUEUE_CAPACITY> _items{};
+    std::size_t _head{0};
+    std::size_t _count{0};
+};
+
 struct SnapshotPacket {
     SnapshotHeader header;
     std::vector<SnapshotEntity> entities;
@@ -146,17 +337,47 @@ struct SnapshotPacket {
 class Server {
 public:
     using NewClientCallback = std::function<void(std::size_t, const sockaddr_in&)>;
+    // Appelé quand un slot est libéré (délai dépassé ou disconnectClient()),
+    // avant que le slot ne puisse être réattribué.
+    using DisconnectCallback = std::function<void(std::size_t, const sockaddr_in&)>;
+    // Appelé pour chaque nouvelle entrée, dans l’ordre des séquences ; sans
+    // callback, les entrées sont mises en file pour popInput().
     using InputCallback     = std::function<void(std::size_t, const InputPacket&)>;
+    // Pertinence d’une entité pour un client, utilisée quand un snapshot
+    // dépasse le budget ; plus elle est élevée, plus l’entité passe tôt.
+    using PriorityCallback  = std::function<float(std::size_t, const SnapshotEntity&)>;
 
     struct ClientSlot {
         bool active{false};
         sockaddr_in addr{};
+        // Réception du dernier paquet, pour la libération des slots inactifs
+        std::chrono::steady_clock::time_point lastHeard{};
+        // Une entrée a été reçue ; les suivantes doivent avoir une séquence
+        // supérieure à lastReceivedInput, les autres sont des doublons
+        bool receivedInput{false};
         std::uint32_t lastReceivedInput{0};
         std::uint32_t lastProcessedInput{0};
+        // Entrées en attente de popInput()
+        InputQueue inputs{};
+        // Connexion en cours : renouvelée à chaque admission de l’adresse, elle
+        // distingue les snapshots et acquittements d’une connexion précédente
+        std::uint32_t epoch{0};
         std::uint32_t snapshotCounter{0};
+        // Dernier snapshot acquitté par le client et états envoyés récemment
+        std::uint32_t ackedSnapshot{0};
+        SnapshotHistory history{};
+        // Entités reportées par le budget et nombre de snapshots consécutifs
+        // où elles l’ont été, triées par identifiant
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> deferred{};
     };
 
-    explicit Server(std::uint16_t port) {
+    // maxClients : nombre de slots (joueurs et spectateurs).
+    explicit Server(std::uint16_t port, std::size_t maxClients = MAX_DEFAULT_CLIENTS)
+        : _clients(maxClients) {
+        if (maxClients == 0) {
+            throw std::invalid_argument("Server needs at least one client slot");
+        }
+        _slotByAddress.reserve(maxClients);
 #ifdef _WIN32
         static WSAInit _wsa_once{};
 #endif
@@ -178,121 +399,446 @@ public:
     }
 
     ~Server() {
+        _io.reset();
         socket_close(_socket);
     }
 
+    // Mode threadé : un thread d’E/S possède la socket, pollInputs() et les
+    // envois de snapshots n’échangent plus que des octets avec lui.  Les
+    // callbacks restent appelés par pollInputs(), sur le thread appelant.
+    void startIoThread(std::size_t ringCapacity = IO_RING_CAPACITY) {
+        if (!_io) _io = std::make_unique<IoThread>(_socket, INPUT_DATAGRAM_SIZE, ringCapacity);
+    }
+
+    // Arrête le thread d’E/S ; les datagrammes encore en file sont perdus.
+    void stopIoThread() { _io.reset(); }
+
+    bool ioThreadRunning() const { return _io != nullptr; }
+
+    // Datagrammes perdus faute de place dans les files du thread d’E/S.
+    std::uint64_t droppedDatagrams() const { return _io ? _io->droppedDatagrams() : 0; }
+
+    // Trafic depuis la création ou le dernier resetStats() (voir NetStats).
+    const NetStats& stats() const { return _stats; }
+    void resetStats() { _stats = NetStats{}; }
+
     void setCallbacks(NewClientCallback onNewClient, InputCallback onInput) {
         _onNewClient = std::move(onNewClient);
         _onInput     = std::move(onInput);
     }
 
+    void setDisconnectCallback(DisconnectCallback onDisconnect) { _onDisconnect = std::move(onDisconnect); }
+
+    std::size_t capacity() const { return _clients.size(); }
+    std::size_t activeClientCount() const { return _slotByAddress.size(); }
+    bool isActive(std::size_t slotIndex) const { return slotIndex < _clients.size() && _clients[slotIndex].active; }
+
+    // Délai sans paquet après lequel pollInputs() libère un slot
+    // (DEFAULT_CLIENT_TIMEOUT ; 0 : jamais).
+    void setClientTimeout(std::chrono::milliseconds timeout) { _clientTimeout = timeout; }
+
+    std::chrono::milliseconds clientTimeout() const { return _clientTimeout; }
+
+    // Libère le slot ; un nouveau paquet de la même adresse l’attribuera de
+    // nouveau, comme à un nouveau client.
+    void disconnectClient(std::size_t slotIndex) {
+        if (!isActive(slotIndex)) return;
+        ClientSlot& slot = _clients[slotIndex];
+        slot.active = false;
+        _slotByAddress.erase(addressKey(slot.addr));
+        if (_onDisconnect) _onDisconnect(slotIndex, slot.addr);
+    }
+
+    // Taille maximale de chaque datagramme de snapshot, en-têtes IP et UDP
+    // exclus.
+    void setMaxDatagramSize(std::size_t bytes) {
+        if (bytes <= sizeof(SnapshotFragmentHeader) + sizeof(SnapshotHeader) || bytes > MAX_DATAGRAM_SIZE) {
+            throw std::invalid_argument("Invalid snapshot datagram size");
+        }
+        _maxDatagramSize = bytes;
+    }
+
+    std::size_t maxDatagramSize() const { return _maxDatagramSize; }
+
+    // Octets d’enregistrements d’entités autorisés par snapshot et par client
+    // (0 : seulement la limite de SNAPSHOT_MAX_FRAGMENTS fragments).  Au-delà,
+    // les modifications les moins prioritaires sont reportées au snapshot
+    // suivant.
+    void setSnapshotByteBudget(std::size_t bytes) { _snapshotBudget = bytes; }
+
+    std::size_t snapshotByteBudget() const { return _snapshotBudget; }
+
+    // Remplace la pertinence par défaut, qui décroît avec la distance à
+    // l’entité contrôlée par le client (SNAPSHOT_RELEVANCE_RADIUS).  Dans les
+    // deux cas, la priorité est multipliée par 1 + le nombre de snapshots où
+    // l’entité a déjà été reportée, pour qu’aucune ne le soit indéfiniment.
+    void setPriorityCallback(PriorityCallback priority) { _priority = std::move(priority); }
+
     void pollInputs() {
+        if (_io) {
+            _now = std::chrono::steady_clock::now();
+            _io->drain([this](const sockaddr_in& sender, const char* data, std::size_t size) {
+                handleInput(sender, data, size);
+            });
+            reclaimIdleClients(_now);
+            return;
+        }
         while (true) {
-            std::array<char, 1024> buffer{};
-            sockaddr_in sender{};
-            socklen_type senderLen = sizeof(sender);
-
-            recv_len n = ::recvfrom(
-                _socket,
-                buffer.data(),
-                static_cast<int>(buffer.size()),
-                0,
-                reinterpret_cast<sockaddr*>(&sender),
-                &senderLen
-            );
-
-            if (n <= 0) break;
-
-            if (static_cast<std::size_t>(n) < sizeof(InputPacket)) continue;
-
-            InputPacket pkt{};
-            std::memcpy(&pkt, buffer.data(), sizeof(InputPacket));
-            
-            if (pkt.magic != INPUT_MAGIC || pkt.protocolVersion != PROTOCOL_VERSION) continue;
-
-            std::size_t idx = findClient(sender);
-            if (idx == MAX_DEFAULT_CLIENTS) {
-                idx = findFreeSlot();
-                if (idx == MAX_DEFAULT_CLIENTS) continue;
-                
-                _clients[idx].active = true;
-                _clients[idx].addr = sender;
-                _clients[idx].lastReceivedInput = 0;
-                _clients[idx].lastProcessedInput = 0;
-                _clients[idx].snapshotCounter = 0;
-                if (_onNewClient) _onNewClient(idx, sender);
+            const std::size_t received = _receiver.receive(_socket);
+            _now = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < received; ++i) {
+                handleInput(_receiver.sender(i), _receiver.data(i), _receiver.size(i));
             }
-            
-            _clients[idx].lastReceivedInput = pkt.inputSequence;
-            if (_onInput) _onInput(idx, pkt);
+            if (received < DATAGRAM_BATCH_SIZE) break;
         }
+        reclaimIdleClients(_now);
     }
 
     void sendSnapshot(std::size_t slotIndex, std::uint32_t packedFrameData, std::uint32_t controlledId, const std::vector<SnapshotEntity>& ents) {
-        if (slotIndex >= MAX_DEFAULT_CLIENTS || !_clients[slotIndex].active) return;
+        if (!isActive(slotIndex)) return;
 
-        SnapshotHeader hdr{};
-        hdr.magic = SNAP_MAGIC;
-        hdr.protocolVersion = PROTOCOL_VERSION;
-        hdr.serverFrame = packedFrameData; 
-        hdr.controlledId = controlledId;
-        hdr.entityCount = static_cast<std::uint32_t>(ents.size());
+        prepareSnapshot(ents);
+        queueSnapshot(slotIndex, packedFrameData, controlledId);
+        flushOutgoing();
+    }
+
+    // Envoie le même état à tous les clients actifs.  La quantification, le
+    // tri et le codage complet (clients sans référence) ne sont faits qu’une
+    // fois, et tous les datagrammes partent en un lot d’appels système.
+    // controlledIds[i] est l’entité contrôlée par le client du slot i (0
+    // au-delà de la taille du tableau).
+    void broadcastSnapshot(std::uint32_t packedFrameData, const std::vector<SnapshotEntity>& ents,
+                           const std::vector<std::uint32_t>& controlledIds) {
+        prepareSnapshot(ents);
+        for (std::size_t i = 0; i < _clients.size(); ++i) {
+            if (!_clients[i].active) continue;
+            queueSnapshot(i, packedFrameData, i < controlledIds.size() ? controlledIds[i] : 0);
+        }
+        flushOutgoing();
+    }
 
-        sendInternal(slotIndex, hdr, ents);
+    // Tampon réutilisé de l’état du prochain snapshot, vidé, à remplir
+    // directement sous forme quantifiée (par exemple par
+    // engine::SnapshotBuilder) avant sendPreparedSnapshot() ou
+    // broadcastPreparedSnapshot() : ni vecteur de SnapshotEntity ni
+    // conversion.  Trié par identifiant, il évite aussi le tri.
+    std::vector<QuantizedEntity>& beginSnapshot() {
+        _quantized.clear();
+        _fullValid = false;
+        _preparedSorted = false;
+        return _quantized;
+    }
+
+    // Comme sendSnapshot(), avec l’état rempli après beginSnapshot().
+    void sendPreparedSnapshot(std::size_t slotIndex, std::uint32_t packedFrameData, std::uint32_t controlledId) {
+        if (!isActive(slotIndex)) return;
+
+        sortPrepared();
+        queueSnapshot(slotIndex, packedFrameData, controlledId);
+        flushOutgoing();
+    }
+
+    // Comme broadcastSnapshot(), avec l’état rempli après beginSnapshot().
+    void broadcastPreparedSnapshot(std::uint32_t packedFrameData, const std::vector<std::uint32_t>& controlledIds) {
+        sortPrepared();
+        for (std::size_t i = 0; i < _clients.size(); ++i) {
+            if (!_clients[i].active) continue;
+            queueSnapshot(i, packedFrameData, i < controlledIds.size() ? controlledIds[i] : 0);
+        }
+        flushOutgoing();
     }
 
     void setLastProcessedInput(std::size_t slotIndex, std::uint32_t seq) {
-        if (slotIndex < MAX_DEFAULT_CLIENTS) _clients[slotIndex].lastProcessedInput = seq;
+        if (slotIndex < _clients.size()) _clients[slotIndex].lastProcessedInput = seq;
     }
 
     std::uint32_t getLastProcessedInput(std::size_t slotIndex) const {
-        if (slotIndex < MAX_DEFAULT_CLIENTS && _clients[slotIndex].active) {
+        if (isActive(slotIndex)) {
             return _clients[slotIndex].lastProcessedInput;
         }
         return 0;
     }
 
+    // Retire l’entrée la plus ancienne en attente pour ce slot et en fait la
+    // dernière entrée traitée ; renvoie faux si aucune n’attend.  Appelé une
+    // fois par client et par pas de simulation, il applique les entrées dans
+    // l’ordre où le client les a produites, pertes comblées par les lots.
+    bool popInput(std::size_t slotIndex, InputPacket& out) {
+        if (!isActive(slotIndex) || !_clients[slotIndex].inputs.pop(out)) return false;
+        _clients[slotIndex].lastProcessedInput = out.inputSequence;
+        return true;
+    }
+
+    std::size_t queuedInputCount(std::size_t slotIndex) const {
+        return isActive(slotIndex) ? _clients[slotIndex].inputs.size() : 0;
+    }
+
 private:
-    void sendInternal(std::size_t slotIndex, SnapshotHeader hdr, const std::vector<SnapshotEntity>& ents) {
-        hdr.sequence = _clients[slotIndex].snapshotCounter++;
+    // Accepte un InputPacket isolé ou un lot d’entrées.
+    void handleInput(const sockaddr_in& sender, const char* data, std::size_t size) {
+        NET_STAT(_stats.countIn(size));
+        std::uint32_t magic = 0;
+        if (size < sizeof(magic)) {
+            NET_STAT(++_stats.rejectedOther);
+            return;
+        }
+        std::memcpy(&magic, data, sizeof(magic));
+
+        std::size_t count = 0;
+        if (magic == INPUT_MAGIC) {
+            if (size >= sizeof(InputPacket)) {
+                std::memcpy(&_batch[0], data, sizeof(InputPacket));
+                if (_batch[0].protocolVersion == PROTOCOL_VERSION) count = 1;
+            }
+        } else {
+            count = decodeInputBatch(data, size, _batch.data());
+        }
+        if (count == 0) {
+            NET_STAT(_stats.countRejected(data, size, magic == INPUT_MAGIC ? INPUT_MAGIC : INPUT_BATCH_MAGIC));
+            return;
+        }
+        const std::uint32_t acked = _batch[0].ackedSnapshot;
+        const std::uint32_t ackedEpoch = _batch[0].ackedEpoch;
+
+        std::size_t idx = findClient(sender);
+        if (idx == _clients.size()) {
+            idx = findFreeSlot();
+            if (idx == _clients.size()) return;
+
+            _slotByAddress.emplace(addressKey(sender), idx);
+            _clients[idx].active = true;
+            _clients[idx].addr = sender;
+            _clients[idx].receivedInput = false;
+            _clients[idx].lastReceivedInput = 0;
+            _clients[idx].lastProcessedInput = 0;
+            _clients[idx].inputs.clear();
+            _clients[idx].epoch = nextEpoch();
+            _clients[idx].snapshotCounter = 0;
+            _clients[idx].ackedSnapshot = 0;
+            _clients[idx].history.clear();
+            _clients[idx].deferred.clear();
+            if (_onNewClient) _onNewClient(idx, sender);
+        }
+
+        _clients[idx].lastHeard = _now;
+        // Un acquittement d’une connexion précédente de la même adresse
+        // désigne un autre snapshot que celui de même séquence de la connexion
+        // actuelle : il est ignoré
+        if (ackedEpoch == _clients[idx].epoch && acked > _clients[idx].ackedSnapshot &&
+            acked <= _clients[idx].snapshotCounter) {
+            _clients[idx].ackedSnapshot = acked;
+        }
+        // Du plus ancien au plus récent
+        for (std::size_t i = count; i-- > 0;) {
+            deliverInput(idx, _batch[i]);
+        }
+    }
 
-        std::vector<char> buffer;
-        buffer.reserve(sizeof(SnapshotHeader) + ents.size() * sizeof(SnapshotEntity));
+    // Écarte les entrées déjà reçues, transmet ou met en file les autres.
+    void deliverInput(std::size_t idx, const InputPacket& in) {
+        ClientSlot& slot = _clients[idx];
+        if (!slot.active || (slot.receivedInput && in.inputSequence <= slot.lastReceivedInput)) return;
+        slot.receivedInput = true;
+        slot.lastReceivedInput = in.inputSequence;
+        if (_onInput) {
+            _onInput(idx, in);
+        } else {
+            slot.inputs.push(in);
+        }
+    }
 
-        const char* hPtr = reinterpret_cast<const char*>(&hdr);
-        buffer.insert(buffer.end(), hPtr, hPtr + sizeof(SnapshotHeader));
+    // Envoie les datagrammes en file, ou les confie au thread d’E/S.
+    void flushOutgoing() {
+#if defined(COMMON_LIBS_PROFILING)
+        for (std::size_t i = 0; i < _outgoing.size(); ++i) {
+            _stats.countOut(_outgoing.bytes(i).size());
+        }
+#endif
+        if (!_io) {
+            _outgoing.flush(_socket);
+            return;
+        }
+        for (std::size_t i = 0; i < _outgoing.size(); ++i) {
+            _io->send(_outgoing.addr(i), _outgoing.bytes(i).data(), _outgoing.bytes(i).size());
+        }
+        _outgoing.clear();
+    }
 
-        if (!ents.empty()) {
-            const char* ePtr = reinterpret_cast<const char*>(ents.data());
-            buffer.insert(buffer.end(), ePtr, ePtr + ents.size() * sizeof(SnapshotEntity));
+    // Quantifie et trie ents, partagés par les snapshots mis en file ensuite.
+    void prepareSnapshot(const std::vector<SnapshotEntity>& ents) {
+        std::vector<QuantizedEntity>& state = beginSnapshot();
+        for (const SnapshotEntity& e : ents) {
+            state.push_back(quantize(e));
         }
+        sortPrepared();
+    }
 
-        ::sendto(_socket, buffer.data(), static_cast<int>(buffer.size()), 0,
-                 reinterpret_cast<sockaddr*>(&_clients[slotIndex].addr), sizeof(_clients[slotIndex].addr));
+    void sortPrepared() {
+        if (!_preparedSorted) {
+            sortById(_quantized);
+            _preparedSorted = true;
+        }
     }
 
-    std::size_t findClient(const sockaddr_in& addr) const {
-        for (std::size_t i = 0; i < MAX_DEFAULT_CLIENTS; ++i) {
-            if (_clients[i].active &&
-                _clients[i].addr.sin_addr.s_addr == addr.sin_addr.s_addr &&
-                _clients[i].addr.sin_port == addr.sin_port) {
-                return i;
-            }
+    // Écrit l’état préparé par rapport au dernier snapshot acquitté par le
+    // client s’il est encore dans l’historique, sinon en entier, dans la
+    // limite du budget.  L’état envoyé est conservé comme référence des
+    // snapshots suivants, puis découpé en fragments mis en file.
+    void queueSnapshot(std::size_t slotIndex, std::uint32_t packedFrameData, std::uint32_t controlledId) {
+        ClientSlot& slot = _clients[slotIndex];
+        SnapshotHeader hdr{};
+        hdr.sequence = ++slot.snapshotCounter;
+        hdr.epoch = slot.epoch;
+        hdr.serverFrame = packedFrameData;
+        hdr.controlledId = controlledId;
+
+        _focus = nullptr;
+        const auto controlled = std::lower_bound(
+            _quantized.begin(), _quantized.end(), hdr.controlledId,
+            [](const QuantizedEntity& q, std::uint32_t id) { return q.id < id; });
+        if (controlled != _quantized.end() && controlled->id == hdr.controlledId &&
+            (controlled->state & STATE_POSITION)) {
+            _focus = &*controlled;
+        }
+
+        static const std::vector<QuantizedEntity> none;
+        const std::vector<QuantizedEntity>* base = slot.history.find(slot.ackedSnapshot);
+        hdr.baseline = base ? slot.ackedSnapshot : 0;
+
+        const std::size_t payload = _maxDatagramSize - sizeof(SnapshotFragmentHeader);
+        std::size_t budget = SNAPSHOT_MAX_FRAGMENTS * payload - sizeof(SnapshotHeader);
+        if (_snapshotBudget != 0) {
+            budget = std::min(budget, _snapshotBudget);
+        }
+        _sendBuffer.resize(sizeof(SnapshotHeader));
+        if (!base && !_fullValid) {
+            _fullBytes.clear();
+            _fullRecords = encodeDelta(none, _quantized, _fullBytes);
+            _fullValid = true;
+        }
+        const std::vector<QuantizedEntity>* state = &_quantized;
+        if (!base && _fullBytes.size() <= budget) {
+            // Snapshot complet commun à tous les clients sans référence
+            _sendBuffer.insert(_sendBuffer.end(), _fullBytes.begin(), _fullBytes.end());
+            hdr.entityCount = _fullRecords;
+            slot.deferred.clear();
+        } else {
+            state = &_packer.pack(base ? *base : none, _quantized, budget,
+                                  [&](const QuantizedEntity& q, std::uint8_t) { return priority(slotIndex, q); });
+            updateDeferred(slot);
+            hdr.entityCount = encodeDelta(base ? *base : none, *state, _sendBuffer);
+        }
+        std::memcpy(_sendBuffer.data(), &hdr, sizeof(SnapshotHeader));
+        if (auto* sent = slot.history.store(hdr.sequence)) {
+            *sent = *state;
+        }
+
+        SnapshotFragmentHeader frag{};
+        frag.sequence = hdr.sequence;
+        frag.epoch = hdr.epoch;
+        frag.fragmentCount = static_cast<std::uint16_t>((_sendBuffer.size() + payload - 1) / payload);
+        for (std::size_t offset = 0; offset < _sendBuffer.size(); offset += payload) {
+            const std::size_t size = std::min(payload, _sendBuffer.size() - offset);
+            std::vector<char>& datagram = _outgoing.push(slot.addr);
+            datagram.resize(sizeof(frag) + size);
+            std::memcpy(datagram.data(), &frag, sizeof(frag));
+            std::memcpy(datagram.data() + sizeof(frag), _sendBuffer.data() + offset, size);
+            ++frag.fragmentIndex;
+        }
+    }
+
+    float priority(std::size_t slotIndex, const QuantizedEntity& q) const {
+        float relevance = 1.f;
+        if (_priority) {
+            relevance = _priority(slotIndex, dequantize<SnapshotEntity>(q));
+        } else if (_focus && (q.state & STATE_POSITION)) {
+            const float dx = dequantize(q.x) - dequantize(_focus->x);
+            const float dy = dequantize(q.y) - dequantize(_focus->y);
+            relevance = 1.f / (1.f + std::sqrt(dx * dx + dy * dy) / SNAPSHOT_RELEVANCE_RADIUS);
         }
-        return MAX_DEFAULT_CLIENTS;
+        const auto& deferred = _clients[slotIndex].deferred;
+        const auto it = std::lower_bound(deferred.begin(), deferred.end(), q.id,
+                                         [](const auto& d, std::uint32_t id) { return d.first < id; });
+        const std::uint32_t count = (it != deferred.end() && it->first == q.id) ? it->second : 0u;
+        return relevance * (1.f + static_cast<float>(count));
+    }
+
+    // Fusionne les entités reportées par le dernier pack() (triées) avec les
+    // compteurs du client.
+    void updateDeferred(ClientSlot& slot) {
+        _deferredScratch.clear();
+        std::size_t k = 0;
+        for (std::uint32_t id : _packer.deferred()) {
+            while (k < slot.deferred.size() && slot.deferred[k].first < id) ++k;
+            const bool known = k < slot.deferred.size() && slot.deferred[k].first == id;
+            _deferredScratch.emplace_back(id, (known ? slot.deferred[k].second : 0u) + 1u);
+        }
+        slot.deferred.swap(_deferredScratch);
+    }
+
+    // Adresse IPv4 et port, tels que reçus (ordre réseau).
+    static std::uint64_t addressKey(const sockaddr_in& addr) {
+        return (static_cast<std::uint64_t>(addr.sin_addr.s_addr) << 16) | addr.sin_port;
+    }
+
+    std::size_t findClient(const sockaddr_in& addr) const {
+        const auto it = _slotByAddress.find(addressKey(addr));
+        return it == _slotByAddress.end() ? _clients.size() : it->second;
     }
 
     std::size_t findFreeSlot() const {
-        for (std::size_t i = 0; i < MAX_DEFAULT_CLIENTS; ++i) {
+        for (std::size_t i = 0; i < _clients.size(); ++i) {
             if (!_clients[i].active) return i;
         }
-        return MAX_DEFAULT_CLIENTS;
+        return _clients.size();
+    }
+
+    // Identifiant de connexion suivant, jamais 0.  Le départ est aléatoire :
+    // un serveur redémarré ne reprend pas les valeurs du précédent.
+    std::uint32_t nextEpoch() {
+        if (++_epochCounter == 0) ++_epochCounter;
+        return _epochCounter;
+    }
+
+    void reclaimIdleClients(std::chrono::steady_clock::time_point now) {
+        if (_clientTimeout.count() <= 0) return;
+        for (std::size_t i = 0; i < _clients.size(); ++i) {
+            if (_clients[i].active && now - _clients[i].lastHeard > _clientTimeout) {
+                disconnectClient(i);
+            }
+        }
     }
 
     socket_handle    _socket{invalid_socket};
     NewClientCallback _onNewClient{};
     InputCallback     _onInput{};
-    std::array<ClientSlot, MAX_DEFAULT_CLIENTS> _clients{};
+    DisconnectCallback _onDisconnect{};
+    std::vector<ClientSlot> _clients;
+    // Slot de chaque client actif, par addressKey()
+    std::unordered_map<std::uint64_t, std::size_t> _slotByAddress;
+    std::chrono::milliseconds _clientTimeout{DEFAULT_CLIENT_TIMEOUT};
+    std::chrono::steady_clock::time_point _now{};
+    std::uint32_t _epochCounter{std::random_device{}()};
+    PriorityCallback  _priority{};
+    std::size_t _maxDatagramSize{SNAPSHOT_DATAGRAM_SIZE};
+    std::size_t _snapshotBudget{0};
+    std::vector<QuantizedEntity> _quantized;
+    bool _preparedSorted{false};
+    const QuantizedEntity* _focus{nullptr};
+    SnapshotPacker _packer;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> _deferredScratch;
+    // Codage complet de l’état préparé, partagé entre clients
+    std::vector<char> _fullBytes;
+    std::uint32_t _fullRecords{0};
+    bool _fullValid{false};
+    std::vector<char> _sendBuffer;
+    DatagramQueue _outgoing;
+    DatagramReceiver _receiver{INPUT_DATAGRAM_SIZE};
+    // Entrées du paquet en cours de traitement, de la plus récente à la plus
+    // ancienne
+    std::array<InputPacket, INPUT_BATCH_MAX> _batch{};
+    std::unique_ptr<IoThread> _io;
+    NetStats _stats{};
 };
 
 class Client {
@@ -312,67 +858,274 @@ public:
     }
 
     ~Client() {
+        _io.reset();
         socket_close(_socket);
     }
 
+    // Mode threadé, comme Server::startIoThread() : sendInput() et
+    // pollSnapshot() ne font plus d’appel système.
+    void startIoThread(std::size_t ringCapacity = IO_RING_CAPACITY) {
+        if (!_io) _io = std::make_unique<IoThread>(_socket, _receiver.datagramSize(), ringCapacity);
+    }
+
+    void stopIoThread() { _io.reset(); }
+
+    bool ioThreadRunning() const { return _io != nullptr; }
+
+    std::uint64_t droppedDatagrams() const { return _io ? _io->droppedDatagrams() : 0; }
+
+    const NetStats& stats() const { return _stats; }
+    void resetStats() { _stats = NetStats{}; }
+
+    // Ajoute pkt aux entrées récentes et envoie le lot (queueInput() puis
+    // flushInputs()).
     void sendInput(const InputPacket& pkt) {
-        ::sendto(_socket, reinterpret_cast<const char*>(&pkt), sizeof(pkt), 0,
+        queueInput(pkt);
+        flushInputs();
+    }
+
+    // Ajoute pkt aux entrées récentes sans rien envoyer.  Les séquences
+    // doivent croître strictement d’une entrée à la suivante ; sinon, les
+    // entrées précédentes sont oubliées et le lot suivant ne contient que pkt
+    // (que le serveur écartera comme doublon, mais qui maintient le slot).
+    void queueInput(const InputPacket& pkt) {
+        if (_recentCount != 0 &&
+            pkt.inputSequence <= _recentInputs[(_recentNext + _recentInputs.size() - 1) % _recentInputs.size()].inputSequence) {
+            _recentCount = 0;
+        }
+        _recentInputs[_recentNext] = pkt;
+        _recentNext = (_recentNext + 1) % _recentInputs.size();
+        _recentCount = std::min(_recentCount + 1, _recentInputs.size());
+    }
+
+    // Envoie en un datagramme les inputRedundancy() entrées les plus récentes,
+    // avec le dernier snapshot décodé comme ackedSnapshot.  Une entrée est
+    // ainsi répétée dans plusieurs lots : le client peut envoyer moins d’un
+    // lot par entrée, et le serveur récupère celles d’un lot perdu dans le
+    // suivant.
+    void flushInputs() {
+        const std::size_t count = std::min(_recentCount, _inputRedundancy);
+        if (count == 0) return;
+        for (std::size_t i = 0; i < count; ++i) {
+            _batchInputs[i] = _recentInputs[(_recentNext + _recentInputs.size() - 1 - i) % _recentInputs.size()];
+        }
+        encodeInputBatch(_batchInputs.data(), count, _latestSequence, _epoch, _inputBuffer);
+        NET_STAT(_stats.countOut(_inputBuffer.size()));
+        if (_io) {
+            _io->send(_serverAddr, _inputBuffer.data(), _inputBuffer.size());
+            return;
+        }
+        ::sendto(_socket, _inputBuffer.data(), static_cast<int>(_inputBuffer.size()), 0,
                  reinterpret_cast<sockaddr*>(&_serverAddr), sizeof(_serverAddr));
     }
 
+    // Nombre d’entrées par lot, de 1 à INPUT_BATCH_MAX (INPUT_REDUNDANCY par
+    // défaut).
+    void setInputRedundancy(std::size_t count) {
+        if (count == 0 || count > INPUT_BATCH_MAX) {
+            throw std::invalid_argument("Invalid input redundancy");
+        }
+        _inputRedundancy = count;
+    }
+
+    std::size_t inputRedundancy() const { return _inputRedundancy; }
+
+    // Réassemble et décode les snapshots reçus et renvoie l’état complet du
+    // plus récent, entités triées par identifiant.  Un snapshot dont un
+    // fragment manque, ou dont la référence n’est plus dans l’historique, est
+    // ignoré.
     std::optional<SnapshotPacket> pollSnapshot() {
-        constexpr std::size_t maxSize = sizeof(SnapshotHeader) + MAX_ENTITIES * sizeof(SnapshotEntity);
-        std::array<char, maxSize> buffer{};
-        
-        std::optional<SnapshotPacket> latestSnapshot = std::nullopt;
+        SnapshotPacket pkt{};
+        if (!pollSnapshot(pkt)) {
+            return std::nullopt;
+        }
+        return pkt;
+    }
 
-        while (true) {
-            sockaddr_in sender{};
-            socklen_type senderLen = sizeof(sender);
+    // Variante sans allocation une fois out.entities dimensionné : renvoie
+    // faux, sans modifier out, si aucun nouveau snapshot n’a été décodé.
+    bool pollSnapshot(SnapshotPacket& out) {
+        std::optional<SnapshotHeader> latestHeader = std::nullopt;
+        const auto onDatagram = [&](const sockaddr_in& sender, const char* data, std::size_t size) {
+            SnapshotHeader hdr{};
+            const std::uint32_t epoch = _epoch;
+            const bool decoded = handleFragment(sender, data, size, hdr);
+            if (_epoch != epoch) {
+                // Nouvelle connexion : l’historique a été vidé
+                latestHeader.reset();
+            }
+            if (decoded && hdr.sequence > _latestSequence) {
+                _latestSequence = hdr.sequence;
+                latestHeader = hdr;
+            }
+        };
+
+        if (_io) {
+            _io->drain(onDatagram);
+        } else {
+            while (true) {
+                const std::size_t received = _receiver.receive(_socket);
+                for (std::size_t i = 0; i < received; ++i) {
+                    onDatagram(_receiver.sender(i), _receiver.data(i), _receiver.size(i));
+                }
+                if (received < DATAGRAM_BATCH_SIZE) break;
+            }
+        }
 
-            recv_len n = ::recvfrom(
-                _socket,
-                buffer.data(),
-                static_cast<int>(buffer.size()),
-                0,
-                reinterpret_cast<sockaddr*>(&sender),
-                &senderLen
-            );
+        if (!latestHeader) {
+            return false;
+        }
+        out.header = *latestHeader;
+        const std::vector<QuantizedEntity>& state = *_history.find(_latestSequence);
+        out.header.entityCount = static_cast<std::uint32_t>(state.size());
+        out.entities.resize(state.size());
+        for (std::size_t i = 0; i < state.size(); ++i) {
+            out.entities[i] = dequantize<SnapshotEntity>(state[i]);
+        }
+        return true;
+    }
 
-            if (n <= 0) break;
+    // Taille maximale des datagrammes acceptés, à accorder avec
+    // Server::setMaxDatagramSize() ; un datagramme plus grand est ignoré.  À
+    // fixer avant startIoThread().
+    void setMaxDatagramSize(std::size_t bytes) {
+        if (bytes <= sizeof(SnapshotFragmentHeader) || bytes > MAX_DATAGRAM_SIZE) {
+            throw std::invalid_argument("Invalid snapshot datagram size");
+        }
+        if (_io) {
+            throw std::logic_error("setMaxDatagramSize() called while the I/O thread is running");
+        }
+        _receiver.resize(bytes);
+    }
 
-            if (sender.sin_addr.s_addr != _serverAddr.sin_addr.s_addr ||
-                sender.sin_port != _serverAddr.sin_port) continue;
+    std::size_t maxDatagramSize() const { return _receiver.datagramSize(); }
 
-            if (static_cast<std::size_t>(n) < sizeof(SnapshotHeader)) continue;
+private:
+    struct Reassembly {
+        std::uint32_t sequence{0};
+        std::uint16_t count{0};
+        std::uint16_t received{0};
+        std::uint64_t mask{0};
+        std::vector<std::vector<char>> fragments;
+    };
 
-            SnapshotHeader hdr{};
-            std::memcpy(&hdr, buffer.data(), sizeof(SnapshotHeader));
+    // Vérifie et range un fragment ; renvoie vrai, avec l’en-tête du
+    // snapshot, quand celui-ci est complet et décodé.
+    bool handleFragment(const sockaddr_in& sender, const char* data, std::size_t size, SnapshotHeader& hdr) {
+        NET_STAT(_stats.countIn(size));
+        if (sender.sin_addr.s_addr != _serverAddr.sin_addr.s_addr ||
+            sender.sin_port != _serverAddr.sin_port || size < sizeof(SnapshotFragmentHeader)) {
+            NET_STAT(++_stats.rejectedOther);
+            return false;
+        }
+
+        SnapshotFragmentHeader frag{};
+        std::memcpy(&frag, data, sizeof(SnapshotFragmentHeader));
+
+        if (frag.magic != SNAP_MAGIC || frag.protocolVersion != PROTOCOL_VERSION ||
+            frag.fragmentCount == 0 || frag.fragmentCount > SNAPSHOT_MAX_FRAGMENTS ||
+            frag.fragmentIndex >= frag.fragmentCount) {
+            NET_STAT(_stats.countRejected(data, size, SNAP_MAGIC));
+            return false;
+        }
+        if (frag.epoch == 0 || (frag.epoch != _epoch && frag.epoch == _previousEpoch)) {
+            // Retardataire de la connexion précédente
+            NET_STAT(++_stats.rejectedOther);
+            return false;
+        }
+        if (frag.epoch != _epoch) {
+            beginEpoch(frag.epoch);
+        }
+        if (frag.sequence == 0 || _history.find(frag.sequence)) return false;
 
-            if (hdr.magic != SNAP_MAGIC || hdr.protocolVersion != PROTOCOL_VERSION) continue;
-            if (hdr.entityCount > MAX_ENTITIES) continue;
+        if (!reassemble(frag, data + sizeof(SnapshotFragmentHeader), size - sizeof(SnapshotFragmentHeader))) return false;
 
-            const std::size_t expectedSize = sizeof(SnapshotHeader) + hdr.entityCount * sizeof(SnapshotEntity);
-            if (static_cast<std::size_t>(n) < expectedSize) continue;
+        return decodeSnapshot(frag.sequence, hdr);
+    }
 
-            SnapshotPacket pkt{};
-            pkt.header = hdr;
-            pkt.entities.resize(hdr.entityCount);
-            if (hdr.entityCount > 0) {
-                std::memcpy(pkt.entities.data(),
-                            buffer.data() + sizeof(SnapshotHeader),
-                            hdr.entityCount * sizeof(SnapshotEntity));
-            }
+    // Le serveur a admis de nouveau ce client (après disconnectClient() ou
+    // l’expiration du slot) : ses séquences repartent de 1 et les états
+    // d’avant ne peuvent plus servir de référence.
+    void beginEpoch(std::uint32_t epoch) {
+        _previousEpoch = _epoch;
+        _epoch = epoch;
+        _history.clear();
+        for (Reassembly& r : _reassembly) {
+            r.sequence = 0;
+        }
+        _latestSequence = 0;
+    }
 
-            latestSnapshot = std::move(pkt);
+    // Range le fragment ; renvoie vrai quand son snapshot est complet, alors
+    // recopié dans _assembled.
+    bool reassemble(const SnapshotFragmentHeader& frag, const char* data, std::size_t size) {
+        Reassembly& r = _reassembly[frag.sequence % SNAPSHOT_REASSEMBLY_SLOTS];
+        if (r.sequence != frag.sequence) {
+            if (r.sequence > frag.sequence) return false;
+            r.sequence = frag.sequence;
+            r.count = frag.fragmentCount;
+            r.received = 0;
+            r.mask = 0;
+            r.fragments.resize(r.count);
+        }
+        const std::uint64_t bit = std::uint64_t{1} << frag.fragmentIndex;
+        if (r.count != frag.fragmentCount || (r.mask & bit)) return false;
+        r.fragments[frag.fragmentIndex].assign(data, data + size);
+        r.mask |= bit;
+        if (++r.received != r.count) return false;
+
+        _assembled.clear();
+        for (std::uint16_t i = 0; i < r.count; ++i) {
+            _assembled.insert(_assembled.end(), r.fragments[i].begin(), r.fragments[i].end());
+        }
+        r.sequence = 0;
+        return true;
+    }
+
+    // Décode _assembled par rapport à sa référence et range l’état obtenu
+    // dans l’historique.
+    bool decodeSnapshot(std::uint32_t sequence, SnapshotHeader& hdr) {
+        if (_assembled.size() < sizeof(SnapshotHeader)) return false;
+        std::memcpy(&hdr, _assembled.data(), sizeof(SnapshotHeader));
+        if (hdr.magic != SNAP_MAGIC || hdr.protocolVersion != PROTOCOL_VERSION || hdr.sequence != sequence ||
+            hdr.epoch != _epoch) {
+            return false;
         }
 
-        return latestSnapshot;
+        static const std::vector<QuantizedEntity> none;
+        const std::vector<QuantizedEntity>* base = hdr.baseline ? _history.find(hdr.baseline) : &none;
+        if (!base) return false;
+
+        ByteReader reader(_assembled.data() + sizeof(SnapshotHeader), _assembled.size() - sizeof(SnapshotHeader));
+        if (!decodeDelta(*base, reader, hdr.entityCount, _decoded) || _decoded.size() > MAX_ENTITIES) return false;
+
+        auto* stored = _history.store(hdr.sequence);
+        if (!stored) return false;
+        stored->swap(_decoded);
+        return true;
     }
 
-private:
     socket_handle _socket{invalid_socket};
     sockaddr_in   _serverAddr{};
+    DatagramReceiver _receiver{SNAPSHOT_DATAGRAM_SIZE};
+    std::array<Reassembly, SNAPSHOT_REASSEMBLY_SLOTS> _reassembly{};
+    std::vector<char> _assembled;
+    // États décodés récents, références des snapshots différentiels
+    SnapshotHistory _history{};
+    std::vector<QuantizedEntity> _decoded;
+    std::uint32_t _latestSequence{0};
+    // Connexion des snapshots de _history et celle qui l’a précédée
+    std::uint32_t _epoch{0};
+    std::uint32_t _previousEpoch{0};
+    // Dernières entrées (file circulaire) et lot en cours d’envoi
+    std::array<InputPacket, INPUT_BATCH_MAX> _recentInputs{};
+    std::size_t _recentNext{0};
+    std::size_t _recentCount{0};
+    std::size_t _inputRedundancy{INPUT_REDUNDANCY};
+    std::array<InputPacket, INPUT_BATCH_MAX> _batchInputs{};
+    std::vector<char> _inputBuffer;
+    std::unique_ptr<IoThread> _io;
+    NetStats _stats{};
 };
 
 } // namespace net
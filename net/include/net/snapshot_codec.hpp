@@ -0,0 +1,530 @@
+// Codage différentiel des snapshots : état d’entité quantifié, écriture
+// d’un snapshot par rapport à une référence (baseline) et reconstruction de
+// l’état complet.  Inclus par net.hpp.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace net {
+
+// Nombre de snapshots conservés par client (côté serveur comme côté client)
+// pour servir de référence.
+inline constexpr std::size_t SNAPSHOT_HISTORY = 32;
+// Les flottants sont transmis en entiers de 1/SNAPSHOT_FLOAT_SCALE unité.
+inline constexpr float SNAPSHOT_FLOAT_SCALE = 64.f;
+
+// Bits de QuantizedEntity::state (indicateurs de SnapshotEntity).
+inline constexpr std::uint8_t STATE_ALIVE        = 1u << 0;
+inline constexpr std::uint8_t STATE_POSITION     = 1u << 1;
+inline constexpr std::uint8_t STATE_VELOCITY     = 1u << 2;
+inline constexpr std::uint8_t STATE_HEALTH       = 1u << 3;
+inline constexpr std::uint8_t STATE_RESPAWNABLE  = 1u << 4;
+inline constexpr std::uint8_t STATE_COLLISION    = 1u << 5;
+
+// Masque des champs modifiés d’un enregistrement d’entité.
+inline constexpr std::uint8_t FIELD_STATE      = 1u << 0;
+inline constexpr std::uint8_t FIELD_GENERATION = 1u << 1;
+inline constexpr std::uint8_t FIELD_POSITION   = 1u << 2;
+inline constexpr std::uint8_t FIELD_VELOCITY   = 1u << 3;
+inline constexpr std::uint8_t FIELD_HEALTH     = 1u << 4;
+inline constexpr std::uint8_t FIELD_HITBOX     = 1u << 5;
+inline constexpr std::uint8_t FIELD_TYPE       = 1u << 6;
+inline constexpr std::uint8_t FIELD_REMOVED    = 1u << 7;
+
+// État d’une entité à la précision du réseau.  Les champs dont l’indicateur
+// est absent valent zéro.
+struct QuantizedEntity {
+    std::uint32_t id{0};
+    std::uint16_t generation{0};
+    std::uint8_t  state{STATE_ALIVE};
+    std::uint16_t type{0};
+    std::uint16_t flags{0};
+    std::int32_t  x{0};
+    std::int32_t  y{0};
+    std::int32_t  vx{0};
+    std::int32_t  vy{0};
+    std::int32_t  health{0};
+    std::int32_t  hitHalfWidth{0};
+    std::int32_t  hitHalfHeight{0};
+
+    bool operator==(const QuantizedEntity&) const = default;
+};
+
+inline std::int32_t quantize(float v) {
+    const float scaled = std::round(v * SNAPSHOT_FLOAT_SCALE);
+    if (!(scaled == scaled)) {
+        return 0;
+    }
+    constexpr float lo = static_cast<float>(std::numeric_limits<std::int32_t>::min());
+    constexpr float hi = 2147483520.f; // plus grand flottant inférieur à 2^31
+    return static_cast<std::int32_t>(std::clamp(scaled, lo, hi));
+}
+
+inline float dequantize(std::int32_t v) {
+    return static_cast<float>(v) / SNAPSHOT_FLOAT_SCALE;
+}
+
+template <typename Entity>
+QuantizedEntity quantize(const Entity& e) {
+    QuantizedEntity q;
+    q.id = e.id;
+    q.generation = e.generation;
+    q.type = e.type;
+    q.flags = e.flags;
+    q.state = static_cast<std::uint8_t>((e.alive ? STATE_ALIVE : 0u) | (e.hasPosition ? STATE_POSITION : 0u) |
+                                        (e.hasVelocity ? STATE_VELOCITY : 0u) | (e.hasHealth ? STATE_HEALTH : 0u) |
+                                        (e.respawnable ? STATE_RESPAWNABLE : 0u) |
+                                        (e.hasCollision ? STATE_COLLISION : 0u));
+    if (e.hasPosition) {
+        q.x = quantize(e.x);
+        q.y = quantize(e.y);
+    }
+    if (e.hasVelocity) {
+        q.vx = quantize(e.vx);
+        q.vy = quantize(e.vy);
+    }
+    if (e.hasHealth) {
+        q.health = quantize(e.health);
+    }
+    if (e.hasCollision) {
+        q.hitHalfWidth = quantize(e.hitHalfWidth);
+        q.hitHalfHeight = quantize(e.hitHalfHeight);
+    }
+    return q;
+}
+
+template <typename Entity>
+Entity dequantize(const QuantizedEntity& q) {
+    Entity e{};
+    e.id = q.id;
+    e.generation = q.generation;
+    e.type = q.type;
+    e.flags = q.flags;
+    e.alive        = (q.state & STATE_ALIVE) ? 1 : 0;
+    e.hasPosition  = (q.state & STATE_POSITION) ? 1 : 0;
+    e.hasVelocity  = (q.state & STATE_VELOCITY) ? 1 : 0;
+    e.hasHealth    = (q.state & STATE_HEALTH) ? 1 : 0;
+    e.respawnable  = (q.state & STATE_RESPAWNABLE) ? 1 : 0;
+    e.hasCollision = (q.state & STATE_COLLISION) ? 1 : 0;
+    e.x = dequantize(q.x);
+    e.y = dequantize(q.y);
+    e.vx = dequantize(q.vx);
+    e.vy = dequantize(q.vy);
+    e.health = dequantize(q.health);
+    e.hitHalfWidth = dequantize(q.hitHalfWidth);
+    e.hitHalfHeight = dequantize(q.hitHalfHeight);
+    return e;
+}
+
+// Trie par identifiant et retire les doublons (le premier est conservé).
+// Une liste déjà triée n’est que parcourue (stable_sort alloue).
+inline void sortById(std::vector<QuantizedEntity>& ents) {
+    const auto byId = [](const QuantizedEntity& a, const QuantizedEntity& b) { return a.id < b.id; };
+    if (!std::is_sorted(ents.begin(), ents.end(), byId)) {
+        std::stable_sort(ents.begin(), ents.end(), byId);
+    }
+    ents.erase(std::unique(ents.begin(), ents.end(),
+                           [](const QuantizedEntity& a, const QuantizedEntity& b) { return a.id == b.id; }),
+               ents.end());
+}
+
+// Différence signée to - from codée en zigzag (petites valeurs absolues sur
+// peu d’octets).
+inline std::uint64_t zigzag(std::int32_t from, std::int32_t to) {
+    const std::int64_t d = static_cast<std::int64_t>(to) - static_cast<std::int64_t>(from);
+    return (static_cast<std::uint64_t>(d) << 1) ^ static_cast<std::uint64_t>(d >> 63);
+}
+
+// Écriture d’entiers à longueur variable (7 bits par octet) dans un tampon.
+class ByteWriter {
+public:
+    explicit ByteWriter(std::vector<char>& out) : _out(out) {}
+
+    void u8(std::uint8_t v) { _out.push_back(static_cast<char>(v)); }
+
+    void varint(std::uint64_t v) {
+        while (v >= 0x80u) {
+            u8(static_cast<std::uint8_t>(v | 0x80u));
+            v >>= 7;
+        }
+        u8(static_cast<std::uint8_t>(v));
+    }
+
+    void delta(std::int32_t from, std::int32_t to) { varint(zigzag(from, to)); }
+
+private:
+    std::vector<char>& _out;
+};
+
+// Même interface que ByteWriter, sans écriture : mesure la taille d’un
+// enregistrement.
+class ByteCounter {
+public:
+    std::size_t size() const { return _size; }
+
+    void u8(std::uint8_t) { ++_size; }
+
+    void varint(std::uint64_t v) {
+        do {
+            ++_size;
+            v >>= 7;
+        } while (v != 0);
+    }
+
+    void delta(std::int32_t from, std::int32_t to) { varint(zigzag(from, to)); }
+
+private:
+    std::size_t _size{0};
+};
+
+// Lecture symétrique de ByteWriter ; ok() devient faux dès qu’une lecture
+// déborde ou qu’un entier est mal formé.
+class ByteReader {
+public:
+    ByteReader(const char* data, std::size_t size) : _data(data), _size(size) {}
+
+    bool ok() const { return _ok; }
+    bool atEnd() const { return _pos == _size; }
+
+    std::uint8_t u8() {
+        if (_pos >= _size) {
+            _ok = false;
+            return 0;
+        }
+        return static_cast<std::uint8_t>(_data[_pos++]);
+    }
+
+    std::uint64_t varint() {
+        std::uint64_t v = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            const std::uint8_t b = u8();
+            v |= static_cast<std::uint64_t>(b & 0x7Fu) << shift;
+            if (!(b & 0x80u)) {
+                return v;
+            }
+        }
+        _ok = false;
+        return 0;
+    }
+
+    std::int32_t delta(std::int32_t from) {
+        const std::uint64_t z = varint();
+        const std::int64_t d = static_cast<std::int64_t>(z >> 1) ^ -static_cast<std::int64_t>(z & 1u);
+        const std::int64_t v = static_cast<std::int64_t>(from) + d;
+        if (v < std::numeric_limits<std::int32_t>::min() || v > std::numeric_limits<std::int32_t>::max()) {
+            _ok = false;
+            return 0;
+        }
+        return static_cast<std::int32_t>(v);
+    }
+
+private:
+    const char* _data;
+    std::size_t _size;
+    std::size_t _pos{0};
+    bool        _ok{true};
+};
+
+// Champs de cur qui diffèrent de base (masque FIELD_*).
+inline std::uint8_t changedFields(const QuantizedEntity& base, const QuantizedEntity& cur) {
+    std::uint8_t mask = 0;
+    if (cur.state != base.state) mask |= FIELD_STATE;
+    if (cur.generation != base.generation) mask |= FIELD_GENERATION;
+    if (cur.x != base.x || cur.y != base.y) mask |= FIELD_POSITION;
+    if (cur.vx != base.vx || cur.vy != base.vy) mask |= FIELD_VELOCITY;
+    if (cur.health != base.health) mask |= FIELD_HEALTH;
+    if (cur.hitHalfWidth != base.hitHalfWidth || cur.hitHalfHeight != base.hitHalfHeight) mask |= FIELD_HITBOX;
+    if (cur.type != base.type || cur.flags != base.flags) mask |= FIELD_TYPE;
+    return mask;
+}
+
+// Enregistrement d’une entité : écart d’identifiant avec l’enregistrement
+// précédent, masque des champs, puis les champs modifiés (écarts zigzag pour
+// les valeurs quantifiées).
+template <typename Writer>
+void writeEntityRecord(Writer& w, std::uint32_t idGap, std::uint8_t mask, const QuantizedEntity& base,
+                       const QuantizedEntity& cur) {
+    w.varint(idGap);
+    w.u8(mask);
+    if (mask & FIELD_STATE) w.u8(cur.state);
+    if (mask & FIELD_GENERATION) w.varint(cur.generation);
+    if (mask & FIELD_POSITION) {
+        w.delta(base.x, cur.x);
+        w.delta(base.y, cur.y);
+    }
+    if (mask & FIELD_VELOCITY) {
+        w.delta(base.vx, cur.vx);
+        w.delta(base.vy, cur.vy);
+    }
+    if (mask & FIELD_HEALTH) w.delta(base.health, cur.health);
+    if (mask & FIELD_HITBOX) {
+        w.delta(base.hitHalfWidth, cur.hitHalfWidth);
+        w.delta(base.hitHalfHeight, cur.hitHalfHeight);
+    }
+    if (mask & FIELD_TYPE) {
+        w.varint(cur.type);
+        w.varint(cur.flags);
+    }
+}
+
+// Appelle fn(from, to, mask) pour chaque entité qui diffère entre base et cur
+// (triés par identifiant), dans l’ordre des identifiants : une nouvelle
+// entité l’est par rapport à l’état par défaut, une entité disparue avec
+// from == to et mask == FIELD_REMOVED.  to désigne un élément de cur ou, pour
+// une suppression, de base.
+template <typename Fn>
+void forEachChange(const std::vector<QuantizedEntity>& base, const std::vector<QuantizedEntity>& cur, Fn&& fn) {
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (i < base.size() || j < cur.size()) {
+        const QuantizedEntity* b = i < base.size() ? &base[i] : nullptr;
+        const QuantizedEntity* c = j < cur.size() ? &cur[j] : nullptr;
+        std::uint8_t mask = 0;
+        QuantizedEntity fresh;
+        const QuantizedEntity* from = nullptr;
+        const QuantizedEntity* to = nullptr;
+        if (c && (!b || c->id < b->id)) {
+            // Nouvelle entité
+            fresh.id = c->id;
+            from = &fresh;
+            to = c;
+            mask = changedFields(fresh, *c);
+            ++j;
+        } else if (b && (!c || b->id < c->id)) {
+            // Entité disparue
+            from = b;
+            to = b;
+            mask = FIELD_REMOVED;
+            ++i;
+        } else {
+            from = b;
+            to = c;
+            mask = changedFields(*b, *c);
+            ++i;
+            ++j;
+            if (mask == 0) {
+                continue;
+            }
+        }
+        fn(*from, *to, mask);
+    }
+}
+
+// Écrit cur (trié par identifiant) par rapport à base (trié, éventuellement
+// vide) : une entité inchangée n’est pas écrite, une entité disparue l’est
+// avec FIELD_REMOVED, une nouvelle entité est écrite par rapport à l’état
+// par défaut.  Renvoie le nombre d’enregistrements.
+inline std::uint32_t encodeDelta(const std::vector<QuantizedEntity>& base, const std::vector<QuantizedEntity>& cur,
+                                 std::vector<char>& out) {
+    ByteWriter w(out);
+    std::uint32_t records = 0;
+    std::uint32_t prevId = 0;
+    forEachChange(base, cur, [&](const QuantizedEntity& from, const QuantizedEntity& to, std::uint8_t mask) {
+        writeEntityRecord(w, to.id - prevId, mask, from, to);
+        prevId = to.id;
+        ++records;
+    });
+    return records;
+}
+
+// Sélection des modifications à transmettre sous un budget d’octets.  Quand
+// le codage complet de cur par rapport à base le dépasse, seules les
+// modifications de plus forte priorité sont retenues ; les autres sont
+// reportées : l’état transmis (sent) garde pour ces entités leur valeur de
+// base, si bien qu’elles restent des modifications au snapshot suivant.
+class SnapshotPacker {
+public:
+    // priority(to, mask) -> float, avec les paramètres de forEachChange.
+    // Renvoie l’état à coder par rapport à base : cur lui-même si tout tient
+    // dans budget, sinon un état intermédiaire dont le codage le respecte.
+    template <typename Priority>
+    const std::vector<QuantizedEntity>& pack(const std::vector<QuantizedEntity>& base,
+                                             const std::vector<QuantizedEntity>& cur, std::size_t budget,
+                                             Priority&& priority) {
+        _changes.clear();
+        _deferred.clear();
+        std::size_t total = 0;
+        forEachChange(base, cur, [&](const QuantizedEntity& from, const QuantizedEntity& to, std::uint8_t mask) {
+            // L’écart d’identifiant est majoré par l’identifiant lui-même :
+            // la taille reste valable quel que soit le sous-ensemble retenu.
+            ByteCounter n;
+            writeEntityRecord(n, to.id, mask, from, to);
+            _changes.push_back(Change{&to, mask, n.size(), 0.f, false});
+            total += n.size();
+        });
+        if (total <= budget) {
+            return cur;
+        }
+
+        for (Change& c : _changes) {
+            c.priority = priority(*c.to, c.mask);
+            if (std::isnan(c.priority)) {
+                c.priority = 0.f;
+            }
+        }
+        // À priorité égale, par identifiant (std::sort, contrairement à
+        // stable_sort, n’alloue pas)
+        std::sort(_changes.begin(), _changes.end(), [](const Change& a, const Change& b) {
+            return a.priority != b.priority ? a.priority > b.priority : a.to->id < b.to->id;
+        });
+        std::size_t used = 0;
+        for (Change& c : _changes) {
+            if (used + c.bytes <= budget) {
+                used += c.bytes;
+                c.kept = true;
+            }
+        }
+        std::sort(_changes.begin(), _changes.end(),
+                  [](const Change& a, const Change& b) { return a.to->id < b.to->id; });
+
+        // Fusion de base, cur et des modifications (tous triés par identifiant)
+        _sent.clear();
+        std::size_t i = 0;
+        std::size_t j = 0;
+        for (const Change& c : _changes) {
+            const std::uint32_t id = c.to->id;
+            while (j < cur.size() && cur[j].id < id) {
+                _sent.push_back(cur[j++]);
+            }
+            while (i < base.size() && base[i].id < id) {
+                ++i;
+            }
+            const bool inBase = i < base.size() && base[i].id == id;
+            const bool inCur = j < cur.size() && cur[j].id == id;
+            if (c.kept ? inCur : inBase) {
+                _sent.push_back(c.kept ? cur[j] : base[i]);
+            }
+            if (!c.kept) {
+                _deferred.push_back(id);
+            }
+            i += inBase;
+            j += inCur;
+        }
+        while (j < cur.size()) {
+            _sent.push_back(cur[j++]);
+        }
+        return _sent;
+    }
+
+    // Identifiants (triés) des entités reportées par le dernier pack().
+    const std::vector<std::uint32_t>& deferred() const { return _deferred; }
+
+private:
+    struct Change {
+        const QuantizedEntity* to;
+        std::uint8_t           mask;
+        std::size_t            bytes;
+        float                  priority;
+        bool                   kept;
+    };
+
+    std::vector<Change>          _changes;
+    std::vector<QuantizedEntity> _sent;
+    std::vector<std::uint32_t>   _deferred;
+};
+
+// Applique records enregistrements lus dans r à base (trié) et écrit l’état
+// complet, trié, dans out.  Renvoie faux si les données sont invalides.
+inline bool decodeDelta(const std::vector<QuantizedEntity>& base, ByteReader& r, std::uint32_t records,
+                        std::vector<QuantizedEntity>& out) {
+    out.clear();
+    std::size_t i = 0;
+    std::uint32_t prevId = 0;
+    for (std::uint32_t n = 0; n < records; ++n) {
+        const std::uint64_t gap = r.varint();
+        if (!r.ok() || (n > 0 && gap == 0) || gap > std::numeric_limits<std::uint32_t>::max() - prevId) {
+            return false;
+        }
+        const std::uint32_t id = prevId + static_cast<std::uint32_t>(gap);
+        prevId = id;
+        // Entités de la référence non mentionnées : inchangées
+        while (i < base.size() && base[i].id < id) {
+            out.push_back(base[i++]);
+        }
+        QuantizedEntity cur;
+        cur.id = id;
+        const bool known = i < base.size() && base[i].id == id;
+        if (known) {
+            cur = base[i++];
+        }
+        const std::uint8_t mask = r.u8();
+        if (mask & FIELD_REMOVED) {
+            if (!known || mask != FIELD_REMOVED) {
+                return false;
+            }
+            continue;
+        }
+        const QuantizedEntity from = cur;
+        if (mask & FIELD_STATE) cur.state = r.u8();
+        if (mask & FIELD_GENERATION) cur.generation = static_cast<std::uint16_t>(r.varint());
+        if (mask & FIELD_POSITION) {
+            cur.x = r.delta(from.x);
+            cur.y = r.delta(from.y);
+        }
+        if (mask & FIELD_VELOCITY) {
+            cur.vx = r.delta(from.vx);
+            cur.vy = r.delta(from.vy);
+        }
+        if (mask & FIELD_HEALTH) cur.health = r.delta(from.health);
+        if (mask & FIELD_HITBOX) {
+            cur.hitHalfWidth = r.delta(from.hitHalfWidth);
+            cur.hitHalfHeight = r.delta(from.hitHalfHeight);
+        }
+        if (mask & FIELD_TYPE) {
+            cur.type = static_cast<std::uint16_t>(r.varint());
+            cur.flags = static_cast<std::uint16_t>(r.varint());
+        }
+        if (!r.ok()) {
+            return false;
+        }
+        out.push_back(cur);
+    }
+    while (i < base.size()) {
+        out.push_back(base[i++]);
+    }
+    return r.ok() && r.atEnd();
+}
+
+// Derniers snapshots (états quantifiés triés) indexés par numéro de
+// séquence ; le numéro 0 n’est jamais utilisé.
+class SnapshotHistory {
+public:
+    void clear() {
+        for (auto& e : _entries) {
+            e.sequence = 0;
+            e.entities.clear();
+        }
+    }
+
+    // Emplacement du snapshot sequence, à remplir par l’appelant ; nul si
+    // l’emplacement contient un snapshot plus récent.
+    std::vector<QuantizedEntity>* store(std::uint32_t sequence) {
+        Entry& e = _entries[sequence % SNAPSHOT_HISTORY];
+        if (e.sequence > sequence) {
+            return nullptr;
+        }
+        e.sequence = sequence;
+        return &e.entities;
+    }
+
+    const std::vector<QuantizedEntity>* find(std::uint32_t sequence) const {
+        const Entry& e = _entries[sequence % SNAPSHOT_HISTORY];
+        return (sequence != 0 && e.sequence == sequence) ? &e.entities : nullptr;
+    }
+
+private:
+    struct Entry {
+        std::uint32_t sequence{0};
+        std::vector<QuantizedEntity> entities;
+    };
+    std::array<Entry, SNAPSHOT_HISTORY> _entries{};
+};
+
+} // namespace net
@@ -0,0 +1,337 @@
+// Couche socket : abstraction POSIX / Winsock, attente de lisibilité et
+// envoi et réception de datagrammes par lots.  Inclus par net.hpp.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #pragma comment(lib, "ws2_32.lib")
+#else
+    #include <arpa/inet.h>
+    #include <fcntl.h>
+    #include <netinet/in.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+    #ifdef __linux__
+        #include <sys/eventfd.h>
+    #endif
+#endif
+
+// sendmmsg() et recvmmsg() (Linux, déclarés avec _GNU_SOURCE)
+#if defined(__linux__) && defined(_GNU_SOURCE)
+    #define NET_HAS_MMSG 1
+#endif
+
+namespace net {
+
+#ifdef _WIN32
+    using socket_handle = SOCKET;
+    using socklen_type  = int;
+    using recv_len      = int;
+    static constexpr socket_handle invalid_socket = INVALID_SOCKET;
+
+    struct WSAInit {
+        WSAInit() {
+            WSADATA wsaData;
+            WSAStartup(MAKEWORD(2, 2), &wsaData);
+        }
+        ~WSAInit() {
+            WSACleanup();
+        }
+    };
+#else
+    using socket_handle = int;
+    using socklen_type  = socklen_t;
+    using recv_len      = ssize_t;
+    static constexpr socket_handle invalid_socket = -1;
+#endif
+
+inline void socket_close(socket_handle s) {
+#ifdef _WIN32
+    if (s != invalid_socket) closesocket(s);
+#else
+    if (s != invalid_socket) ::close(s);
+#endif
+}
+
+inline void socket_set_nonblocking(socket_handle s) {
+#ifdef _WIN32
+    u_long mode = 1;
+    ioctlsocket(s, FIONBIO, &mode);
+#else
+    int flags = fcntl(s, F_GETFL, 0);
+    if (flags >= 0) {
+        fcntl(s, F_SETFL, flags | O_NONBLOCK);
+    }
+#endif
+}
+
+// Attend au plus timeout que s soit lisible ; renvoie vrai s’il l’est.
+inline bool socket_wait_readable(socket_handle s, std::chrono::milliseconds timeout) {
+#ifdef _WIN32
+    WSAPOLLFD fd{};
+    fd.fd = s;
+    fd.events = POLLRDNORM;
+    return ::WSAPoll(&fd, 1, static_cast<INT>(timeout.count())) > 0;
+#else
+    pollfd fd{};
+    fd.fd = s;
+    fd.events = POLLIN;
+    return ::poll(&fd, 1, static_cast<int>(timeout.count())) > 0;
+#endif
+}
+
+// Réveil d’un thread bloqué dans socket_wait_readable() : un descripteur
+// que signal() rend lisible et que clear() vide.  eventfd sous Linux, tube
+// ailleurs sous POSIX, socket UDP reliée à elle-même sous Windows (WSAPoll()
+// n’attend que des sockets).  Lève std::runtime_error si sa création échoue.
+class SocketWakeup {
+public:
+    SocketWakeup() {
+#ifdef _WIN32
+        _read = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_type len = sizeof(addr);
+        if (_read == invalid_socket || ::bind(_read, reinterpret_cast<sockaddr*>(&addr), len) != 0 ||
+            ::getsockname(_read, reinterpret_cast<sockaddr*>(&addr), &len) != 0 ||
+            ::connect(_read, reinterpret_cast<sockaddr*>(&addr), len) != 0) {
+            socket_close(_read);
+            throw std::runtime_error("Failed to create wakeup socket");
+        }
+        socket_set_nonblocking(_read);
+        _write = _read;
+#elif defined(__linux__)
+        _read = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_read < 0) throw std::runtime_error("Failed to create wakeup eventfd");
+        _write = _read;
+#else
+        int fds[2];
+        if (::pipe(fds) != 0) throw std::runtime_error("Failed to create wakeup pipe");
+        _read = fds[0];
+        _write = fds[1];
+        socket_set_nonblocking(_read);
+        socket_set_nonblocking(_write);
+#endif
+    }
+
+    SocketWakeup(const SocketWakeup&) = delete;
+    SocketWakeup& operator=(const SocketWakeup&) = delete;
+
+    ~SocketWakeup() {
+        if (_write != _read) socket_close(_write);
+        socket_close(_read);
+    }
+
+    // Descripteur à attendre en lecture.
+    socket_handle handle() const { return _read; }
+
+    // Rend handle() lisible ; un signal déjà en attente suffit (échec ignoré).
+    void signal() {
+#ifdef _WIN32
+        const char byte = 0;
+        ::send(_write, &byte, 1, 0);
+#elif defined(__linux__)
+        const std::uint64_t one = 1;
+        [[maybe_unused]] ssize_t n = ::write(_write, &one, sizeof(one));
+#else
+        const char byte = 0;
+        [[maybe_unused]] ssize_t n = ::write(_write, &byte, 1);
+#endif
+    }
+
+    // Consomme les signaux en attente.
+    void clear() {
+#ifdef _WIN32
+        char buf[16];
+        while (::recv(_read, buf, sizeof(buf), 0) > 0) {
+        }
+#elif defined(__linux__)
+        std::uint64_t count;
+        [[maybe_unused]] ssize_t n = ::read(_read, &count, sizeof(count));
+#else
+        char buf[64];
+        while (::read(_read, buf, sizeof(buf)) > 0) {
+        }
+#endif
+    }
+
+private:
+    socket_handle _read{invalid_socket};
+    socket_handle _write{invalid_socket};
+};
+
+// Attend au plus timeout que s soit lisible ou que wakeup soit signalé ;
+// renvoie vrai si s est lisible.
+inline bool socket_wait_readable(socket_handle s, const SocketWakeup& wakeup, std::chrono::milliseconds timeout) {
+#ifdef _WIN32
+    WSAPOLLFD fds[2]{};
+    fds[0].fd = s;
+    fds[0].events = POLLRDNORM;
+    fds[1].fd = wakeup.handle();
+    fds[1].events = POLLRDNORM;
+    return ::WSAPoll(fds, 2, static_cast<INT>(timeout.count())) > 0 && (fds[0].revents & POLLRDNORM) != 0;
+#else
+    pollfd fds[2]{};
+    fds[0].fd = s;
+    fds[0].events = POLLIN;
+    fds[1].fd = wakeup.handle();
+    fds[1].events = POLLIN;
+    return ::poll(fds, 2, static_cast<int>(timeout.count())) > 0 && (fds[0].revents & POLLIN) != 0;
+#endif
+}
+
+// Nombre maximal de datagrammes envoyés ou reçus par appel système.
+inline constexpr std::size_t DATAGRAM_BATCH_SIZE = 64;
+
+// File d’envoi de datagrammes.  Les tampons sont conservés d’un flush() à
+// l’autre : une fois leur capacité atteinte, remplir et vider la file
+// n’alloue plus.  flush() envoie DATAGRAM_BATCH_SIZE datagrammes par appel
+// sendmmsg() sous Linux, un sendto() par datagramme ailleurs.
+class DatagramQueue {
+public:
+    // Tampon vide, à remplir, envoyé à addr au prochain flush().
+    std::vector<char>& push(const sockaddr_in& addr) {
+        if (_count == _datagrams.size()) {
+            _datagrams.emplace_back();
+        }
+        Datagram& d = _datagrams[_count++];
+        d.addr = addr;
+        d.bytes.clear();
+        return d.bytes;
+    }
+
+    std::size_t size() const { return _count; }
+    const sockaddr_in& addr(std::size_t i) const { return _datagrams[i].addr; }
+    const std::vector<char>& bytes(std::size_t i) const { return _datagrams[i].bytes; }
+
+    // Vide la file sans rien envoyer.
+    void clear() { _count = 0; }
+
+    // Envoie les datagrammes en file et la vide.  Comme pour sendto(), un
+    // datagramme refusé par le système (file pleine) est perdu.
+    void flush(socket_handle s) {
+#if defined(NET_HAS_MMSG)
+        _headers.resize(_count);
+        _iov.resize(_count);
+        for (std::size_t i = 0; i < _count; ++i) {
+            Datagram& d = _datagrams[i];
+            _iov[i].iov_base = d.bytes.data();
+            _iov[i].iov_len = d.bytes.size();
+            _headers[i] = mmsghdr{};
+            _headers[i].msg_hdr.msg_name = &d.addr;
+            _headers[i].msg_hdr.msg_namelen = sizeof(d.addr);
+            _headers[i].msg_hdr.msg_iov = &_iov[i];
+            _headers[i].msg_hdr.msg_iovlen = 1;
+        }
+        std::size_t sent = 0;
+        while (sent < _count) {
+            const std::size_t batch = std::min(DATAGRAM_BATCH_SIZE, _count - sent);
+            const int n = ::sendmmsg(s, _headers.data() + sent, static_cast<unsigned>(batch), 0);
+            if (n <= 0) break;
+            sent += static_cast<std::size_t>(n);
+        }
+#else
+        for (std::size_t i = 0; i < _count; ++i) {
+            Datagram& d = _datagrams[i];
+            ::sendto(s, d.bytes.data(), static_cast<int>(d.bytes.size()), 0,
+                     reinterpret_cast<sockaddr*>(&d.addr), sizeof(d.addr));
+        }
+#endif
+        _count = 0;
+    }
+
+private:
+    struct Datagram {
+        sockaddr_in addr{};
+        std::vector<char> bytes;
+    };
+
+    std::vector<Datagram> _datagrams;
+    std::size_t _count{0};
+#if defined(NET_HAS_MMSG)
+    std::vector<mmsghdr> _headers;
+    std::vector<iovec> _iov;
+#endif
+};
+
+// Réception par lots dans des tampons préalloués de datagramSize octets :
+// un appel recvmmsg() sous Linux, des recvfrom() successifs ailleurs.  Sous
+// Linux, un datagramme plus grand que datagramSize est reçu avec une taille
+// nulle.
+class DatagramReceiver {
+public:
+    explicit DatagramReceiver(std::size_t datagramSize) { resize(datagramSize); }
+
+    void resize(std::size_t datagramSize) {
+        _datagramSize = datagramSize;
+        _storage.assign(DATAGRAM_BATCH_SIZE * datagramSize, 0);
+    }
+
+    std::size_t datagramSize() const { return _datagramSize; }
+
+    // Reçoit au plus DATAGRAM_BATCH_SIZE datagrammes sans bloquer ; renvoie
+    // leur nombre (0 si aucun n’est en attente).
+    std::size_t receive(socket_handle s) {
+#if defined(NET_HAS_MMSG)
+        for (std::size_t i = 0; i < DATAGRAM_BATCH_SIZE; ++i) {
+            _iov[i].iov_base = _storage.data() + i * _datagramSize;
+            _iov[i].iov_len = _datagramSize;
+            _headers[i] = mmsghdr{};
+            _headers[i].msg_hdr.msg_name = &_senders[i];
+            _headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            _headers[i].msg_hdr.msg_iov = &_iov[i];
+            _headers[i].msg_hdr.msg_iovlen = 1;
+        }
+        const int n = ::recvmmsg(s, _headers.data(), static_cast<unsigned>(DATAGRAM_BATCH_SIZE), MSG_DONTWAIT, nullptr);
+        if (n <= 0) return 0;
+        for (int i = 0; i < n; ++i) {
+            _sizes[i] = (_headers[i].msg_hdr.msg_flags & MSG_TRUNC) ? 0 : _headers[i].msg_len;
+        }
+        return static_cast<std::size_t>(n);
+#else
+        std::size_t count = 0;
+        while (count < DATAGRAM_BATCH_SIZE) {
+            socklen_type senderLen = sizeof(sockaddr_in);
+            recv_len n = ::recvfrom(s, _storage.data() + count * _datagramSize, static_cast<int>(_datagramSize), 0,
+                                    reinterpret_cast<sockaddr*>(&_senders[count]), &senderLen);
+            if (n <= 0) break;
+            _sizes[count++] = static_cast<std::size_t>(n);
+        }
+        return count;
+#endif
+    }
+
+    const char* data(std::size_t i) const { return _storage.data() + i * _datagramSize; }
+    std::size_t size(std::size_t i) const { return _sizes[i]; }
+    const sockaddr_in& sender(std::size_t i) const { return _senders[i]; }
+
+private:
+    std::size_t _datagramSize{0};
+    std::vector<char> _storage;
+    std::array<std::size_t, DATAGRAM_BATCH_SIZE> _sizes{};
+    std::array<sockaddr_in, DATAGRAM_BATCH_SIZE> _senders{};
+#if defined(NET_HAS_MMSG)
+    std::array<mmsghdr, DATAGRAM_BATCH_SIZE> _headers{};
+    std::array<iovec, DATAGRAM_BATCH_SIZE> _iov{};
+#endif
+};
+
+} // namespace net
@@ -0,0 +1,77 @@
+// File circulaire sans verrou à un producteur et un consommateur.  Les
+// éléments sont préalloués et réutilisés : le producteur remplit en place
+// l’emplacement renvoyé par beginPush() puis le publie, le consommateur lit
+// en place celui renvoyé par beginPop() puis le libère.  Un élément qui
+// possède de la mémoire (std::vector…) la garde d’un passage à l’autre.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace net {
+
+// Taille de ligne de cache supposée, pour séparer les indices de SpscRing.
+inline constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+template <typename T>
+class SpscRing {
+public:
+    // La capacité est arrondie à la puissance de deux supérieure.
+    explicit SpscRing(std::size_t capacity) {
+        std::size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _slots.resize(size);
+        _mask = size - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    std::size_t capacity() const { return _slots.size(); }
+
+    // Producteur : emplacement libre, ou nullptr si la file est pleine.
+    T* beginPush() {
+        const std::size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _headCache == _slots.size()) {
+            _headCache = _head.load(std::memory_order_acquire);
+            if (tail - _headCache == _slots.size()) {
+                return nullptr;
+            }
+        }
+        return &_slots[tail & _mask];
+    }
+
+    // Producteur : publie l’emplacement renvoyé par beginPush().
+    void commitPush() { _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // Consommateur : élément le plus ancien, ou nullptr si la file est vide.
+    T* beginPop() {
+        const std::size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tailCache) {
+            _tailCache = _tail.load(std::memory_order_acquire);
+            if (head == _tailCache) {
+                return nullptr;
+            }
+        }
+        return &_slots[head & _mask];
+    }
+
+    // Consommateur : rend au producteur l’élément renvoyé par beginPop().
+    void commitPop() { _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+private:
+    // Indices sur des lignes de cache distinctes : chacun n’est écrit que par
+    // un côté, qui garde en cache la dernière valeur lue de l’autre.
+    std::vector<T> _slots;
+    std::size_t    _mask{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _head{0};
+    std::size_t _tailCache{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _tail{0};
+    std::size_t _headCache{0};
+};
+
+} // namespace net
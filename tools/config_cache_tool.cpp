@@ -0,0 +1,61 @@
+// Précompile une configuration Lua en cache binaire (engine/config_cache.hpp).
+// Exécuté à la construction ou au déploiement, il fournit aux processus de
+// match un fichier à jour qu’ils relisent sans démarrer Lua, au lieu de le
+// régénérer chacun à son premier démarrage.
+//
+//     config_cache_tool <script.lua> <cache.cfgbin>          écrit le cache
+//     config_cache_tool --check <script.lua> <cache.cfgbin>  vérifie le cache
+//
+// Codes de retour : 0 en cas de succès (ou cache à jour), 1 si le cache est
+// absent ou périmé (--check), 2 pour une erreur d’utilisation, 3 si le script
+// ou l’écriture échoue.
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "engine/config_cache.hpp"
+
+namespace {
+
+int usage(const char* program) {
+    std::cerr << "usage: " << program << " [--check] <script.lua> <cache.cfgbin>\n";
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool check = false;
+    int first = 1;
+    if (argc > 1 && std::string_view(argv[1]) == "--check") {
+        check = true;
+        first = 2;
+    }
+    if (argc - first != 2) {
+        return usage(argv[0]);
+    }
+    const std::string luaPath = argv[first];
+    const std::string cachePath = argv[first + 1];
+    try {
+        const std::uint64_t sourceHash = engine::hashGameConfigSource(luaPath);
+        if (check) {
+            if (engine::loadGameConfigCache(cachePath, sourceHash)) {
+                std::cout << cachePath << ": up to date\n";
+                return 0;
+            }
+            std::cout << cachePath << ": missing or out of date\n";
+            return 1;
+        }
+        const engine::GameConfig cfg = engine::loadGameConfig(luaPath);
+        engine::saveGameConfigCache(cfg, sourceHash, cachePath);
+        std::cout << cachePath << ": " << cfg.archetypes.size() << " archetypes, " << cfg.weapons.size()
+                  << " weapons, " << cfg.projectiles.size() << " projectiles\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "config_cache_tool: " << e.what() << '\n';
+        return 3;
+    }
+}